@@ -0,0 +1,849 @@
+#include "Benchmark.h"
+
+template<typename T>
+BasicNeuralNetwork<T> Benchmark::build_and_train(const bench_config &config, basic_x_y_matrix<T> &training_data, uint32_t data_parallel_shards) {
+    /* Same construction as the visualization does (layers get their activation functions after creation) */
+    BasicNeuralNetwork<T> nn(NUMBER_OF_INPUTS, training_data.second.get_cols(), config.hidden_layers_sizes, config.softmax_output);
+    for (uint32_t i = 0; i < config.activation_functions.size(); i++)
+        nn.get_layers()[i + 1]->set_activation_function(config.activation_functions[i]);
+    nn.set_data_parallel_shards(data_parallel_shards);
+
+    nn.train(training_data, config.epochs, config.learning_rate, config.batch_size, false, config.min_loss);
+    return nn;
+}
+
+template<typename T>
+bench_result Benchmark::train_and_test(const bench_config &config, const x_y_pairs &train_data, const x_y_pairs &test_data) {
+    auto training_data = DataLoader::transform_to_matrices<T>(train_data);
+    auto testing_data = DataLoader::transform_to_matrices<T>(test_data);
+
+    auto start = std::chrono::steady_clock::now();
+    auto nn = build_and_train<T>(config, training_data);
+    auto end = std::chrono::steady_clock::now();
+
+    bench_result result{};
+    auto training_error = nn.get_training_error();
+    result.epochs = training_error.get_rows();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.samples_per_second = static_cast<double>(result.epochs) * train_data.size() / result.seconds;
+    result.final_loss = training_error.get_value(result.epochs - 1, 0);
+    result.accuracy = nn.test(testing_data);
+    result.workspace_bytes = nn.get_workspace().get_high_water_mark_bytes();
+    return result;
+}
+
+std::vector<bench_config> Benchmark::get_default_configs() {
+    return {
+            {"tren_data1___23.txt", {8}, {act_func_type::relu, act_func_type::linear}, true, 0.1, 50, 65, 0.01},
+            {"tren_data2___23.txt", {16, 8}, {act_func_type::relu, act_func_type::relu, act_func_type::linear}, true, 0.02, 50, 200, 0.},
+            {"spiral.txt", {16, 12}, {act_func_type::relu, act_func_type::tanh, act_func_type::linear}, true, 0.07, 50, 200, 0.},
+            {"moons.txt", {16, 12}, {act_func_type::relu, act_func_type::tanh, act_func_type::linear}, true, 0.07, 50, 198, 0.01},
+            {"circle.txt", {16, 8}, {act_func_type::relu, act_func_type::tanh, act_func_type::linear}, true, 0.1, 50, 30, 0.},
+    };
+}
+
+bench_config Benchmark::get_wide_config() {
+    return {"spiral.txt", {128, 128}, {act_func_type::relu, act_func_type::relu, act_func_type::linear}, true, 0.05, 50, 60, 0.01};
+}
+
+std::pair<x_y_pairs, x_y_pairs> Benchmark::load_split(const std::string &data_filepath) {
+    auto data = DataLoader::load_file(data_filepath, NUMBER_OF_INPUTS, 1, ' ');
+    if (data.empty())
+        throw std::runtime_error("Benchmark error: no data loaded from " + data_filepath);
+    data = DataLoader::transform_y_to_one_hot(data);
+    return DataLoader::split_data(data, DATA_SPLIT_RATIO);
+}
+
+void Benchmark::run_precision(const std::vector<bench_config> &configs, const std::string &data_directory, uint32_t repeats) {
+    std::cout << "Precision benchmark (float vs double), " << repeats << " run(s) per configuration, SIMD level: "
+              << Simd::get_level_name(Simd::get_level()) << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(8) << "type" << std::setw(8) << "epochs"
+              << std::setw(14) << "samples/s" << std::setw(12) << "loss" << std::setw(10) << "accuracy" << std::setw(12) << "workspace" << std::endl;
+
+    for (auto &config : configs) {
+        auto data = load_split(data_directory + "/" + config.data_filename); /* Same split for both precisions */
+
+        bench_result results[2] = {};
+        for (uint32_t r = 0; r < repeats; r++) {
+            bench_result runs[2] = {train_and_test<float>(config, data.first, data.second),
+                                    train_and_test<double>(config, data.first, data.second)};
+            for (int p = 0; p < 2; p++) {
+                results[p].epochs += runs[p].epochs;
+                results[p].seconds += runs[p].seconds;
+                results[p].samples_per_second += runs[p].samples_per_second / repeats;
+                results[p].final_loss += runs[p].final_loss / repeats;
+                results[p].accuracy += runs[p].accuracy / repeats;
+                results[p].workspace_bytes = std::max(results[p].workspace_bytes, runs[p].workspace_bytes);
+            }
+        }
+
+        const char *names[2] = {"float", "double"};
+        for (int p = 0; p < 2; p++)
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(8) << names[p]
+                      << std::setw(8) << results[p].epochs / repeats << std::setw(14) << std::fixed << std::setprecision(0)
+                      << results[p].samples_per_second << std::setw(12) << std::setprecision(4) << results[p].final_loss
+                      << std::setw(10) << results[p].accuracy << std::defaultfloat
+                      << results[p].workspace_bytes / 1024.0 << " KiB" << std::endl;
+        std::cout << "    float speedup: " << std::fixed << std::setprecision(2)
+                  << results[0].samples_per_second / results[1].samples_per_second << "x" << std::defaultfloat << std::endl;
+    }
+}
+
+template<uint32_t... Sizes>
+void Benchmark::run_fixed_config(const bench_config &config, const std::string &data_directory) {
+    auto data = load_split(data_directory + "/" + config.data_filename);
+    auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+    auto testing_data = DataLoader::transform_to_matrices<double>(data.second);
+    auto nn = build_and_train<double>(config, training_data);
+    FixedNeuralNetwork<double, Sizes...> fixed(nn);
+
+    /* Both networks have to give the same outputs (up to rounding) */
+    double max_difference = 0;
+    for (uint32_t i = 0; i < testing_data.first.get_rows(); i++) {
+        auto dynamic_output = nn.predict(testing_data.first.get_row_view(i));
+        auto fixed_output = fixed.predict(testing_data.first.get_row_view(i));
+        for (uint32_t j = 0; j < dynamic_output.get_rows(); j++)
+            max_difference = std::max(max_difference, std::abs(dynamic_output.get_value(j, 0) - fixed_output.get_value(j, 0)));
+    }
+
+    /* Time the same number of inferences, the argmax is accumulated so nothing can be optimized away */
+    uint64_t checksum = 0;
+    const uint32_t samples = testing_data.first.get_rows();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < FIXED_INFERENCES; i++)
+        checksum += nn.predict(testing_data.first.get_row_view(i % samples)).argmax();
+    auto middle = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < FIXED_INFERENCES; i++)
+        checksum -= fixed.predict(testing_data.first.get_row_view(i % samples)).argmax();
+    auto end = std::chrono::steady_clock::now();
+
+    const double dynamic_rate = FIXED_INFERENCES / std::chrono::duration<double>(middle - start).count();
+    const double fixed_rate = FIXED_INFERENCES / std::chrono::duration<double>(end - middle).count();
+    std::cout << std::left << std::setw(22) << config.data_filename << std::setw(16) << std::fixed << std::setprecision(0)
+              << dynamic_rate << std::setw(16) << fixed_rate << std::setw(10) << std::setprecision(2) << fixed_rate / dynamic_rate
+              << std::setw(14) << std::scientific << std::setprecision(1) << max_difference << std::defaultfloat
+              << (checksum == 0 ? "same" : "DIFFERENT") << std::endl;
+}
+
+void Benchmark::run_fixed(const std::string &data_directory) {
+    std::cout << "Fixed benchmark (dynamic vs compile-time network inference, double), " << FIXED_INFERENCES
+              << " inferences per network" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(16) << "dynamic inf/s" << std::setw(16) << "fixed inf/s"
+              << std::setw(10) << "speedup" << std::setw(14) << "max |diff|" << "argmax" << std::endl;
+
+    /* Topologies have to be known at compile time, they follow the default configurations (inputs, hidden, classes) */
+    auto configs = get_default_configs();
+    run_fixed_config<2, 8, 5>(configs[0], data_directory);
+    run_fixed_config<2, 16, 8, 5>(configs[1], data_directory);
+    run_fixed_config<2, 16, 12, 3>(configs[2], data_directory);
+    run_fixed_config<2, 16, 12, 2>(configs[3], data_directory);
+    run_fixed_config<2, 16, 8, 2>(configs[4], data_directory);
+}
+
+template<typename N>
+double Benchmark::measure_inference(N &nn, const Matrix &inputs, uint32_t count) {
+    /* The argmax is accumulated so nothing can be optimized away */
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++)
+        checksum += nn.predict(inputs.get_row_view(i % inputs.get_rows())).argmax();
+    auto end = std::chrono::steady_clock::now();
+    if (checksum == std::numeric_limits<uint64_t>::max())
+        std::cout << std::endl;
+    return count / std::chrono::duration<double>(end - start).count();
+}
+
+void Benchmark::run_sparse(const std::string &data_directory) {
+    auto configs = get_default_configs();
+    configs.push_back(get_wide_config()); /* Bundled networks are small enough for the dense kernels to win at any sparsity */
+
+    std::cout << "Sparse benchmark (magnitude pruning, top-k per layer, double), " << SPARSE_INFERENCES
+              << " inferences per network and level" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(12) << "hidden" << std::setw(10) << "sparsity"
+              << std::setw(10) << "density" << std::setw(14) << "dense inf/s" << std::setw(14) << "sparse inf/s"
+              << std::setw(10) << "speedup" << std::setw(10) << "accuracy" << "delta" << std::endl;
+
+    for (const auto &config : configs) {
+        auto data = load_split(data_directory + "/" + config.data_filename);
+        auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+        auto testing_data = DataLoader::transform_to_matrices<double>(data.second);
+        auto nn = build_and_train<double>(config, training_data);
+
+        std::string hidden;
+        for (auto size : config.hidden_layers_sizes)
+            hidden += (hidden.empty() ? "" : "x") + std::to_string(size);
+
+        /* Trained weights are restored before each level, so every level prunes the same network */
+        const auto &layers = nn.get_layers();
+        const auto trained_parameters = nn.get_parameters();
+
+        double dense_accuracy = 0;
+        for (double sparsity : SPARSE_LEVELS) {
+            nn.set_parameters(trained_parameters);
+            nn.prune_keep_top(1 - sparsity);
+
+            size_t non_zeros = 0, elements = 0;
+            for (uint32_t i = 1; i < layers.size(); i++) {
+                non_zeros += layers[i]->get_sparse_weights().get_non_zeros();
+                elements += static_cast<size_t>(layers[i]->get_size()) * (layers[i - 1]->get_size() + 1);
+            }
+
+            nn.set_sparse_density_cutoff(0); /* Force the dense path */
+            const double dense_rate = measure_inference(nn, testing_data.first, SPARSE_INFERENCES);
+            nn.set_sparse_density_cutoff(1.1); /* Force the sparse path */
+            const double sparse_rate = measure_inference(nn, testing_data.first, SPARSE_INFERENCES);
+            const double accuracy = nn.test(testing_data);
+            nn.set_sparse_density_cutoff(NeuralNetwork::DEFAULT_SPARSE_DENSITY_CUTOFF);
+            if (sparsity == 0)
+                dense_accuracy = accuracy;
+
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(12) << hidden << std::setw(10)
+                      << sparsity << std::setw(10) << std::fixed << std::setprecision(3) << static_cast<double>(non_zeros) / elements
+                      << std::setw(14) << std::setprecision(0) << dense_rate << std::setw(14) << sparse_rate << std::setw(10)
+                      << std::setprecision(2) << sparse_rate / dense_rate << std::setw(10) << std::setprecision(4) << accuracy
+                      << std::showpos << accuracy - dense_accuracy << std::noshowpos << std::defaultfloat << std::endl;
+        }
+    }
+}
+
+void Benchmark::run_quantized(const std::string &data_directory) {
+    auto configs = get_default_configs();
+    configs.push_back(get_wide_config());
+
+    std::cout << "Quantized benchmark (double vs int8 weights), " << QUANTIZED_INFERENCES << " inferences per network, "
+              << "SIMD level: " << Simd::get_level_name(Simd::get_level()) << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(12) << "hidden" << std::setw(18) << "weight bytes"
+              << std::setw(10) << "memory" << std::setw(14) << "double inf/s" << std::setw(14) << "int8 inf/s"
+              << std::setw(10) << "speedup" << std::setw(18) << "accuracy" << "agreement" << std::endl;
+
+    for (const auto &config : configs) {
+        auto data = load_split(data_directory + "/" + config.data_filename);
+        auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+        auto testing_data = DataLoader::transform_to_matrices<double>(data.second);
+        auto nn = build_and_train<double>(config, training_data);
+
+        const uint32_t calibration_samples = std::min(CALIBRATION_SAMPLES, training_data.first.get_rows());
+        QuantizedNeuralNetwork quantized(nn, training_data.first.get_block_view(0, 0, calibration_samples, training_data.first.get_cols()));
+
+        size_t dense_bytes = 0;
+        std::string hidden;
+        for (const auto &layer : nn.get_layers()) {
+            const auto weights = std::as_const(*layer).get_weights();
+            dense_bytes += static_cast<size_t>(weights.get_rows()) * weights.get_cols() * sizeof(double);
+        }
+        for (auto size : config.hidden_layers_sizes)
+            hidden += (hidden.empty() ? "" : "x") + std::to_string(size);
+
+        uint32_t agreements = 0;
+        for (uint32_t i = 0; i < testing_data.first.get_rows(); i++)
+            agreements += nn.predict(testing_data.first.get_row_view(i)).argmax() == quantized.predict(testing_data.first.get_row_view(i)).argmax();
+
+        const double dense_rate = measure_inference(nn, testing_data.first, QUANTIZED_INFERENCES);
+        const double quantized_rate = measure_inference(quantized, testing_data.first, QUANTIZED_INFERENCES);
+        std::cout << std::left << std::setw(22) << config.data_filename << std::setw(12) << hidden << std::setw(18)
+                  << (std::to_string(dense_bytes) + " -> " + std::to_string(quantized.get_weights_bytes())) << std::setw(10)
+                  << std::fixed << std::setprecision(2) << static_cast<double>(dense_bytes) / quantized.get_weights_bytes()
+                  << std::setw(14) << std::setprecision(0) << dense_rate << std::setw(14) << quantized_rate << std::setw(10)
+                  << std::setprecision(2) << quantized_rate / dense_rate << std::setw(18) << std::setprecision(4)
+                  << (std::to_string(nn.test(testing_data)).substr(0, 6) + " / " + std::to_string(quantized.test(testing_data)).substr(0, 6))
+                  << static_cast<double>(agreements) / testing_data.first.get_rows() << std::defaultfloat << std::endl;
+    }
+}
+
+void Benchmark::run_backend(const std::string &data_directory, uint32_t repeats) {
+    const backend_type original_backend = Backend::get_type();
+    std::vector<backend_type> backends;
+    for (int i = 0; i < static_cast<int>(backend_type::number_of_backends); i++)
+        if (Backend::is_available(static_cast<backend_type>(i)))
+            backends.push_back(static_cast<backend_type>(i));
+
+    std::cout << "Backend benchmark (double), available backends:";
+    for (auto backend : backends)
+        std::cout << " " << Backend::get_name(backend);
+    std::cout << ", best / mean of " << repeats << " runs" << std::endl;
+
+    /* Square products, results of every backend are compared with the reference one */
+    std::cout << std::left << std::setw(8) << "size" << std::setw(12) << "backend" << std::setw(12) << "seconds"
+              << std::setw(10) << "GFLOP/s" << "max |diff|" << std::endl;
+    for (uint32_t size : BACKEND_SIZES) {
+        Matrix a(size, size, true);
+        Matrix b(size, size, true);
+        Matrix reference(size, size);
+        const uint32_t products = std::max(1u, (256u * 256u * 256u) / (size * size * size)); /* Small sizes are timed in bulk */
+
+        for (auto backend : backends) {
+            Backend::set_type(backend);
+            Matrix c(size, size);
+            double best = std::numeric_limits<double>::max();
+            for (uint32_t r = 0; r < repeats; r++) {
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t p = 0; p < products; p++)
+                    c = a * b;
+                auto end = std::chrono::steady_clock::now();
+                best = std::min(best, std::chrono::duration<double>(end - start).count() / products);
+            }
+            if (backend == backend_type::reference)
+                reference = c;
+
+            double max_difference = 0;
+            for (uint32_t i = 0; i < size; i++)
+                for (uint32_t j = 0; j < size; j++)
+                    max_difference = std::max(max_difference, std::abs(c.get_value(i, j) - reference.get_value(i, j)));
+
+            std::cout << std::left << std::setw(8) << size << std::setw(12) << Backend::get_name(backend) << std::setw(12)
+                      << std::scientific << std::setprecision(3) << best << std::setw(10) << std::fixed << std::setprecision(2)
+                      << 2.0 * size * size * size / best * 1e-9 << std::scientific << std::setprecision(1) << max_difference
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    /* Training of the small networks (matrix-vector products and outer products dominate) */
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(12) << "backend" << std::setw(14) << "samples/s"
+              << "accuracy" << std::endl;
+    for (const auto &config : get_default_configs()) {
+        auto data = load_split(data_directory + "/" + config.data_filename);
+        for (auto backend : backends) {
+            Backend::set_type(backend);
+            double samples_per_second = 0, accuracy = 0;
+            for (uint32_t r = 0; r < repeats; r++) {
+                auto result = train_and_test<double>(config, data.first, data.second);
+                samples_per_second += result.samples_per_second / repeats;
+                accuracy += result.accuracy / repeats;
+            }
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(12) << Backend::get_name(backend)
+                      << std::setw(14) << std::fixed << std::setprecision(0) << samples_per_second << std::setprecision(4)
+                      << accuracy << std::defaultfloat << std::endl;
+        }
+    }
+
+    Backend::set_type(original_backend);
+}
+
+template<typename T>
+uint32_t Benchmark::run_gemm_kernels() {
+    using gemm_kernel = void (*)(uint32_t, uint32_t, uint32_t, T, const T *, uint32_t, transpose_op, const T *, uint32_t,
+                                 transpose_op, T *, uint32_t);
+    struct checked_kernel {
+        const char *name;
+        gemm_kernel kernel; /* nullptr for the gemm of the reference backend (C = alpha * op(A) * op(B) + beta * C) */
+    };
+    const checked_kernel kernels[] = {
+            {"multiply", &Gemm::multiply<T>},
+            {"blocked", &Gemm::blocked<T>},
+            {"parallel", &Gemm::parallel<T>},
+            {"backend", nullptr},
+    };
+    const backend_kernels<T> *reference_backend;
+    if constexpr (std::is_same_v<T, float>)
+        reference_backend = &backend_kernels_reference.f32;
+    else
+        reference_backend = &backend_kernels_reference.f64;
+    /* Gemm kernels have no beta (C += ...), it is applied to C before them */
+    auto scale_c = [](uint32_t m, uint32_t n, T beta, T *c, uint32_t ldc) {
+        for (uint32_t i = 0; i < m; i++)
+            for (uint32_t j = 0; j < n; j++)
+                c[static_cast<size_t>(i) * ldc + j] *= beta;
+    };
+    const T alpha_beta[][2] = {{1, 0}, {static_cast<T>(-0.75), static_cast<T>(1.5)}};
+    const transpose_op operations[] = {transpose_op::none, transpose_op::transpose};
+    constexpr uint32_t padding = 3; /* Operands are views into wider buffers */
+    const double epsilon = std::numeric_limits<T>::epsilon();
+
+    uint32_t failed = 0;
+    for (const auto &checked : kernels) {
+        uint32_t checks = 0, kernel_failed = 0;
+        double max_ratio = 0; /* Largest difference relative to the tolerance */
+        for (const auto &shape : GEMM_SHAPES) {
+            const uint32_t m = shape[0], n = shape[1], k = shape[2];
+            for (auto trans_a : operations)
+                for (auto trans_b : operations)
+                    for (const auto &scalars : alpha_beta) {
+                        const T alpha = scalars[0], beta = scalars[1];
+                        /* Stored shapes of A (m x k) and B (k x n), transposed operands are stored the other way round */
+                        const uint32_t a_rows = trans_a == transpose_op::none ? m : k, a_cols = trans_a == transpose_op::none ? k : m;
+                        const uint32_t b_rows = trans_b == transpose_op::none ? k : n, b_cols = trans_b == transpose_op::none ? n : k;
+                        const uint32_t lda = a_cols + padding, ldb = b_cols + padding, ldc = n + padding;
+
+                        const auto generator = Random::get_generator(random_stream::weights);
+                        std::vector<T> a(static_cast<size_t>(a_rows) * lda), b(static_cast<size_t>(b_rows) * ldb), c(static_cast<size_t>(m) * ldc);
+                        generator.fill_uniform<T>(a.data(), a.size(), 0, -1, 1);
+                        generator.fill_uniform<T>(b.data(), b.size(), a.size(), -1, 1);
+                        generator.fill_uniform<T>(c.data(), c.size(), a.size() + b.size(), -1, 1);
+
+                        auto expected = c;
+                        scale_c(m, n, beta, expected.data(), ldc);
+                        Gemm::reference<T>(m, n, k, alpha, a.data(), lda, trans_a, b.data(), ldb, trans_b, expected.data(), ldc);
+                        auto result = c;
+                        if (checked.kernel) {
+                            scale_c(m, n, beta, result.data(), ldc);
+                            checked.kernel(m, n, k, alpha, a.data(), lda, trans_a, b.data(), ldb, trans_b, result.data(), ldc);
+                        } else {
+                            reference_backend->gemm(m, n, k, alpha, a.data(), lda, trans_a, b.data(), ldb, trans_b, beta, result.data(), ldc);
+                        }
+
+                        for (uint32_t i = 0; i < m; i++)
+                            for (uint32_t j = 0; j < n; j++) {
+                                /* Sum of the magnitudes of the terms bounds the rounding error of any summation order */
+                                double magnitude = std::abs(static_cast<double>(beta) * c[static_cast<size_t>(i) * ldc + j]);
+                                for (uint32_t p = 0; p < k; p++) {
+                                    const T a_ip = trans_a == transpose_op::none ? a[static_cast<size_t>(i) * lda + p] : a[static_cast<size_t>(p) * lda + i];
+                                    const T b_pj = trans_b == transpose_op::none ? b[static_cast<size_t>(p) * ldb + j] : b[static_cast<size_t>(j) * ldb + p];
+                                    magnitude += std::abs(static_cast<double>(alpha) * a_ip * b_pj);
+                                }
+                                const double tolerance = GEMM_TOLERANCE * (k + 2) * epsilon * magnitude;
+                                const double difference = std::abs(static_cast<double>(result[static_cast<size_t>(i) * ldc + j]) - expected[static_cast<size_t>(i) * ldc + j]);
+                                max_ratio = std::max(max_ratio, tolerance > 0 ? difference / tolerance : difference);
+                                kernel_failed += !(difference <= tolerance); /* NaN fails too */
+                            }
+                        /* Padding of C must stay untouched */
+                        for (uint32_t i = 0; i < m; i++)
+                            for (uint32_t j = n; j < ldc; j++)
+                                kernel_failed += result[static_cast<size_t>(i) * ldc + j] != c[static_cast<size_t>(i) * ldc + j];
+                        checks++;
+                    }
+        }
+
+        std::cout << std::left << std::setw(8) << (std::is_same_v<T, float> ? "float" : "double") << std::setw(12)
+                  << checked.name << std::setw(10) << checks << std::setw(16) << std::scientific << std::setprecision(2)
+                  << max_ratio << std::defaultfloat << kernel_failed << std::endl;
+        failed += kernel_failed;
+    }
+    return failed;
+}
+
+void Benchmark::run_gemm() {
+    std::cout << "Gemm check (blocked and parallel kernels vs the reference loop, seed " << SEED << "), "
+              << ThreadPool::get_num_threads() << " threads, tolerance " << GEMM_TOLERANCE << " * (k + 2) * epsilon * sum |terms|" << std::endl;
+    std::cout << std::left << std::setw(8) << "type" << std::setw(12) << "kernel" << std::setw(10) << "products"
+              << std::setw(16) << "max diff / tol" << "failed" << std::endl;
+
+    Random::set_seed(SEED);
+    const uint32_t failed = run_gemm_kernels<double>() + run_gemm_kernels<float>();
+    if (failed > 0)
+        throw std::runtime_error("Gemm check failed: " + std::to_string(failed) + " results out of the tolerance");
+}
+
+void Benchmark::run_threads(uint32_t repeats) {
+    const uint32_t original_threads = ThreadPool::get_num_threads();
+    const uint32_t hardware_threads = ThreadPool::get_hardware_threads();
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t count = 1; count < hardware_threads; count *= 2)
+        thread_counts.push_back(count);
+    thread_counts.push_back(hardware_threads);
+
+    std::cout << "Threads benchmark (square double products C = A * B), " << hardware_threads << " hardware threads, best of "
+              << repeats << " runs" << std::endl;
+    std::cout << std::left << std::setw(8) << "size" << std::setw(10) << "threads" << std::setw(12) << "seconds"
+              << std::setw(10) << "GFLOP/s" << std::setw(10) << "speedup" << "same result" << std::endl;
+
+    for (uint32_t size : THREADS_SIZES) {
+        Matrix a(size, size, true);
+        Matrix b(size, size, true);
+
+        Matrix single_threaded(size, size);
+        double single_threaded_seconds = 0;
+        for (uint32_t count : thread_counts) {
+            ThreadPool::set_num_threads(count);
+            Matrix c(size, size);
+            double best = std::numeric_limits<double>::max();
+            for (uint32_t r = 0; r < repeats; r++) {
+                auto start = std::chrono::steady_clock::now();
+                c = a * b;
+                auto end = std::chrono::steady_clock::now();
+                best = std::min(best, std::chrono::duration<double>(end - start).count());
+            }
+            if (count == 1) {
+                single_threaded = c;
+                single_threaded_seconds = best;
+            }
+
+            bool same = true;
+            for (uint32_t i = 0; i < size; i++)
+                for (uint32_t j = 0; j < size; j++)
+                    same = same && c.get_value(i, j) == single_threaded.get_value(i, j);
+
+            const double gflops = 2.0 * size * size * size / best * 1e-9;
+            std::cout << std::left << std::setw(8) << size << std::setw(10) << count << std::setw(12) << std::fixed
+                      << std::setprecision(4) << best << std::setw(10) << std::setprecision(2) << gflops << std::setw(10)
+                      << single_threaded_seconds / best << (same ? "yes" : "NO") << std::defaultfloat << std::endl;
+        }
+    }
+
+    ThreadPool::set_num_threads(original_threads);
+}
+
+void Benchmark::run_parallel(const std::string &data_directory, uint32_t repeats) {
+    const uint32_t original_threads = ThreadPool::get_num_threads();
+    const uint32_t hardware_threads = ThreadPool::get_hardware_threads();
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t count = 1; count < hardware_threads; count *= 2)
+        thread_counts.push_back(count);
+    thread_counts.push_back(hardware_threads);
+
+    std::cout << "Parallel benchmark (data-parallel training, one shard per thread, seed " << SEED << "), "
+              << hardware_threads << " hardware threads, best of " << repeats << " runs" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(10) << "threads" << std::setw(8) << "epochs"
+              << std::setw(14) << "samples/s" << std::setw(10) << "speedup" << std::setw(14) << "final loss"
+              << "max loss diff" << std::endl;
+
+    const auto configs = get_default_configs();
+    for (const char *dataset : PARALLEL_DATASETS) {
+        const auto config = *std::find_if(configs.begin(), configs.end(), [&](const bench_config &c) { return c.data_filename == dataset; });
+
+        Matrix single_threaded_error(0, 1);
+        double single_threaded_speed = 0;
+        for (uint32_t count : thread_counts) {
+            ThreadPool::set_num_threads(count);
+            double best = 0;
+            Matrix training_error(0, 1);
+            for (uint32_t r = 0; r < repeats; r++) {
+                Random::set_seed(SEED); /* Same split, init and shuffling for every thread count */
+                auto data = load_split(data_directory + "/" + config.data_filename);
+                auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+
+                auto start = std::chrono::steady_clock::now();
+                auto nn = build_and_train<double>(config, training_data, count);
+                auto end = std::chrono::steady_clock::now();
+
+                training_error = nn.get_training_error();
+                const double seconds = std::chrono::duration<double>(end - start).count();
+                best = std::max(best, static_cast<double>(training_error.get_rows()) * data.first.size() / seconds);
+            }
+            if (count == 1) {
+                single_threaded_error = training_error;
+                single_threaded_speed = best;
+            }
+
+            /* Shards sum the gradient in a different order, so the errors differ by rounding (early stopping may
+             * end the runs at different epochs, only the common ones are compared) */
+            double max_diff = 0;
+            for (uint32_t i = 0; i < std::min(training_error.get_rows(), single_threaded_error.get_rows()); i++)
+                max_diff = std::max(max_diff, std::abs(training_error.get_value(i, 0) - single_threaded_error.get_value(i, 0)));
+
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(10) << count << std::setw(8)
+                      << training_error.get_rows() << std::setw(14) << std::fixed << std::setprecision(0) << best
+                      << std::setw(10) << std::setprecision(2) << best / single_threaded_speed << std::setw(14)
+                      << std::setprecision(8) << training_error.get_value(training_error.get_rows() - 1, 0)
+                      << std::scientific << std::setprecision(2) << max_diff << std::defaultfloat << std::endl;
+        }
+    }
+
+    ThreadPool::set_num_threads(original_threads);
+}
+
+void Benchmark::run_hogwild(const std::string &data_directory, uint32_t repeats) {
+    const uint32_t original_threads = ThreadPool::get_num_threads();
+    const uint32_t hardware_threads = ThreadPool::get_hardware_threads();
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t count = 1; count < hardware_threads; count *= 2)
+        thread_counts.push_back(count);
+    thread_counts.push_back(hardware_threads);
+
+    std::cout << "Hogwild benchmark (time to the target loss, seed " << SEED << "), " << hardware_threads
+              << " hardware threads, mean of " << repeats << " runs" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(16) << "mode" << std::setw(10) << "threads"
+              << std::setw(12) << "target" << std::setw(8) << "epochs" << std::setw(12) << "seconds" << std::setw(10)
+              << "speedup" << "reached" << std::endl;
+
+    const auto configs = get_default_configs();
+    for (const char *dataset : PARALLEL_DATASETS) {
+        auto config = *std::find_if(configs.begin(), configs.end(), [&](const bench_config &c) { return c.data_filename == dataset; });
+
+        /* Target is the loss of the synchronous training after the epochs of the configuration */
+        Random::set_seed(SEED);
+        ThreadPool::set_num_threads(1);
+        auto reference_config = config;
+        reference_config.min_loss = 0;
+        auto reference_data = load_split(data_directory + "/" + config.data_filename);
+        auto reference_training_data = DataLoader::transform_to_matrices<double>(reference_data.first);
+        const auto reference_error = build_and_train<double>(reference_config, reference_training_data).get_training_error();
+        const double target = reference_error.get_value(reference_error.get_rows() - 1, 0);
+        config.min_loss = target;
+        config.epochs *= HOGWILD_EPOCHS_FACTOR;
+
+        struct hogwild_mode {
+            const char *name;
+            uint32_t threads;
+            bool asynchronous;
+        };
+        std::vector<hogwild_mode> modes = {{"synchronous", 1, false}};
+        for (uint32_t count : thread_counts) {
+            if (count > 1)
+                modes.push_back({"data-parallel", count, false});
+            modes.push_back({"hogwild", count, true});
+        }
+
+        double synchronous_seconds = 0;
+        for (const auto &mode : modes) {
+            ThreadPool::set_num_threads(mode.threads);
+            double seconds = 0, epochs = 0;
+            uint32_t reached = 0;
+            for (uint32_t r = 0; r < repeats; r++) {
+                Random::set_seed(SEED); /* Same split, init and shuffling for every mode */
+                auto data = load_split(data_directory + "/" + config.data_filename);
+                auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+
+                /* Same construction as build_and_train, the training mode is set before the training */
+                NeuralNetwork nn(NUMBER_OF_INPUTS, training_data.second.get_cols(), config.hidden_layers_sizes, config.softmax_output);
+                for (uint32_t i = 0; i < config.activation_functions.size(); i++)
+                    nn.get_layers()[i + 1]->set_activation_function(config.activation_functions[i]);
+                if (mode.asynchronous)
+                    nn.set_asynchronous_workers(mode.threads);
+                else
+                    nn.set_data_parallel_shards(mode.threads);
+
+                auto start = std::chrono::steady_clock::now();
+                nn.train(training_data, config.epochs, config.learning_rate, config.batch_size, false, config.min_loss);
+                auto end = std::chrono::steady_clock::now();
+
+                const auto training_error = nn.get_training_error();
+                seconds += std::chrono::duration<double>(end - start).count() / repeats;
+                epochs += static_cast<double>(training_error.get_rows()) / repeats;
+                reached += training_error.get_value(training_error.get_rows() - 1, 0) <= target;
+            }
+            if (!mode.asynchronous && mode.threads == 1)
+                synchronous_seconds = seconds;
+
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(16) << mode.name << std::setw(10)
+                      << mode.threads << std::setw(12) << std::setprecision(6) << target << std::setw(8) << std::fixed
+                      << std::setprecision(1) << epochs << std::setw(12) << std::setprecision(4) << seconds << std::setw(10)
+                      << std::setprecision(2) << synchronous_seconds / seconds << reached << "/" << repeats
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    ThreadPool::set_num_threads(original_threads);
+}
+
+void Benchmark::run_optimizer(const std::string &data_directory) {
+    std::cout << "Optimizer benchmark (seed " << SEED << ", target is the test accuracy of SGD after all epochs)" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(12) << "optimizer" << std::setw(14)
+              << "learning rate" << std::setw(10) << "target" << std::setw(10) << "reached" << std::setw(12)
+              << "final loss" << std::setw(10) << "accuracy" << "seconds" << std::endl;
+
+    for (const auto &config : get_default_configs()) {
+        double target = 0;
+        for (uint32_t o = 0; o < static_cast<uint32_t>(optimizer_type::number_of_optimizers); o++) {
+            const auto type = static_cast<optimizer_type>(o);
+            const double learning_rate = config.learning_rate * OPTIMIZER_LEARNING_RATE_FACTORS[o];
+
+            Random::set_seed(SEED); /* Same split, init and shuffling for every optimizer */
+            auto data = load_split(data_directory + "/" + config.data_filename);
+            auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+            auto test_data = DataLoader::transform_to_matrices<double>(data.second);
+
+            NeuralNetwork nn(NUMBER_OF_INPUTS, training_data.second.get_cols(), config.hidden_layers_sizes, config.softmax_output);
+            for (uint32_t i = 0; i < config.activation_functions.size(); i++)
+                nn.get_layers()[i + 1]->set_activation_function(config.activation_functions[i]);
+            nn.set_optimizer(type);
+
+            /* One epoch at a time to test after each of them (the test is not timed) */
+            double seconds = 0;
+            std::vector<double> accuracies;
+            for (uint32_t epoch = 1; epoch <= config.epochs; epoch++) {
+                auto start = std::chrono::steady_clock::now();
+                nn.train_one_step(training_data, epoch, learning_rate, config.batch_size);
+                auto end = std::chrono::steady_clock::now();
+                seconds += std::chrono::duration<double>(end - start).count();
+                accuracies.push_back(nn.test(test_data));
+            }
+            const double accuracy = accuracies.back();
+            if (type == optimizer_type::sgd)
+                target = accuracy;
+            auto first = std::find_if(accuracies.begin(), accuracies.end(), [&](double a) { return a >= target; });
+            const uint32_t reached = first == accuracies.end() ? 0 : static_cast<uint32_t>(first - accuracies.begin()) + 1;
+
+            const auto training_error = nn.get_training_error();
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(12) << Optimizer::get_name(type)
+                      << std::setw(14) << learning_rate << std::setw(10) << target << std::setw(10)
+                      << (reached ? std::to_string(reached) : "-") << std::setw(12)
+                      << training_error.get_value(training_error.get_rows() - 1, 0) << std::setw(10) << accuracy
+                      << std::fixed << std::setprecision(4) << seconds << std::defaultfloat << std::endl;
+        }
+    }
+}
+
+void Benchmark::run_seed(const std::string &data_directory, uint32_t repeats) {
+    const uint32_t original_threads = ThreadPool::get_num_threads();
+
+    std::cout << "Seed benchmark (seed " << SEED << "), " << ThreadPool::get_hardware_threads() << " hardware threads" << std::endl;
+    std::cout << "Random init of a " << SEED_INIT_SIZE << "x" << SEED_INIT_SIZE << " double matrix, best of " << repeats << " runs" << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(12) << "seconds" << std::setw(16) << "Mvalues/s"
+              << "same result" << std::endl;
+
+    Matrix single_threaded(SEED_INIT_SIZE, SEED_INIT_SIZE);
+    for (uint32_t count : SEED_THREADS) {
+        ThreadPool::set_num_threads(count);
+        Matrix m(SEED_INIT_SIZE, SEED_INIT_SIZE);
+        double best = std::numeric_limits<double>::max();
+        for (uint32_t r = 0; r < repeats; r++) {
+            Random::set_seed(SEED);
+            auto start = std::chrono::steady_clock::now();
+            m.randomize();
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(end - start).count());
+        }
+        if (count == 1)
+            single_threaded = m;
+
+        bool same = true;
+        for (uint32_t i = 0; i < SEED_INIT_SIZE; i++)
+            for (uint32_t j = 0; j < SEED_INIT_SIZE; j++)
+                same = same && m.get_value(i, j) == single_threaded.get_value(i, j);
+
+        const double values = static_cast<double>(SEED_INIT_SIZE) * SEED_INIT_SIZE;
+        std::cout << std::left << std::setw(10) << count << std::setw(12) << std::fixed << std::setprecision(4) << best
+                  << std::setw(16) << std::setprecision(1) << values / best * 1e-6 << (same ? "yes" : "NO")
+                  << std::defaultfloat << std::endl;
+    }
+
+    auto configs = get_default_configs();
+    configs.push_back(get_wide_config());
+    std::cout << std::endl << "Seeded training (split, init and shuffling)" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(10) << "threads" << std::setw(14) << "final loss"
+              << "same result" << std::endl;
+
+    for (const auto &config : configs) {
+        std::vector<Matrix> reference_weights;
+        double reference_loss = 0;
+        for (uint32_t count : SEED_THREADS) {
+            ThreadPool::set_num_threads(count);
+            Random::set_seed(SEED);
+            auto data = load_split(data_directory + "/" + config.data_filename);
+            auto training_data = DataLoader::transform_to_matrices<double>(data.first);
+            auto nn = build_and_train<double>(config, training_data);
+
+            const auto training_error = nn.get_training_error();
+            const double loss = training_error.get_value(training_error.get_rows() - 1, 0);
+            bool same = true;
+            const auto &layers = nn.get_layers();
+            for (uint32_t l = 0; l < layers.size(); l++) {
+                const auto weights = std::as_const(*layers[l]).get_weights();
+                if (count == 1) {
+                    reference_weights.push_back(weights);
+                    reference_loss = loss;
+                    continue;
+                }
+                for (uint32_t i = 0; i < weights.get_rows(); i++)
+                    for (uint32_t j = 0; j < weights.get_cols(); j++)
+                        same = same && weights.get_value(i, j) == reference_weights[l].get_value(i, j);
+            }
+            same = same && loss == reference_loss;
+
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(10) << count << std::setw(14)
+                      << std::setprecision(8) << loss << (same ? "yes" : "NO") << std::defaultfloat << std::endl;
+        }
+    }
+
+    ThreadPool::set_num_threads(original_threads);
+}
+
+template<typename T>
+void Benchmark::run_math_kernels() {
+    struct math_function {
+        const char *name;
+        void (*simd_math_kernels<T>::*kernel)(const T *, T *, size_t);
+        long double (*reference)(long double);
+        long double low, high;
+        bool relative;
+    };
+    const math_function functions[] = {
+            {"exp", &simd_math_kernels<T>::exp, [](long double x) { return std::exp(x); }, -80, 80, true},
+            {"log", &simd_math_kernels<T>::log, [](long double x) { return std::log(x); }, -30, 30, true}, /* log10(x) range (float has about 1e-38 to 3e38) */
+            {"tanh", &simd_math_kernels<T>::tanh, [](long double x) { return std::tanh(x); }, -10, 10, false},
+            {"sigmoid", &simd_math_kernels<T>::sigmoid, [](long double x) { return 1 / (1 + std::exp(-x)); }, -30, 30, true},
+    };
+
+    std::vector<T> inputs(MATH_SAMPLES);
+    std::vector<T> outputs(MATH_SAMPLES);
+    for (const auto &function : functions) {
+        /* Evenly spaced samples (log samples are spaced evenly in the exponent, so all magnitudes are covered) */
+        const bool logarithmic = function.kernel == &simd_math_kernels<T>::log;
+        for (uint32_t i = 0; i < MATH_SAMPLES; i++) {
+            const long double x = function.low + (function.high - function.low) * i / (MATH_SAMPLES - 1);
+            inputs[i] = static_cast<T>(logarithmic ? std::pow(10.0L, x) : x);
+        }
+
+        long double max_error = 0;
+        for (int level = 0; level <= static_cast<int>(Simd::detect_level()); level++) {
+            const auto &kernel_set = Simd::get_kernels(static_cast<simd_level>(level));
+            const simd_math_kernels<T> *fast;
+            if constexpr (std::is_same_v<T, float>)
+                fast = &kernel_set.f32.fast_math;
+            else
+                fast = &kernel_set.f64.fast_math;
+            (fast->*function.kernel)(inputs.data(), outputs.data(), MATH_SAMPLES);
+            for (uint32_t i = 0; i < MATH_SAMPLES; i++) {
+                const long double reference = function.reference(inputs[i]);
+                long double error = std::abs(outputs[i] - reference);
+                if (function.relative && reference != 0)
+                    error /= std::abs(reference);
+                max_error = std::max(max_error, error);
+            }
+        }
+
+        /* Throughput of the active level, the same block over and over (stays in L1) */
+        double rates[2] = {};
+        for (int mode = 0; mode < 2; mode++) {
+            const auto &kernels = Simd::kernels<T>();
+            const auto &math = mode == 0 ? kernels.exact_math : kernels.fast_math;
+            T checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < MATH_SAMPLES; i += MATH_BLOCK) {
+                (math.*function.kernel)(inputs.data() + (logarithmic ? 0 : MATH_SAMPLES / 2 - MATH_BLOCK / 2), outputs.data(), MATH_BLOCK);
+                checksum += outputs[i % MATH_BLOCK];
+            }
+            auto end = std::chrono::steady_clock::now();
+            rates[mode] = MATH_SAMPLES / std::chrono::duration<double>(end - start).count() * 1e-6;
+            if (checksum == std::numeric_limits<T>::infinity())
+                std::cout << std::endl;
+        }
+
+        std::cout << std::left << std::setw(10) << function.name << std::setw(8) << (std::is_same_v<T, float> ? "float" : "double")
+                  << std::setw(12) << std::scientific << std::setprecision(2) << static_cast<double>(max_error)
+                  << std::setw(10) << (function.relative ? "relative" : "absolute") << std::setw(14) << std::fixed
+                  << std::setprecision(1) << rates[0] << std::setw(14) << rates[1] << std::setprecision(2)
+                  << rates[1] / rates[0] << "x" << std::defaultfloat << std::endl;
+    }
+}
+
+void Benchmark::run_math(const std::string &data_directory) {
+    const math_mode original_mode = Simd::get_math_mode();
+
+    std::cout << "Math benchmark (exact vs fast transcendental kernels), SIMD level: " << Simd::get_level_name(Simd::get_level())
+              << ", errors are the largest over all supported levels" << std::endl;
+    std::cout << std::left << std::setw(10) << "function" << std::setw(8) << "type" << std::setw(12) << "max error"
+              << std::setw(10) << "kind" << std::setw(14) << "exact M/s" << std::setw(14) << "fast M/s" << "speedup" << std::endl;
+    run_math_kernels<double>();
+    run_math_kernels<float>();
+
+    auto configs = get_default_configs();
+    configs.push_back({"spiral.txt", {128, 128}, {act_func_type::tanh, act_func_type::tanh, act_func_type::linear}, true, 0.05, 50, 60, 0.});
+    configs.push_back({"moons.txt", {64, 64}, {act_func_type::sigmoid, act_func_type::sigmoid, act_func_type::linear}, true, 0.2, 50, 60, 0.});
+
+    std::cout << std::endl << "Training (double, same seed for both modes)" << std::endl;
+    std::cout << std::left << std::setw(22) << "dataset" << std::setw(12) << "hidden" << std::setw(8) << "mode"
+              << std::setw(8) << "epochs" << std::setw(14) << "samples/s" << std::setw(12) << "loss" << "accuracy" << std::endl;
+    for (const auto &config : configs) {
+        std::string hidden;
+        for (auto size : config.hidden_layers_sizes)
+            hidden += (hidden.empty() ? "" : "x") + std::to_string(size);
+
+        bench_result results[2];
+        for (int mode = 0; mode < 2; mode++) {
+            Simd::set_math_mode(static_cast<math_mode>(mode));
+            Random::set_seed(SEED);
+            auto data = load_split(data_directory + "/" + config.data_filename);
+            results[mode] = train_and_test<double>(config, data.first, data.second);
+            std::cout << std::left << std::setw(22) << config.data_filename << std::setw(12) << hidden << std::setw(8)
+                      << Simd::get_math_mode_name(static_cast<math_mode>(mode)) << std::setw(8) << results[mode].epochs
+                      << std::setw(14) << std::fixed << std::setprecision(0) << results[mode].samples_per_second
+                      << std::setw(12) << std::setprecision(4) << results[mode].final_loss << results[mode].accuracy
+                      << std::defaultfloat << std::endl;
+        }
+        std::cout << "    fast speedup: " << std::fixed << std::setprecision(2)
+                  << results[1].samples_per_second / results[0].samples_per_second << "x" << std::defaultfloat << std::endl;
+    }
+
+    Simd::set_math_mode(original_mode);
+}
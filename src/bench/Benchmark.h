@@ -0,0 +1,258 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include "../nn/NeuralNetwork.h"
+#include "../nn/FixedNeuralNetwork.h"
+#include "../nn/QuantizedNeuralNetwork.h"
+#include "../utils/DataLoader.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/Backend.h"
+#include "../utils/Gemm.h"
+
+/**
+ * Configuration of one benchmarked network (topology and hyperparameters, mirrors doc/params.txt)
+ */
+struct bench_config {
+    /** Name of the dataset file (inside the data directory) */
+    std::string data_filename;
+    /** Number of neurons in each hidden layer */
+    std::vector<uint32_t> hidden_layers_sizes;
+    /** Activation functions of the hidden layers and the output layer */
+    std::vector<act_func_type> activation_functions;
+    /** Flag whether to use softmax output or not */
+    bool softmax_output;
+    /** Learning rate */
+    double learning_rate;
+    /** Batch size */
+    uint32_t batch_size;
+    /** Maximum number of epochs */
+    uint32_t epochs;
+    /** Minimum loss to stop the training process (early stopping) */
+    double min_loss;
+};
+
+/**
+ * Result of one benchmarked training run
+ */
+struct bench_result {
+    /** Number of epochs really trained (early stopping can end the training sooner) */
+    uint32_t epochs;
+    /** Training time in seconds */
+    double seconds;
+    /** Training throughput (samples per second) */
+    double samples_per_second;
+    /** Loss of the last epoch */
+    double final_loss;
+    /** Accuracy on the test data */
+    double accuracy;
+    /** High-water mark of the training workspace (bytes) */
+    size_t workspace_bytes;
+};
+
+/**
+ * Class containing the command line benchmarks (no visualization, so they can run headless)
+ */
+class Benchmark {
+private:
+    /**
+     * Build, train and test one network of the given element type
+     * @tparam T Element type of the network (float / double)
+     * @param config Configuration of the network
+     * @param train_data Training data (one-hot encoded)
+     * @param test_data Test data (one-hot encoded)
+     * @return Result of the run
+     */
+    template<typename T>
+    static bench_result train_and_test(const bench_config &config, const x_y_pairs &train_data, const x_y_pairs &test_data);
+    /**
+     * Build and train one dynamic network
+     * @tparam T Element type of the network (float / double)
+     * @param config Configuration of the network
+     * @param training_data Training data
+     * @param data_parallel_shards Number of shards of each batch (data-parallel training), 1 trains on one thread
+     * @return Trained network
+     */
+    template<typename T>
+    static BasicNeuralNetwork<T> build_and_train(const bench_config &config, basic_x_y_matrix<T> &training_data, uint32_t data_parallel_shards = 1);
+    /**
+     * Compare the inference of a dynamic network and its compile-time counterpart on one configuration
+     * @tparam Sizes Sizes of all layers of the configuration (has to match the configuration)
+     * @param config Configuration of the network
+     * @param data_directory Directory containing the datasets
+     */
+    template<uint32_t... Sizes>
+    static void run_fixed_config(const bench_config &config, const std::string &data_directory);
+    /**
+     * Time the given number of inferences of the network on the rows of the data
+     * @tparam N Type of the network (anything with predict)
+     * @param nn Neural network
+     * @param inputs Inputs (one sample per row)
+     * @param count Number of inferences
+     * @return Inferences per second
+     */
+    template<typename N>
+    static double measure_inference(N &nn, const Matrix &inputs, uint32_t count);
+
+    /**
+     * Measure the largest error of the fast math kernels of all supported SIMD levels against long double std::
+     * functions and the throughput of the exact and fast kernels of the active level, prints one row per function
+     * @tparam T Element type (float / double)
+     */
+    template<typename T>
+    static void run_math_kernels();
+    /**
+     * Check the gemm kernels (Gemm::multiply, Gemm::blocked, Gemm::parallel and the gemm of the reference backend)
+     * against the reference loop (Gemm::reference) on GEMM_SHAPES, all transpositions and two alpha / beta pairs,
+     * operands are padded views (row stride bigger than the row), prints one row per kernel
+     * @tparam T Element type (float / double)
+     * @return Number of results out of the tolerance
+     */
+    template<typename T>
+    static uint32_t run_gemm_kernels();
+
+public:
+    /** Number of input features of the bundled datasets */
+    static constexpr uint32_t NUMBER_OF_INPUTS = 2;
+    /** Ratio of training data to test data */
+    static constexpr double DATA_SPLIT_RATIO = 0.8;
+    /** Number of inferences timed per network in the fixed benchmark */
+    static constexpr uint32_t FIXED_INFERENCES = 500000;
+    /** Number of inferences timed per network and sparsity level in the sparse benchmark */
+    static constexpr uint32_t SPARSE_INFERENCES = 100000;
+    /** Sparsity levels (fractions of pruned weights per layer) of the sparse benchmark */
+    static constexpr double SPARSE_LEVELS[] = {0.0, 0.5, 0.7, 0.8, 0.9, 0.95};
+    /** Number of inferences timed per network in the quantized benchmark */
+    static constexpr uint32_t QUANTIZED_INFERENCES = 200000;
+    /** Maximum number of training samples used to calibrate the quantized networks */
+    static constexpr uint32_t CALIBRATION_SAMPLES = 256;
+    /** Sizes of the square products of the backend benchmark */
+    static constexpr uint32_t BACKEND_SIZES[] = {16, 64, 256, 1024};
+    /** Sizes of the square products of the threads benchmark */
+    static constexpr uint32_t THREADS_SIZES[] = {256, 1024, 4096};
+    /** Shapes (m, n, k) of the gemm check: edge tiles, k > Gemm::KC, n > Gemm::NC and parallel sized products */
+    static constexpr uint32_t GEMM_SHAPES[][3] = {{1, 1, 1}, {3, 7, 5}, {4, 8, 16}, {5, 17, 3}, {33, 31, 29}, {37, 65, 300},
+                                                  {129, 33, 257}, {7, 2061, 9}, {131, 67, 517}, {200, 300, 260}};
+    /** Allowed difference of the gemm check (multiple of (k + 2) * epsilon * sum of the magnitudes of the terms) */
+    static constexpr double GEMM_TOLERANCE = 4;
+    /** Number of sample points per function of the math benchmark */
+    static constexpr uint32_t MATH_SAMPLES = 1 << 20;
+    /** Number of elements per call of the math throughput measurement */
+    static constexpr uint32_t MATH_BLOCK = 4096;
+    /** Seed of the seed benchmark */
+    static constexpr uint64_t SEED = 23;
+    /** Size of the square matrix randomized by the seed benchmark */
+    static constexpr uint32_t SEED_INIT_SIZE = 4096;
+    /** Thread counts of the seed benchmark (more than the hardware threads is fine, it checks the results) */
+    static constexpr uint32_t SEED_THREADS[] = {1, 2, 3, 4, 8};
+    /** Datasets of the parallel benchmark (configurations from doc/params.txt) */
+    static constexpr const char *PARALLEL_DATASETS[] = {"circle.txt", "moons.txt"};
+    /** Epoch limit of the hogwild benchmark (multiple of the epochs of the configuration) */
+    static constexpr uint32_t HOGWILD_EPOCHS_FACTOR = 4;
+    /** Learning rate of each optimizer of the optimizer benchmark (multiple of the learning rate of the configuration,
+     * in the order of optimizer_type), momentum takes steps about 1 / (1 - beta) times bigger than SGD */
+    static constexpr double OPTIMIZER_LEARNING_RATE_FACTORS[] = {1.0, 0.1, 0.1, 0.3, 0.3};
+
+    /**
+     * Get the configurations from doc/params.txt (one per bundled dataset)
+     * @return Configurations
+     */
+    static std::vector<bench_config> get_default_configs();
+    /**
+     * Get the configuration of a wide network (two hidden layers of 128 neurons on the spiral dataset), the bundled
+     * networks are too small to show the effect of some optimizations
+     * @return Configuration
+     */
+    static bench_config get_wide_config();
+    /**
+     * Load a dataset, one-hot encode the outputs and split it into training and test data
+     * @param data_filepath Path to the dataset
+     * @return Pair of training and test data
+     */
+    static std::pair<x_y_pairs, x_y_pairs> load_split(const std::string &data_filepath);
+    /**
+     * Compare float and double networks (training throughput and test accuracy) on the given configurations
+     * Both precisions train on the same split, results are averaged over the repeats
+     * @param configs Configurations to benchmark
+     * @param data_directory Directory containing the datasets
+     * @param repeats Number of runs per configuration and precision
+     */
+    static void run_precision(const std::vector<bench_config> &configs, const std::string &data_directory, uint32_t repeats);
+    /**
+     * Compare the inference throughput of the dynamic networks and the compile-time networks (FixedNeuralNetwork) on
+     * the default configurations, also reports the largest output difference (rounding only)
+     * @param data_directory Directory containing the datasets
+     */
+    static void run_fixed(const std::string &data_directory);
+    /**
+     * Prune the networks of the default configurations (plus one wide network) to several sparsity levels and compare
+     * the inference throughput of the dense and the sparse feed forward and the test accuracy
+     * @param data_directory Directory containing the datasets
+     */
+    static void run_sparse(const std::string &data_directory);
+    /**
+     * Quantize the networks of the default configurations (plus the wide one) to int8 and compare them with the
+     * originals (weight memory, inference throughput, test accuracy and argmax agreement)
+     * @param data_directory Directory containing the datasets
+     */
+    static void run_quantized(const std::string &data_directory);
+    /**
+     * Compare the available compute backends (square double products and training on the default configurations)
+     * @param data_directory Directory containing the datasets
+     * @param repeats Number of runs per size / configuration and backend (the best product time, mean throughput)
+     */
+    static void run_backend(const std::string &data_directory, uint32_t repeats);
+    /**
+     * Measure the scaling of the parallel matrix product (square double products, 1 thread up to all hardware
+     * threads), also checks that the result does not depend on the number of threads
+     * @param repeats Number of runs per size and thread count (the best one is reported)
+     */
+    static void run_threads(uint32_t repeats);
+    /**
+     * Check the blocked and parallel gemm kernels against the reference loop for float and double (odd shapes,
+     * edge tiles, k > Gemm::KC, n > Gemm::NC, transposed padded operands, alpha / beta other than 1 / 0)
+     * Throws when any result is out of the tolerance (GEMM_TOLERANCE), so the executable fails
+     */
+    static void run_gemm();
+    /**
+     * Measure the scaling of the synchronous data-parallel training (NeuralNetwork::set_data_parallel_shards) on the
+     * circle and moons datasets, 1 thread up to all hardware threads (one shard per thread, same seed), also reports
+     * the largest difference of the training error from the single-threaded run
+     * @param data_directory Directory containing the datasets
+     * @param repeats Number of runs per dataset and thread count (the best one is reported)
+     */
+    static void run_parallel(const std::string &data_directory, uint32_t repeats);
+    /**
+     * Compare the time to a target loss of the synchronous training (one thread and data-parallel) and the asynchronous
+     * Hogwild training (NeuralNetwork::set_asynchronous_workers) on the circle and moons datasets, the target is the loss
+     * the synchronous training reaches after the epochs of the configuration, every run stops on it (min_loss)
+     * @param data_directory Directory containing the datasets
+     * @param repeats Number of runs per dataset and mode (the mean time is reported)
+     */
+    static void run_hogwild(const std::string &data_directory, uint32_t repeats);
+    /**
+     * Train the configurations from doc/params.txt with every optimizer (same seed, learning rate scaled by
+     * OPTIMIZER_LEARNING_RATE_FACTORS) and report the first epoch reaching the test accuracy SGD ends with, the final
+     * loss, the test accuracy and the training time
+     * @param data_directory Directory containing the datasets
+     */
+    static void run_optimizer(const std::string &data_directory);
+    /**
+     * Compare the exact and fast math modes: error and throughput of the exp / log / tanh / sigmoid kernels, then
+     * training of the configurations from doc/params.txt plus a wide tanh network in both modes (same seed)
+     * @param data_directory Directory containing the datasets
+     */
+    static void run_math(const std::string &data_directory);
+    /**
+     * Check that a seeded run does not depend on the number of threads: times the (parallel) random init of a big
+     * matrix and trains the default configurations (plus the wide one) with a fixed seed for several thread counts,
+     * the initial matrix, the training error and the trained weights have to be bit-identical to the 1 thread run
+     * @param data_directory Directory containing the datasets
+     * @param repeats Number of runs of the init per thread count (the best one is reported)
+     */
+    static void run_seed(const std::string &data_directory, uint32_t repeats);
+};
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include "Benchmark.h"
+
+/**
+ * Print the usage of the benchmark executable
+ * @param program Name of the executable
+ */
+void print_usage(const std::string &program) {
+    std::cout << "Usage: " << program << " <mode> [data directory] [repeats]" << std::endl;
+    std::cout << "Modes:" << std::endl;
+    std::cout << "    precision    float vs double networks (throughput and accuracy on the bundled datasets)" << std::endl;
+    std::cout << "    fixed        dynamic vs compile-time networks (inference throughput and equality of the outputs)" << std::endl;
+    std::cout << "    sparse       dense vs sparse feed forward of pruned networks (speedup and accuracy per sparsity)" << std::endl;
+    std::cout << "    quantized    double vs int8 networks (weight memory, inference throughput, argmax agreement)" << std::endl;
+    std::cout << "    backend      reference vs system BLAS backend (products and training)" << std::endl;
+    std::cout << "    gemm         blocked / parallel gemm vs the reference loop (odd shapes, transpositions, fails on error)" << std::endl;
+    std::cout << "    threads      scaling of the parallel matrix product from 1 to all hardware threads" << std::endl;
+    std::cout << "    parallel     scaling of the data-parallel training on circle and moons from 1 to all hardware threads" << std::endl;
+    std::cout << "    hogwild      time to a target loss of the synchronous and the asynchronous (Hogwild) training" << std::endl;
+    std::cout << "    optimizer    SGD vs momentum / Nesterov / RMSProp / Adam (epochs to the accuracy of SGD, loss, time)" << std::endl;
+    std::cout << "    seed         seeded runs (random init, training) are bit-identical for any number of threads" << std::endl;
+    std::cout << "    math         exact vs fast exp / log / tanh / sigmoid (max error, throughput, training)" << std::endl;
+}
+
+/**
+ * Main function of the benchmarks
+ * @param argc Number of arguments
+ * @param argv Arguments (mode, data directory, repeats)
+ * @return Exit code
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string mode = argv[1];
+    std::string data_directory = argc > 2 ? argv[2] : "data";
+    uint32_t repeats = argc > 3 ? std::stoul(argv[3]) : 3;
+
+    try {
+        if (mode == "precision")
+            Benchmark::run_precision(Benchmark::get_default_configs(), data_directory, repeats);
+        else if (mode == "fixed")
+            Benchmark::run_fixed(data_directory);
+        else if (mode == "sparse")
+            Benchmark::run_sparse(data_directory);
+        else if (mode == "quantized")
+            Benchmark::run_quantized(data_directory);
+        else if (mode == "math")
+            Benchmark::run_math(data_directory);
+        else if (mode == "seed")
+            Benchmark::run_seed(data_directory, repeats);
+        else if (mode == "backend")
+            Benchmark::run_backend(data_directory, repeats);
+        else if (mode == "gemm")
+            Benchmark::run_gemm();
+        else if (mode == "threads")
+            Benchmark::run_threads(repeats);
+        else if (mode == "parallel")
+            Benchmark::run_parallel(data_directory, repeats);
+        else if (mode == "hogwild")
+            Benchmark::run_hogwild(data_directory, repeats);
+        else if (mode == "optimizer")
+            Benchmark::run_optimizer(data_directory);
+        else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -87,25 +87,26 @@ void Visualization::render() {
         visuals_data_y_nn_classified.clear();
         visuals_data_class_nn_classified.clear();
 
-        /* Classify the space */
+        /* Classify the space (all grid points as one batch) */
         int steps = 50;
+        Matrix inputs = Matrix(steps * steps, 2);
         for (int i = 0; i < steps; i++) {
             for (int j = 0; j < steps; ++j) {
                 float x = x_min + (x_max - x_min) / (float) steps * i;
                 float y = y_min + (y_max - y_min) / (float) steps * j;
 
-                Matrix input = Matrix(1, 2);
-                input.set_value(0, 0, x);
-                input.set_value(0, 1, y);
-
-                Matrix output = nn.predict(input);
+                inputs.set_value(i * steps + j, 0, x);
+                inputs.set_value(i * steps + j, 1, y);
 
                 visuals_data_x_nn_classified.emplace_back(x);
                 visuals_data_y_nn_classified.emplace_back(y);
-                visuals_data_class_nn_classified.emplace_back(static_cast<int>(output.argmax()));
             }
         }
 
+        Matrix outputs = nn.predict_batch(inputs);
+        for (int i = 0; i < steps * steps; i++)
+            visuals_data_class_nn_classified.emplace_back(static_cast<int>(outputs.get_row_view(i).argmax()));
+
         /* Check if the training is finished */
         if (current_epoch > number_of_epochs) {
             training = false;
@@ -114,8 +115,8 @@ void Visualization::render() {
         }
 
         /* Check if the training is finished (early stopping) */
-        if (nn.get_training_error().get_row(current_epoch - 2).get_value(0, 0) < min_loss ||
-            (current_epoch > 2 && std::abs(nn.get_training_error().get_row(current_epoch - 2).get_value(0, 0) - nn.get_training_error().get_row(current_epoch - 3).get_value(0, 0)) < delta_loss)) {
+        if (nn.get_training_error().get_value(current_epoch - 2, 0) < min_loss ||
+            (current_epoch > 2 && std::abs(nn.get_training_error().get_value(current_epoch - 2, 0) - nn.get_training_error().get_value(current_epoch - 3, 0)) < delta_loss)) {
             training = false;
             std::cout << "Training finished (early stopping)" << std::endl;
             std::cout << "Test data accuracy: " << nn.test(test_data) * 100 << " %" << std::endl;
@@ -203,14 +204,14 @@ void Visualization::render() {
 
             /* Prepare the data for visualization */
             for (int i = 0; i < training_data.first.get_dims()[0]; i++) {
-                visuals_data_x.emplace_back(training_data.first.get_row(i).get_values()[0][0]);
-                visuals_data_y.emplace_back(training_data.first.get_row(i).get_values()[0][1]);
-                visuals_data_class.emplace_back(static_cast<int>(training_data.second.get_row(i).argmax()));
+                visuals_data_x.emplace_back(training_data.first.get_value(i, 0));
+                visuals_data_y.emplace_back(training_data.first.get_value(i, 1));
+                visuals_data_class.emplace_back(static_cast<int>(training_data.second.get_row_view(i).argmax()));
             }
             for (int i = 0; i < test_data.first.get_dims()[0]; i++) {
-                visuals_data_x.emplace_back(test_data.first.get_row(i).get_values()[0][0]);
-                visuals_data_y.emplace_back(test_data.first.get_row(i).get_values()[0][1]);
-                visuals_data_class.emplace_back(static_cast<int>(test_data.second.get_row(i).argmax()));
+                visuals_data_x.emplace_back(test_data.first.get_value(i, 0));
+                visuals_data_y.emplace_back(test_data.first.get_value(i, 1));
+                visuals_data_class.emplace_back(static_cast<int>(test_data.second.get_row_view(i).argmax()));
             }
 
             x_min = std::min_element(visuals_data_x.begin(), visuals_data_x.end()).operator*();
@@ -279,6 +280,7 @@ void Visualization::render() {
             nn = NeuralNetwork(number_of_inputs, number_of_classes, temp_vector, use_softmax);
             for (int i = 0; i < number_of_hidden_layers + 1; i++)
                 nn.get_layers()[i + 1]->set_activation_function(static_cast<act_func_type>(chosen_activation_functions[i]));
+            nn.set_optimizer(static_cast<optimizer_type>(chosen_optimizer));
 
             std::cout << "Neural Network created" << std::endl;
             std::cout << nn << std::endl;
@@ -304,6 +306,18 @@ void Visualization::render() {
             if (batch_size < 1) batch_size = 1;
         }
 
+        const char *optimizer_list[] = {
+                "SGD",
+                "Momentum",
+                "Nesterov",
+                "RMSProp",
+                "Adam"
+        };
+        if (ImGui::Combo("Optimizer", &chosen_optimizer, optimizer_list, IM_ARRAYSIZE(optimizer_list))) {
+            /* New optimizer starts from zero velocity / moments */
+            nn.set_optimizer(static_cast<optimizer_type>(chosen_optimizer));
+        }
+
         if (ImGui::InputDouble("Minimum loss", &min_loss, 0.001f, 0.01f, "%.5f")) {
             if (min_loss < 0.0) min_loss = 0.0;
         }
@@ -344,6 +358,7 @@ void Visualization::render() {
             nn = NeuralNetwork(number_of_inputs, number_of_classes, temp_vector, use_softmax);
             for (int i = 0; i < number_of_hidden_layers + 1; i++)
                 nn.get_layers()[i + 1]->set_activation_function(static_cast<act_func_type>(chosen_activation_functions[i]));
+            nn.set_optimizer(static_cast<optimizer_type>(chosen_optimizer));
 
             /* Clear cached data */
             visuals_data_x_nn_classified.clear();
@@ -446,7 +461,7 @@ void Visualization::render() {
                 Matrix training_error = nn.get_training_error();
                 float data[training_error.get_dims()[0]];
                 for (int i = 0; i < training_error.get_dims()[0]; i++)
-                    data[i] = training_error.get_row(i).get_values()[0][0];
+                    data[i] = training_error.get_value(i, 0);
 
                 /* Plot the function */
                 ImPlot::SetNextAxesLimits(0.0f, (float) training_error.get_dims()[0], 0.0f, 1.0f, ImGuiCond_Appearing);
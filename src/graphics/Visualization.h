@@ -98,6 +98,8 @@ private:
     float learning_rate = 0.01f;
     /** Batch size, can be changed from the gui */
     int batch_size = 10;
+    /** Optimizer, can be changed from the gui */
+    int chosen_optimizer = static_cast<int>(optimizer_type::sgd);
     /** Use softmax flag, can be changed from the gui */
     bool use_softmax = true;
 
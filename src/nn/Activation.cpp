@@ -0,0 +1,171 @@
+#include "Activation.h"
+
+#include <array>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+    /** Names of the predefined activations (in the order of act_func_type) */
+    const std::string act_func_names[] = {
+            "Linear",
+            "ReLU",
+            "Sigmoid",
+            "Step",
+            "Sign",
+            "Tanh",
+    };
+
+    /** Guards the registered activations */
+    std::mutex registry_mutex;
+
+    /**
+     * Get the registered custom activations
+     * @tparam T Element type (float / double)
+     * @return Registered activations (guarded by registry_mutex)
+     */
+    template<typename T>
+    std::vector<custom_activation<T>> &registered_activations() {
+        static std::vector<custom_activation<T>> activations;
+        return activations;
+    }
+
+    /**
+     * Get the predefined activations
+     * @tparam T Element type (float / double)
+     * @return Predefined activations (in the order of act_func_type)
+     */
+    template<typename T>
+    const std::array<basic_activation<T>, static_cast<size_t>(act_func_type::number_of_activation_functions)> &predefined_activations() {
+        static const std::array<basic_activation<T>, static_cast<size_t>(act_func_type::number_of_activation_functions)> activations = {
+                linear_activation<T>(),
+                relu_activation<T>(),
+                sigmoid_activation<T>(),
+                step_activation<T>(),
+                sign_activation<T>(),
+                tanh_activation<T>(),
+        };
+        return activations;
+    }
+}
+
+template<typename T>
+void Activations::register_activation(const std::string &name, basic_act_func<T> function, basic_act_func<T> derivative) {
+    if (!function || !derivative)
+        throw std::runtime_error("Activation " + name + " needs a function and its derivative");
+    for (const auto &predefined_name : act_func_names)
+        if (predefined_name == name)
+            throw std::runtime_error("Activation " + name + " is predefined");
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto &activations = registered_activations<T>();
+    for (auto &activation : activations)
+        if (activation.name == name) { /* Replace the registered one */
+            activation.function_pointer = function;
+            activation.derivative_pointer = derivative;
+            return;
+        }
+    activations.push_back({function, derivative, name});
+}
+
+template<typename T>
+basic_activation<T> Activations::from_type(act_func_type type) {
+    if (type == act_func_type::number_of_activation_functions)
+        throw std::runtime_error("Custom activation has no type, use its functions or its name");
+    return predefined_activations<T>()[static_cast<uint32_t>(type)];
+}
+
+template<typename T>
+basic_activation<T> Activations::from_name(const std::string &name) {
+    for (int i = 0; i < static_cast<int>(act_func_type::number_of_activation_functions); i++)
+        if (act_func_names[i] == name)
+            return predefined_activations<T>()[i];
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &activation : registered_activations<T>())
+        if (activation.name == name)
+            return activation;
+    throw std::runtime_error("Unknown activation " + name);
+}
+
+template<typename T>
+basic_activation<T> Activations::from_functions(basic_act_func<T> function, basic_act_func<T> derivative) {
+    /* Predefined pair (or a predefined function with its own derivative) */
+    custom_activation<T> custom = {function, derivative};
+    for (const auto &activation : predefined_activations<T>())
+        if (get_function<T>(activation) == function) {
+            if (!derivative || get_derivative<T>(activation) == derivative)
+                return activation;
+            custom.name = get_name<T>(activation);
+        }
+
+    /* Registered pair */
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &activation : registered_activations<T>())
+        if (activation.function_pointer == function) {
+            if (!derivative || activation.derivative_pointer == derivative)
+                return activation;
+            custom.name = activation.name;
+        }
+    return custom; /* Derivative stays nullptr if it was not given and the function is unknown */
+}
+
+template<typename T>
+basic_act_func<T> Activations::get_function(const basic_activation<T> &activation) {
+    return std::visit([](const auto &a) -> basic_act_func<T> {
+        if constexpr (std::is_same_v<std::decay_t<decltype(a)>, custom_activation<T>>)
+            return a.function_pointer;
+        else
+            return &std::decay_t<decltype(a)>::function;
+    }, activation);
+}
+
+template<typename T>
+basic_act_func<T> Activations::get_derivative(const basic_activation<T> &activation) {
+    return std::visit([](const auto &a) -> basic_act_func<T> {
+        if constexpr (std::is_same_v<std::decay_t<decltype(a)>, custom_activation<T>>)
+            return a.derivative_pointer;
+        else
+            return static_cast<basic_act_func<T>>(&std::decay_t<decltype(a)>::derivative);
+    }, activation);
+}
+
+template<typename T>
+act_func_type Activations::get_type(const basic_activation<T> &activation) {
+    return static_cast<act_func_type>(activation.index()); /* Alternatives are in the order of act_func_type */
+}
+
+template<typename T>
+std::string Activations::get_name(const basic_activation<T> &activation) {
+    if (const auto *custom = std::get_if<custom_activation<T>>(&activation))
+        return custom->name;
+    return act_func_names[activation.index()];
+}
+
+template<typename T>
+std::vector<std::string> Activations::get_names() {
+    std::vector<std::string> names(std::begin(act_func_names), std::end(act_func_names));
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &activation : registered_activations<T>())
+        names.push_back(activation.name);
+    return names;
+}
+
+template void Activations::register_activation<float>(const std::string &, basic_act_func<float>, basic_act_func<float>);
+template void Activations::register_activation<double>(const std::string &, basic_act_func<double>, basic_act_func<double>);
+template basic_activation<float> Activations::from_type<float>(act_func_type);
+template basic_activation<double> Activations::from_type<double>(act_func_type);
+template basic_activation<float> Activations::from_name<float>(const std::string &);
+template basic_activation<double> Activations::from_name<double>(const std::string &);
+template basic_activation<float> Activations::from_functions<float>(basic_act_func<float>, basic_act_func<float>);
+template basic_activation<double> Activations::from_functions<double>(basic_act_func<double>, basic_act_func<double>);
+template basic_act_func<float> Activations::get_function<float>(const basic_activation<float> &);
+template basic_act_func<double> Activations::get_function<double>(const basic_activation<double> &);
+template basic_act_func<float> Activations::get_derivative<float>(const basic_activation<float> &);
+template basic_act_func<double> Activations::get_derivative<double>(const basic_activation<double> &);
+template act_func_type Activations::get_type<float>(const basic_activation<float> &);
+template act_func_type Activations::get_type<double>(const basic_activation<double> &);
+template std::string Activations::get_name<float>(const basic_activation<float> &);
+template std::string Activations::get_name<double>(const basic_activation<double> &);
+template std::vector<std::string> Activations::get_names<float>();
+template std::vector<std::string> Activations::get_names<double>();
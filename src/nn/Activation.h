@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdint>
+#include "../utils/Simd.h"
+
+/** Activation function for the given element type */
+template<typename T>
+using basic_act_func = T (*)(T);
+/** Activation function */
+typedef basic_act_func<double> act_func;
+
+/** Activation function type */
+enum class act_func_type {
+    linear = 0,
+    relu,
+    sigmoid,
+    step,
+    sign,
+    tanh,
+    number_of_activation_functions /* Enum trick to get the number of activation functions */
+};
+
+/*
+ * Activation functors
+ * Every functor provides the function, its derivative from the input (function pointer interface) and its derivative
+ * from the input and the already computed output (fused kernels), the layer kernels are templated on them, so the
+ * compiler inlines and vectorizes the whole loop
+ * Functors with apply() evaluate the whole layer at once (SIMD math kernels)
+ */
+
+/** Linear activation, f(x) = x */
+template<typename T>
+struct linear_activation {
+    static T function(T x) { return x; }
+    static T derivative(T x) { return 1; }
+    static T derivative(T x, T y) { return 1; }
+};
+
+/** ReLU activation, f(x) = max(x, 0) */
+template<typename T>
+struct relu_activation {
+    static T function(T x) { return x > 0 ? x : 0; }
+    static T derivative(T x) { return x > 0 ? 1 : 0; }
+    static T derivative(T x, T y) { return x > 0 ? 1 : 0; }
+};
+
+/** Sigmoid activation, f(x) = 1 / (1 + e^-x), f' = f * (1 - f) */
+template<typename T>
+struct sigmoid_activation {
+    static T function(T x) { return 1 / (1 + std::exp(-x)); }
+    static T derivative(T x) { const T s = function(x); return s * (1 - s); }
+    static T derivative(T x, T y) { return y * (1 - y); }
+    static void apply(const T *input, T *output, size_t n) { Simd::math<T>().sigmoid(input, output, n); }
+};
+
+/** Step activation, f(x) = 1 for x > 0, 0 otherwise */
+template<typename T>
+struct step_activation {
+    static T function(T x) { return x > 0 ? 1 : 0; }
+    static T derivative(T x) { return 0; }
+    static T derivative(T x, T y) { return 0; }
+};
+
+/** Sign activation, f(x) = 1 for x > 0, -1 otherwise */
+template<typename T>
+struct sign_activation {
+    static T function(T x) { return x > 0 ? 1 : -1; }
+    static T derivative(T x) { return 0; }
+    static T derivative(T x, T y) { return 0; }
+};
+
+/** Tanh activation, f' = 1 - f^2 */
+template<typename T>
+struct tanh_activation {
+    static T function(T x) { return std::tanh(x); }
+    static T derivative(T x) { const T t = std::tanh(x); return 1 - t * t; }
+    static T derivative(T x, T y) { return 1 - y * y; }
+    static void apply(const T *input, T *output, size_t n) { Simd::math<T>().tanh(input, output, n); }
+};
+
+/** Custom activation, a pair of function pointers (registered through Activations::register_activation or set directly) */
+template<typename T>
+struct custom_activation {
+    /** Activation function */
+    basic_act_func<T> function_pointer = nullptr;
+    /** Derivative of the activation function (from the input) */
+    basic_act_func<T> derivative_pointer = nullptr;
+    /** Name of the activation function ("Unknown" unless registered) */
+    std::string name = "Unknown";
+
+    T function(T x) const { return this->function_pointer(x); }
+    T derivative(T x) const { return this->derivative_pointer(x); }
+    T derivative(T x, T y) const { return this->derivative_pointer(x); }
+};
+
+/**
+ * Activation of a layer, alternatives are in the order of act_func_type (custom one last), so index() is the type
+ * The layer visits it once per activation, not once per neuron
+ */
+template<typename T>
+using basic_activation = std::variant<linear_activation<T>, relu_activation<T>, sigmoid_activation<T>, step_activation<T>,
+                                      sign_activation<T>, tanh_activation<T>, custom_activation<T>>;
+
+/**
+ * Activation kernel, output and derivative of each neuron in one pass (just the output without the derivative)
+ * Templated on the activation functor, so the functions are inlined into the loop
+ * @tparam T Element type (float / double)
+ * @tparam Activation Activation functor (one of the above)
+ * @param activation Activation
+ * @param input Inputs of the neurons
+ * @param output Outputs of the neurons (may be the inputs)
+ * @param derivative_output Derivative outputs of the neurons, nullptr to skip them
+ * @param size Number of neurons
+ */
+template<typename T, typename Activation>
+void activate_kernel(const Activation &activation, const T *input, T *output, T *derivative_output, uint32_t size) {
+    if constexpr (requires { Activation::apply(input, output, size_t(size)); }) { /* Whole layer at once, derivatives from the outputs */
+        Activation::apply(input, output, size);
+        if (derivative_output)
+            for (uint32_t i = 0; i < size; i++)
+                derivative_output[i] = activation.derivative(input[i], output[i]);
+    } else if (!derivative_output) {
+        for (uint32_t i = 0; i < size; i++)
+            output[i] = activation.function(input[i]);
+    } else {
+        for (uint32_t i = 0; i < size; i++) {
+            const T y = activation.function(input[i]);
+            output[i] = y;
+            derivative_output[i] = activation.derivative(input[i], y);
+        }
+    }
+}
+
+/**
+ * Derivative kernel, derivative of each neuron from its input and its already computed output
+ * @tparam T Element type (float / double)
+ * @tparam Activation Activation functor (one of the above)
+ * @param activation Activation
+ * @param input Inputs of the neurons
+ * @param output Outputs of the neurons
+ * @param derivative_output Derivative outputs of the neurons
+ * @param size Number of neurons
+ */
+template<typename T, typename Activation>
+void derivative_kernel(const Activation &activation, const T *input, const T *output, T *derivative_output, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++)
+        derivative_output[i] = activation.derivative(input[i], output[i]);
+}
+
+/**
+ * Class for the activations of the layers
+ * Converts between the enum, the function pointers, the names and the functors, keeps the registered custom activations
+ */
+class Activations {
+public:
+    /**
+     * Register a custom activation, so it can be selected by its name and it is recognized (name and derivative)
+     * when a layer gets its function pointer, registering a name again replaces it
+     * @tparam T Element type (float / double)
+     * @param name Name of the activation (must not be one of the predefined names)
+     * @param function Activation function
+     * @param derivative Derivative of the activation function
+     */
+    template<typename T>
+    static void register_activation(const std::string &name, basic_act_func<T> function, basic_act_func<T> derivative);
+    /**
+     * Get the activation of the given type
+     * @tparam T Element type (float / double)
+     * @param type Type of the activation (predefined)
+     * @return Activation
+     */
+    template<typename T>
+    static basic_activation<T> from_type(act_func_type type);
+    /**
+     * Get the activation with the given name (predefined or registered)
+     * @tparam T Element type (float / double)
+     * @param name Name of the activation
+     * @return Activation
+     */
+    template<typename T>
+    static basic_activation<T> from_name(const std::string &name);
+    /**
+     * Get the activation of the given pair of functions, predefined or registered pairs get their functor / name
+     * @tparam T Element type (float / double)
+     * @param function Activation function
+     * @param derivative Derivative of the activation function (nullptr to take the predefined / registered one)
+     * @return Activation
+     */
+    template<typename T>
+    static basic_activation<T> from_functions(basic_act_func<T> function, basic_act_func<T> derivative = nullptr);
+    /**
+     * Get the activation function of the activation
+     * @tparam T Element type (float / double)
+     * @param activation Activation
+     * @return Activation function (as a function pointer)
+     */
+    template<typename T>
+    static basic_act_func<T> get_function(const basic_activation<T> &activation);
+    /**
+     * Get the derivative of the activation function of the activation
+     * @tparam T Element type (float / double)
+     * @param activation Activation
+     * @return Derivative of the activation function (as a function pointer)
+     */
+    template<typename T>
+    static basic_act_func<T> get_derivative(const basic_activation<T> &activation);
+    /**
+     * Get the type of the activation
+     * @tparam T Element type (float / double)
+     * @param activation Activation
+     * @return Type of the activation (number_of_activation_functions for a custom one)
+     */
+    template<typename T>
+    static act_func_type get_type(const basic_activation<T> &activation);
+    /**
+     * Get the name of the activation
+     * @tparam T Element type (float / double)
+     * @param activation Activation
+     * @return Name of the activation
+     */
+    template<typename T>
+    static std::string get_name(const basic_activation<T> &activation);
+    /**
+     * Get the names of all activations, the predefined ones (in the order of act_func_type) followed by the registered ones
+     * @tparam T Element type (float / double)
+     * @return Names of the activations
+     */
+    template<typename T>
+    static std::vector<std::string> get_names();
+};
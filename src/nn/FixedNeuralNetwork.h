@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <cmath>
+#include "NeuralNetwork.h"
+#include "../utils/FixedMatrix.h"
+
+/**
+ * Inference-only neural network with the topology known at compile time
+ * Weights are FixedMatrix objects, so the whole forward pass runs on the stack with constant loop bounds (fully
+ * unrolled and vectorized for the tiny networks from doc/params.txt), no allocation, no virtual or indirect calls
+ * It is built from a trained BasicNeuralNetwork with the same topology and produces the same outputs up to rounding
+ * (same formulas, but the dynamic network multiplies with the blocked kernel, which can sum in a different order)
+ * Usage: FixedNeuralNetwork<double, 2, 16, 12, 3> fixed(nn); auto output = fixed.predict(inputs);
+ * @tparam T Element type (float / double)
+ * @tparam Sizes Sizes of all layers (input layer, hidden layers, output layer)
+ */
+template<typename T, uint32_t... Sizes>
+class FixedNeuralNetwork {
+    static_assert(sizeof...(Sizes) >= 2, "Fixed neural network needs at least the input and the output layer");
+
+public:
+    /** Number of layers (including the input layer) */
+    static constexpr size_t NUMBER_OF_LAYERS = sizeof...(Sizes);
+    /** Sizes of the layers */
+    static constexpr std::array<uint32_t, NUMBER_OF_LAYERS> SIZES = {Sizes...};
+    /** Size of the input layer */
+    static constexpr uint32_t INPUT_SIZE = SIZES.front();
+    /** Size of the output layer */
+    static constexpr uint32_t OUTPUT_SIZE = SIZES.back();
+
+private:
+    /**
+     * Helper deducing the types of the weights (layer i has SIZES[i + 1] x (SIZES[i] + 1) weights, bias included)
+     * @return Nothing (only used in decltype)
+     */
+    template<size_t... I>
+    static auto make_weights(std::index_sequence<I...>) -> std::tuple<FixedMatrix<T, SIZES[I + 1], SIZES[I] + 1>...>;
+
+    /** Weights of the layers (weights include bias term) */
+    decltype(make_weights(std::make_index_sequence<NUMBER_OF_LAYERS - 1>{})) weights;
+    /** Activation functions of the layers */
+    std::array<act_func_type, NUMBER_OF_LAYERS> activation_functions;
+    /** Softmax output */
+    bool softmax_output;
+
+    /**
+     * Copy the weights of all layers from the dynamic neural network
+     * @param layers Layers of the dynamic neural network
+     */
+    template<size_t... I>
+    void copy_weights(const std::vector<std::shared_ptr<BasicLayer<T>>> &layers, std::index_sequence<I...>) {
+        ((std::get<I>(this->weights) = FixedMatrix<T, SIZES[I + 1], SIZES[I] + 1>(layers[I + 1]->get_weights())), ...);
+    }
+
+    /**
+     * Apply the activation function to the values (same formulas as the predefined activation functions of Layer)
+     * The switch is resolved once per layer, the loops themselves have no indirect calls
+     * @param type Activation function
+     * @param values Values to activate (in place)
+     */
+    template<uint32_t N>
+    static void activate(act_func_type type, FixedMatrix<T, N, 1> &values) {
+        T *v = values.get_data();
+        switch (type) {
+            case act_func_type::linear:
+                break;
+            case act_func_type::relu:
+                for (uint32_t i = 0; i < N; i++)
+                    v[i] = v[i] > 0 ? v[i] : 0;
+                break;
+            case act_func_type::sigmoid:
+                for (uint32_t i = 0; i < N; i++)
+                    v[i] = 1 / (1 + std::exp(-v[i]));
+                break;
+            case act_func_type::step:
+                for (uint32_t i = 0; i < N; i++)
+                    v[i] = v[i] > 0 ? 1 : 0;
+                break;
+            case act_func_type::sign:
+                for (uint32_t i = 0; i < N; i++)
+                    v[i] = v[i] > 0 ? 1 : -1;
+                break;
+            case act_func_type::tanh:
+                for (uint32_t i = 0; i < N; i++)
+                    v[i] = std::tanh(v[i]);
+                break;
+            default:
+                throw std::runtime_error("Fixed neural network error: unknown activation function");
+        }
+    }
+
+    /**
+     * Softmax of the values, in place (exponential of the value divided by the sum of the exponentials of all values)
+     * The maximum is subtracted first (as in BasicLayer::write_softmax_output), so large logits cannot overflow exp
+     * @param values Values (inputs of the output layer)
+     */
+    static void softmax(FixedMatrix<T, OUTPUT_SIZE, 1> &values) {
+        T *v = values.get_data();
+        T max = v[0];
+        for (uint32_t i = 1; i < OUTPUT_SIZE; i++)
+            max = std::max(max, v[i]);
+
+        T sum = 0; /* At least 1, the largest value contributes exp(0) */
+        for (uint32_t i = 0; i < OUTPUT_SIZE; i++) {
+            v[i] = std::exp(v[i] - max);
+            sum += v[i];
+        }
+        const T inverse_sum = 1 / sum;
+        for (uint32_t i = 0; i < OUTPUT_SIZE; i++)
+            v[i] *= inverse_sum;
+    }
+
+    /**
+     * Feed forward from layer L to the output layer (recursion is resolved at compile time)
+     * @tparam L Index of the layer to compute
+     * @param previous_output Output of layer L - 1
+     * @return Output of the neural network
+     */
+    template<size_t L>
+    FixedMatrix<T, OUTPUT_SIZE, 1> feed_forward(const FixedMatrix<T, SIZES[L - 1], 1> &previous_output) const {
+        /* Previous layer output with the bias term appended */
+        FixedMatrix<T, SIZES[L - 1] + 1, 1> inputs;
+        for (uint32_t i = 0; i < SIZES[L - 1]; i++)
+            inputs.set_value(i, 0, previous_output.get_value(i, 0));
+        inputs.set_value(SIZES[L - 1], 0, 1);
+
+        auto outputs = std::get<L - 1>(this->weights) * inputs;
+        if constexpr (L + 1 < NUMBER_OF_LAYERS) {
+            activate(this->activation_functions[L], outputs);
+            return this->feed_forward<L + 1>(outputs);
+        } else {
+            if (this->softmax_output) /* Softmax works with the inputs of the output layer (before activation) */
+                softmax(outputs);
+            else
+                activate(this->activation_functions[L], outputs);
+            return outputs;
+        }
+    }
+
+public:
+    /**
+     * Constructor copying a trained dynamic neural network (topology has to match the template parameters)
+     * @param nn Dynamic neural network
+     */
+    explicit FixedNeuralNetwork(const BasicNeuralNetwork<T> &nn) : softmax_output(nn.is_softmax_output()) {
+        const auto &layers = nn.get_layers();
+        if (layers.size() != NUMBER_OF_LAYERS)
+            throw std::runtime_error("Fixed neural network error: incompatible number of layers");
+
+        for (uint32_t i = 0; i < NUMBER_OF_LAYERS; i++) {
+            if (layers[i]->get_size() != SIZES[i])
+                throw std::runtime_error("Fixed neural network error: incompatible layer size");
+            this->activation_functions[i] = layers[i]->get_activation_function_type();
+            if (this->activation_functions[i] == act_func_type::number_of_activation_functions)
+                throw std::runtime_error("Fixed neural network error: custom activation functions are not supported");
+        }
+
+        this->copy_weights(layers, std::make_index_sequence<NUMBER_OF_LAYERS - 1>{});
+    }
+
+    /**
+     * Predict the output of the neural network for the given inputs
+     * @param inputs Inputs to the neural network (column vector)
+     * @return Output of the neural network (column vector)
+     */
+    FixedMatrix<T, OUTPUT_SIZE, 1> predict(const FixedMatrix<T, INPUT_SIZE, 1> &inputs) const {
+        auto input_layer_output = inputs;
+        activate(this->activation_functions[0], input_layer_output);
+        return this->feed_forward<1>(input_layer_output);
+    }
+    /**
+     * Predict the output of the neural network for the given inputs
+     * @param inputs Inputs to the neural network (row or column, e.g. a row of the data matrix)
+     * @return Output of the neural network (column vector)
+     */
+    FixedMatrix<T, OUTPUT_SIZE, 1> predict(BasicMatrixView<T> inputs) const {
+        if (inputs.get_cols() != 1 and inputs.get_rows() == 1)
+            inputs = inputs.transpose();
+        return this->predict(FixedMatrix<T, INPUT_SIZE, 1>(inputs));
+    }
+    /**
+     * Test the neural network
+     * @param test_data Test data
+     * @return Accuracy of the neural network
+     */
+    double test(const basic_x_y_matrix<T> &test_data) const {
+        double correct = 0;
+        for (uint32_t i = 0; i < test_data.first.get_rows(); i++)
+            if (this->predict(test_data.first.get_row_view(i)).argmax() == test_data.second.get_row_view(i).argmax())
+                correct++; /* Correct prediction */
+        return correct / test_data.first.get_rows();
+    }
+};
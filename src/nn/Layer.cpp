@@ -1,134 +1,174 @@
 #include "Layer.h"
 
-act_func predefined_activation_functions[] = {
-        [](double x) -> double { return x; },                                                       /* linear */
-        [](double x) -> double { return x > 0 ? x : 0; },                                           /* relu */
-        [](double x) -> double { return 1 / (1 + exp(-x)); },                                       /* sigmoid */
-        [](double x) -> double { return x > 0 ? 1 : 0; },                                           /* step */
-        [](double x) -> double { return x > 0 ? 1 : -1; },                                          /* sign */
-        [](double x) -> double { return tanh(x); },                                                 /* tanh */
-};
-
-act_func predefined_derivative_activation_functions[] = {
-        [](double x) -> double { return 1; },                                                       /* linear */
-        [](double x) -> double { return x > 0 ? 1 : 0; },                                           /* relu */
-        [](double x) -> double { return (1 / (1 + exp(-x))) * (1 - (1 / (1 + exp(-x)))); },         /* sigmoid */
-        [](double x) -> double { return 0; },                                                       /* step */
-        [](double x) -> double { return 0; },                                                       /* sign */
-        [](double x) -> double { return 1 - pow(tanh(x), 2); },                                     /* tanh */
-};
-
-std::string act_func_names[] = {
-        "Linear",
-        "ReLU",
-        "Sigmoid",
-        "Step",
-        "Sign",
-        "Tanh",
-};
-
-Layer::Layer(uint32_t size) : size(size), activation_function(nullptr), derivative_activation_function(nullptr) {
-    /* Neurons */
-    this->neurons.reserve(this->size);
-    for (uint32_t i = 0; i < this->size; i++) /* Initialize neurons with 0 */
-        this->neurons.emplace_back(std::make_unique<Neuron>(0));
-}
-
-Layer::Layer(uint32_t size, act_func activation_function) : size(size), activation_function(nullptr), derivative_activation_function(nullptr) {
-    /* Neurons */
-    this->neurons.reserve(this->size);
-    for (uint32_t i = 0; i < this->size; i++) /* Initialize neurons with 0 */
-        this->neurons.emplace_back(std::make_unique<Neuron>(0));
+template<typename T>
+BasicLayer<T>::BasicLayer(uint32_t size) : size(size), inputs(size, 0), outputs(size + 1, 0), derivative_outputs(size, 0) {
+    this->outputs[size] = 1; /* Bias input of the next layer */
+}
+
+template<typename T>
+BasicLayer<T>::BasicLayer(uint32_t size, basic_act_func<T> activation_function) : BasicLayer(size) {
     /* Activation function */
     this->set_activation_function(activation_function);
 }
 
-Layer::Layer(uint32_t size, act_func_type activation_function) : size(size), activation_function(nullptr), derivative_activation_function(nullptr) {
-    /* Neurons */
-    this->neurons.reserve(this->size);
-    for (uint32_t i = 0; i < this->size; i++) /* Initialize neurons with 0 */
-        this->neurons.emplace_back(std::make_unique<Neuron>(0));
+template<typename T>
+BasicLayer<T>::BasicLayer(uint32_t size, act_func_type activation_function) : BasicLayer(size) {
     /* Activation function */
     this->set_activation_function(activation_function);
 }
 
-Layer::~Layer() = default;
+template<typename T>
+BasicLayer<T>::~BasicLayer() = default;
+
+template<typename T>
+void BasicLayer<T>::activate(bool with_derivative) {
+    const uint32_t size = this->size;
+    const uint32_t batch_size = this->batch_size;
+    const T *input = this->inputs.data();
+    T *output = this->outputs.data();
+    T *derivative_output = with_derivative ? this->derivative_outputs.data() : nullptr;
+
+    /* Dispatched once per layer, then one kernel call per sample (output rows are one longer, they end with the bias 1) */
+    std::visit([&](const auto &activation) {
+        for (uint32_t sample = 0; sample < batch_size; sample++)
+            activate_kernel(activation, input + static_cast<size_t>(sample) * size, output + static_cast<size_t>(sample) * (size + 1),
+                            derivative_output ? derivative_output + static_cast<size_t>(sample) * size : nullptr, size);
+    }, this->activation);
+    this->derivative_outputs_valid = with_derivative;
+}
+
+template<typename T>
+void BasicLayer<T>::ensure_derivative_outputs() const {
+    if (this->derivative_outputs_valid)
+        return;
+
+    const uint32_t size = this->size;
+    std::visit([this, size](const auto &activation) {
+        for (uint32_t sample = 0; sample < this->batch_size; sample++)
+            derivative_kernel(activation, this->inputs.data() + static_cast<size_t>(sample) * size,
+                              this->outputs.data() + static_cast<size_t>(sample) * (size + 1),
+                              this->derivative_outputs.data() + static_cast<size_t>(sample) * size, size);
+    }, this->activation);
+    this->derivative_outputs_valid = true;
+}
+
+template<typename T>
+void BasicLayer<T>::bind_weights(T *data, uint32_t rows, uint32_t cols) {
+    this->weights_data = data;
+    this->weights_rows = rows;
+    this->weights_cols = cols;
+    this->invalidate_sparse_weights();
+}
+
+template<typename T>
+void BasicLayer<T>::invalidate_sparse_weights() {
+    this->sparse_weights_valid = false;
+    this->weights_density = -1;
+}
 
-void Layer::activate() {
-    for (auto &neuron : this->neurons) /* Activate each neuron */
-        neuron->activate(this->activation_function, this->derivative_activation_function);
+template<typename T>
+bool BasicLayer<T>::is_pruned() const {
+    return this->pruned;
 }
 
-void Layer::init_weights(uint32_t rows, uint32_t cols) {
-    this->weights = Matrix(rows, cols, true);
+template<typename T>
+void BasicLayer<T>::clear_pruned() {
+    this->pruned = false;
+    this->invalidate_sparse_weights();
 }
 
-void Layer::set_inputs(const Matrix &inputs) {
+template<typename T>
+void BasicLayer<T>::set_inputs(BasicMatrixView<T> inputs) {
+    this->set_batch_size(1);
+    T *input = this->inputs.data();
     for (uint32_t i = 0; i < this->size; i++)
-        this->neurons[i]->set_input(inputs.get_value(i, 0));
+        input[i] = inputs.get_value(i, 0);
 }
 
-void Layer::set_activation_function(act_func new_activation_function) {
-    this->activation_function = new_activation_function;
-    for (int i = 0; i < static_cast<int>(act_func_type::number_of_activation_functions); i++) {
-        if (predefined_activation_functions[i] == new_activation_function) { /* Find the derivative of the activation function */
-            this->set_derivative_activation_function(predefined_derivative_activation_functions[i]);
-            break;
-        }
-    }
+template<typename T>
+void BasicLayer<T>::set_batch_size(uint32_t new_batch_size) {
+    this->derivative_outputs_valid = false;
+    if (new_batch_size == this->batch_size)
+        return;
+
+    this->batch_size = new_batch_size;
+    const size_t elements = static_cast<size_t>(new_batch_size) * this->size;
+    this->inputs.resize(elements);
+    this->outputs.resize(elements + new_batch_size);
+    this->derivative_outputs.resize(elements);
+    for (uint32_t sample = 0; sample < new_batch_size; sample++) /* Bias inputs of the next layer */
+        this->outputs[static_cast<size_t>(sample) * (this->size + 1) + this->size] = 1;
 }
 
-void Layer::set_activation_function(act_func_type new_activation_function) {
-    this->activation_function = predefined_activation_functions[static_cast<uint32_t>(new_activation_function)];
-    this->set_derivative_activation_function(new_activation_function);
+template<typename T>
+uint32_t BasicLayer<T>::get_batch_size() const {
+    return this->batch_size;
 }
 
-void Layer::set_derivative_activation_function(act_func new_derivative_activation_function) {
-    this->derivative_activation_function = new_derivative_activation_function;
+template<typename T>
+void BasicLayer<T>::set_activation_function(basic_act_func<T> new_activation_function) {
+    const auto previous_derivative = Activations::get_derivative<T>(this->activation);
+    this->activation = Activations::from_functions<T>(new_activation_function); /* Predefined or registered pair */
+    if (!Activations::get_derivative<T>(this->activation)) /* Unknown function keeps the derivative it had */
+        this->activation = Activations::from_functions<T>(new_activation_function, previous_derivative);
 }
 
-void Layer::set_derivative_activation_function(act_func_type new_derivative_activation_function) {
-    this->derivative_activation_function = predefined_derivative_activation_functions[static_cast<uint32_t>(new_derivative_activation_function)];
+template<typename T>
+void BasicLayer<T>::set_activation_function(act_func_type new_activation_function) {
+    this->activation = Activations::from_type<T>(new_activation_function);
 }
 
-void Layer::set_weights(Matrix &new_weights) {
-    this->weights = new_weights;
+template<typename T>
+void BasicLayer<T>::set_activation_function(const std::string &name) {
+    this->activation = Activations::from_name<T>(name);
 }
 
-Matrix Layer::get_output() const {
-    Matrix output(this->size, 1, false);
-    for (uint32_t i = 0; i < this->size; i++) /* Get the output of each neuron */
-        output.set_value(i, 0, this->neurons[i]->get_output());
-    return output;
+template<typename T>
+void BasicLayer<T>::set_derivative_activation_function(basic_act_func<T> new_derivative_activation_function) {
+    this->activation = Activations::from_functions<T>(Activations::get_function<T>(this->activation), new_derivative_activation_function);
 }
 
-Matrix Layer::get_softmax_output() const {
-    /* Softmax output is the exponential of the input divided by the sum of the exponentials of all inputs */
-    Matrix softmax_output(this->size, 1, false);
-    for (uint32_t i = 0; i < this->size; i++) /* Get the input of each neuron (before activation) */
-        softmax_output.set_value(i, 0, this->neurons[i]->get_input());
+template<typename T>
+void BasicLayer<T>::set_derivative_activation_function(act_func_type new_derivative_activation_function) {
+    this->set_derivative_activation_function(Activations::get_derivative<T>(Activations::from_type<T>(new_derivative_activation_function)));
+}
 
-    double sum = 0;
-    for (uint32_t i = 0; i < this->size; i++) /* Get the sum of the exponentials of all inputs */
-        sum += exp(softmax_output.get_value(i, 0));
+template<typename T>
+void BasicLayer<T>::set_weights(BasicMatrixView<T> new_weights) {
+    if (new_weights.get_rows() != this->weights_rows || new_weights.get_cols() != this->weights_cols)
+        throw std::runtime_error("Weights have to be " + std::to_string(this->weights_rows) + "x" + std::to_string(this->weights_cols));
+    for (uint32_t i = 0; i < this->weights_rows; i++)
+        for (uint32_t j = 0; j < this->weights_cols; j++)
+            this->weights_data[static_cast<size_t>(i) * this->weights_cols + j] = new_weights.get_value(i, j);
+    this->invalidate_sparse_weights();
+}
 
-    for (uint32_t i = 0; i < this->size; i++) /* Get the softmax output of each neuron */
-        softmax_output.set_value(i, 0, exp(softmax_output.get_value(i, 0)) / sum);
+template<typename T>
+BasicMatrix<T> BasicLayer<T>::get_output(uint32_t sample) const {
+    BasicMatrix<T> output(this->size, 1, false);
+    this->write_output(output.get_data(), sample); /* Column vector, so the data are contiguous */
+    return output;
+}
 
+template<typename T>
+BasicMatrix<T> BasicLayer<T>::get_softmax_output(uint32_t sample) const {
+    BasicMatrix<T> softmax_output(this->size, 1, false);
+    this->write_softmax_output(softmax_output.get_data(), sample);
     return softmax_output;
 }
 
-Matrix Layer::get_derivative_output() const {
-    Matrix derivative_output(this->size, 1, false);
-    for (uint32_t i = 0; i < this->size; i++) /* Get the derivative output of each neuron */
-        derivative_output.set_value(i, 0, this->neurons[i]->get_derivative_output());
+template<typename T>
+BasicMatrix<T> BasicLayer<T>::get_derivative_output(uint32_t sample) const {
+    BasicMatrix<T> derivative_output(this->size, 1, false);
+    this->write_derivative_output(derivative_output.get_data(), sample);
     return derivative_output;
 }
 
-Matrix Layer::get_softmax_derivative_output() const {
+template<typename T>
+BasicMatrix<T> BasicLayer<T>::get_softmax_derivative_output() const {
     /* Softmax derivative output is the derivative of the softmax output */
     /* This function is unused thanks to a trick in maths in the backpropagation algorithm */
-    Matrix softmax_derivative_output(this->size, this->size, false);
+    BasicMatrix<T> softmax_derivative_output(this->size, this->size, false);
     auto softmax_output = this->get_softmax_output(); /* Get the softmax output of the layer */
 
     for (uint32_t i = 0; i < this->size; i++)
@@ -141,17 +181,196 @@ Matrix Layer::get_softmax_derivative_output() const {
     return softmax_derivative_output;
 }
 
-uint32_t Layer::get_size() const {
+template<typename T>
+void BasicLayer<T>::write_output(T *output, uint32_t sample) const {
+    std::copy_n(this->outputs.data() + static_cast<size_t>(sample) * (this->size + 1), this->size, output);
+}
+
+/**
+ * Stable softmax of one sample, optionally with its cross-entropy and the output gradient (see softmax_cross_entropy)
+ * @tparam T Element type (float / double)
+ * @param logits Inputs of the output layer
+ * @param logits_stride Distance of two consecutive logits
+ * @param expected Expected outputs, nullptr for just the softmax
+ * @param expected_stride Distance of two consecutive expected outputs
+ * @param size Number of outputs
+ * @param probabilities Buffer for the probabilities (size elements)
+ * @param gradient Buffer for y - p (size elements), nullptr to skip it
+ * @return Cross-entropy of the sample (0 without expected outputs)
+ */
+template<typename T>
+T softmax_sample(const T *logits, size_t logits_stride, const T *expected, size_t expected_stride, uint32_t size,
+                 T *probabilities, T *gradient) {
+    T max = logits[0];
+    for (uint32_t i = 1; i < size; i++)
+        max = std::max(max, logits[i * logits_stride]);
+
+    /* Shifted logits (all <= 0, so exp cannot overflow), their dot product with y is needed before exp overwrites them */
+    T expected_sum = 0;
+    T expected_dot_shifted = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        probabilities[i] = logits[i * logits_stride] - max;
+        if (expected) {
+            expected_sum += expected[i * expected_stride];
+            expected_dot_shifted += expected[i * expected_stride] * probabilities[i];
+        }
+    }
+    Simd::math<T>().exp(probabilities, probabilities, size); /* Exact or fast exp */
+
+    T sum = 0; /* At least 1, the largest logit contributes exp(0) */
+    for (uint32_t i = 0; i < size; i++)
+        sum += probabilities[i];
+    const T inverse_sum = 1 / sum;
+    for (uint32_t i = 0; i < size; i++)
+        probabilities[i] *= inverse_sum;
+
+    if (!expected)
+        return 0;
+    if (gradient)
+        for (uint32_t i = 0; i < size; i++)
+            gradient[i] = expected[i * expected_stride] - probabilities[i];
+    return expected_sum * std::log(sum) - expected_dot_shifted;
+}
+
+template<typename T>
+void BasicLayer<T>::write_softmax_output(T *output, uint32_t sample) const {
+    /* Softmax output is the exponential of the input divided by the sum of the exponentials of all inputs */
+    softmax_sample<T>(this->inputs.data() + static_cast<size_t>(sample) * this->size, 1, nullptr, 0, this->size, output, nullptr);
+}
+
+template<typename T>
+T BasicLayer<T>::softmax_cross_entropy(BasicMatrixView<T> logits, BasicMatrixView<T> expected_outputs, T *probabilities, T *gradient) {
+    if (logits.get_rows() != expected_outputs.get_rows() || logits.get_cols() != expected_outputs.get_cols())
+        throw std::runtime_error("Logits and expected outputs must have the same shape");
+
+    const uint32_t size = logits.get_cols();
+    T loss = 0;
+    for (uint32_t row = 0; row < logits.get_rows(); row++) {
+        const size_t offset = static_cast<size_t>(row) * size;
+        loss += softmax_sample<T>(logits.get_data() + row * logits.get_row_stride(), logits.get_col_stride(),
+                                  expected_outputs.get_data() + row * expected_outputs.get_row_stride(), expected_outputs.get_col_stride(),
+                                  size, probabilities + offset, gradient ? gradient + offset : nullptr);
+    }
+    return loss;
+}
+
+template<typename T>
+void BasicLayer<T>::write_derivative_output(T *output, uint32_t sample) const {
+    this->ensure_derivative_outputs();
+    std::copy_n(this->derivative_outputs.data() + static_cast<size_t>(sample) * this->size, this->size, output);
+}
+
+template<typename T>
+T *BasicLayer<T>::get_input_data() {
+    return this->inputs.data();
+}
+
+template<typename T>
+const T *BasicLayer<T>::get_output_data() const {
+    return this->outputs.data();
+}
+
+template<typename T>
+const T *BasicLayer<T>::get_derivative_output_data() const {
+    this->ensure_derivative_outputs();
+    return this->derivative_outputs.data();
+}
+
+template<typename T>
+BasicNeuron<T> BasicLayer<T>::get_neuron(uint32_t index) {
+    this->ensure_derivative_outputs();
+    return {&this->inputs[index], &this->outputs[index], &this->derivative_outputs[index]};
+}
+
+template<typename T>
+uint32_t BasicLayer<T>::get_size() const {
     return this->size;
 }
 
-Matrix Layer::get_weights() const {
-    return this->weights;
+template<typename T>
+BasicMatrixView<T> BasicLayer<T>::get_weights() const {
+    return {this->weights_data, this->weights_rows, this->weights_cols, this->weights_cols};
+}
+
+template<typename T>
+T *BasicLayer<T>::get_weights_data() {
+    this->invalidate_sparse_weights(); /* Caller may change the weights */
+    return this->weights_data;
 }
 
-std::string Layer::get_activation_function_name() const {
-    for (int i = 0; i < static_cast<int>(act_func_type::number_of_activation_functions); i++)
-        if (predefined_activation_functions[i] == this->activation_function) /* Find the name of the activation function */
-            return act_func_names[i];
-    return "Unknown";
+template<typename T>
+double BasicLayer<T>::get_weights_density() {
+    if (this->weights_density < 0) {
+        const double elements = static_cast<double>(this->weights_rows) * this->weights_cols;
+        this->weights_density = elements == 0 ? 0 : BasicSparseMatrix<T>::count_non_zeros(this->get_weights()) / elements;
+    }
+    return this->weights_density;
+}
+
+template<typename T>
+const BasicSparseMatrix<T> &BasicLayer<T>::get_sparse_weights() {
+    if (!this->sparse_weights_valid) {
+        this->sparse_weights = BasicSparseMatrix<T>(this->get_weights());
+        this->weights_density = this->sparse_weights.get_density();
+        this->sparse_weights_valid = true;
+    }
+    return this->sparse_weights;
 }
+
+template<typename T>
+void BasicLayer<T>::prune_weights(T threshold) {
+    const uint32_t bias_col = this->weights_cols - 1;
+    for (uint32_t i = 0; i < this->weights_rows; i++) {
+        T *row = this->weights_data + static_cast<size_t>(i) * this->weights_cols;
+        for (uint32_t j = 0; j < bias_col; j++)
+            if (std::abs(row[j]) < threshold)
+                row[j] = 0;
+    }
+    this->invalidate_sparse_weights();
+    this->pruned = true;
+}
+
+template<typename T>
+void BasicLayer<T>::prune_weights_keep_top(double keep_fraction) {
+    const uint32_t bias_col = this->weights_cols - 1;
+    std::vector<T> magnitudes;
+    magnitudes.reserve(static_cast<size_t>(this->weights_rows) * bias_col);
+    for (uint32_t i = 0; i < this->weights_rows; i++)
+        for (uint32_t j = 0; j < bias_col; j++)
+            magnitudes.push_back(std::abs(this->weights_data[static_cast<size_t>(i) * this->weights_cols + j]));
+
+    const auto keep = static_cast<size_t>(std::round(std::clamp(keep_fraction, 0., 1.) * magnitudes.size()));
+    if (keep == magnitudes.size())
+        return;
+    if (keep == 0) { /* Threshold above every magnitude */
+        this->prune_weights(std::numeric_limits<T>::infinity());
+        return;
+    }
+
+    /* keep-th largest magnitude is the threshold (ties at the threshold are all kept) */
+    std::nth_element(magnitudes.begin(), magnitudes.begin() + (keep - 1), magnitudes.end(), std::greater<T>());
+    this->prune_weights(magnitudes[keep - 1]);
+}
+
+template<typename T>
+basic_act_func<T> BasicLayer<T>::get_activation_function() const {
+    return Activations::get_function<T>(this->activation);
+}
+
+template<typename T>
+const basic_activation<T> &BasicLayer<T>::get_activation() const {
+    return this->activation;
+}
+
+template<typename T>
+act_func_type BasicLayer<T>::get_activation_function_type() const {
+    return Activations::get_type<T>(this->activation);
+}
+
+template<typename T>
+std::string BasicLayer<T>::get_activation_function_name() const {
+    return Activations::get_name<T>(this->activation);
+}
+
+template class BasicLayer<float>;
+template class BasicLayer<double>;
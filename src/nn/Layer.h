@@ -4,121 +4,227 @@
 #include <memory>
 #include <random>
 #include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <functional>
 #include "Neuron.h"
+#include "Activation.h"
 #include "../utils/Matrix.h"
-
-/** Activation function type */
-enum class act_func_type {
-    linear = 0,
-    relu,
-    sigmoid,
-    step,
-    sign,
-    tanh,
-    number_of_activation_functions /* Enum trick to get the number of activation functions */
-};
+#include "../utils/SparseMatrix.h"
 
 /**
  * Class representing a layer
  * My layer serves as an array of neurons and it does all the logic behind activations, derivations and weights
+ * Neurons are stored as a structure of arrays (inputs, outputs and derivative outputs of all neurons in contiguous
+ * aligned arrays), so the activation is one loop over the whole layer, BasicNeuron is only a view into them
+ * @tparam T Element type (float / double)
  */
-class Layer {
+template<typename T>
+class BasicLayer {
 private:
     /** Size of the layer (number of neurons) */
     uint32_t size;
-    /** Vector of neurons */
-    std::vector<std::unique_ptr<Neuron>> neurons;
-    /** Activation function of the layer */
-    act_func activation_function;
-    /** Derivative of the activation function of the layer */
-    act_func derivative_activation_function;
-    /** Weights of the layer (weights include bias term) */
-    Matrix weights = Matrix(0, 0);
+    /** Number of samples the layer currently holds (rows of the arrays below) */
+    uint32_t batch_size = 1;
+    /** Inputs of the neurons (already weighted), batch_size x size */
+    std::vector<T, AlignedAllocator<T>> inputs;
+    /** Outputs of the neurons (after activation), each row followed by a constant 1 (bias input of the next layer),
+     * batch_size x (size + 1) */
+    std::vector<T, AlignedAllocator<T>> outputs;
+    /** Derivative outputs of the neurons (after activation with derivative function), computed lazily, batch_size x size */
+    mutable std::vector<T, AlignedAllocator<T>> derivative_outputs;
+    /** Flag whether derivative_outputs belong to the current outputs */
+    mutable bool derivative_outputs_valid = false;
+    /** Activation of the layer (functor of a predefined activation or a custom pair of functions) */
+    basic_activation<T> activation;
+    /** Weights of the layer (weights include bias term), not owned, a block of the parameter buffer of the network
+     * (weights_rows x weights_cols, contiguous rows), nullptr until bound (input layer has no weights) */
+    T *weights_data = nullptr;
+    /** Rows of the weights (number of neurons in this layer) */
+    uint32_t weights_rows = 0;
+    /** Columns of the weights (number of neurons in the previous layer + 1 for the bias term) */
+    uint32_t weights_cols = 0;
+    /** Compressed copy of the weights (built on demand, for the sparse matrix-vector product of pruned layers) */
+    BasicSparseMatrix<T> sparse_weights;
+    /** Flag whether sparse_weights matches the current weights */
+    bool sparse_weights_valid = false;
+    /** Density of the weights (fraction of non-zero weights), negative until computed */
+    double weights_density = -1;
+    /** Flag whether the weights were pruned since the last training update (only pruned layers track the density) */
+    bool pruned = false;
+
+    /**
+     * Compute the derivative outputs from the current inputs and outputs if they are not valid yet
+     * Derivatives of the predefined functions are computed from the outputs where the math allows
+     */
+    void ensure_derivative_outputs() const;
 
 public:
     /**
      * Default constructor
      * @param size Size of the layer (number of neurons)
      */
-    explicit Layer(uint32_t size);
+    explicit BasicLayer(uint32_t size);
     /**
      * Constructor with activation function
      * @param size Size of the layer (number of neurons)
      * @param activation_function Activation function of the layer (as a function pointer)
      */
-    Layer(uint32_t size, act_func activation_function);
+    BasicLayer(uint32_t size, basic_act_func<T> activation_function);
     /**
      * Constructor with activation function
      * @param size Size of the layer (number of neurons)
      * @param activation_function Activation function of the layer (as an enum value)
      */
-    Layer(uint32_t size, act_func_type activation_function);
+    BasicLayer(uint32_t size, act_func_type activation_function);
     /**
      * Default destructor
      */
-    ~Layer();
+    ~BasicLayer();
 
     /**
-     * Activate the layer (each neuron) with the given activation function
+     * Activate the layer (each neuron of each sample of the batch) with the given activation function, one loop over
+     * the arrays
+     * The activation is dispatched once per layer, the kernels are templated on the activation functors (see
+     * Activation.h), so the output and the derivative are produced in one inlined pass, sigmoid and tanh layers go
+     * through the SIMD math kernels (exact or fast, see Simd::get_math_mode), their derivatives are computed from the
+     * outputs
+     * Without the derivative (inference) the derivative outputs are computed later, only if somebody asks for them
+     * @param with_derivative Compute the derivative outputs together with the outputs (back propagation will need them)
      */
-    void activate();
+    void activate(bool with_derivative = true);
 
     /**
-     * Initialize the weights of the layer with random values from -1 to 1
+     * Bind the weights of the layer to a block of the parameter buffer of the network (the layer does not own it,
+     * the values are left as they are)
+     * @param data First weight (rows x cols, contiguous rows)
      * @param rows Rows of the weights matrix (number of neurons in this layer)
      * @param cols Columns of the weights matrix (number of neurons in the previous layer + 1 for the bias term)
      */
-    void init_weights(uint32_t rows, uint32_t cols);
+    void bind_weights(T *data, uint32_t rows, uint32_t cols);
+    /**
+     * Set the inputs of the layer (each neuron) for a single sample (batch of one)
+     * @param inputs Inputs of the layer (each neuron, column, read in place)
+     */
+    void set_inputs(BasicMatrixView<T> inputs);
     /**
-     * Set the inputs of the layer (each neuron)
-     * @param inputs Inputs of the layer (each neuron)
+     * Set the number of samples the layer holds, the arrays grow when needed (their old values are not kept)
+     * @param new_batch_size Number of samples
      */
-    void set_inputs(const Matrix &inputs);
+    void set_batch_size(uint32_t new_batch_size);
+    /**
+     * Get the number of samples the layer holds
+     * @return Number of samples
+     */
+    [[nodiscard]] uint32_t get_batch_size() const;
     /**
      * Set the activation function of the layer
      * @param new_activation_function Activation function of the layer (as a function pointer)
      */
-    void set_activation_function(act_func new_activation_function);
+    void set_activation_function(basic_act_func<T> new_activation_function);
     /**
      * Set the activation function of the layer
      * @param new_activation_function Activation function of the layer (as an enum value)
      */
     void set_activation_function(act_func_type new_activation_function);
+    /**
+     * Set the activation function of the layer
+     * @param name Name of the activation function (predefined or registered with Activations::register_activation)
+     */
+    void set_activation_function(const std::string &name);
     /**
      * Set the derivative of the activation function of the layer
      * @param new_derivative_activation_function Derivative of the activation function of the layer (as a function pointer)
      */
-    void set_derivative_activation_function(act_func new_derivative_activation_function);
+    void set_derivative_activation_function(basic_act_func<T> new_derivative_activation_function);
     /**
      * Set the derivative of the activation function of the layer
      * @param new_derivative_activation_function Derivative of the activation function of the layer (as an enum value)
      */
     void set_derivative_activation_function(act_func_type new_derivative_activation_function);
     /**
-     * Set the weights of the layer
+     * Set the weights of the layer (copied into the bound weights, the dimensions must match)
      * @param new_weights Weights of the layer (weights include bias term)
      */
-    void set_weights(Matrix &new_weights);
+    void set_weights(BasicMatrixView<T> new_weights);
     /**
      * Get the output of the layer (each neuron)
+     * @param sample Sample of the batch
      * @return Output of the layer (each neuron)
      */
-    [[nodiscard]] Matrix get_output() const;
+    [[nodiscard]] BasicMatrix<T> get_output(uint32_t sample = 0) const;
     /**
      * Get the softmax output of the layer (each neuron)
+     * @param sample Sample of the batch
      * @return Softmax output of the layer (each neuron)
      */
-    [[nodiscard]] Matrix get_softmax_output() const;
+    [[nodiscard]] BasicMatrix<T> get_softmax_output(uint32_t sample = 0) const;
     /**
      * Get the derivative output of the layer (each neuron)
+     * @param sample Sample of the batch
      * @return Derivative output of the layer (each neuron)
      */
-    [[nodiscard]] Matrix get_derivative_output() const;
+    [[nodiscard]] BasicMatrix<T> get_derivative_output(uint32_t sample = 0) const;
     /**
      * Get the softmax derivative output of the layer (each neuron)
      * @return Softmax derivative output of the layer (each neuron)
      */
-    [[nodiscard]] Matrix get_softmax_derivative_output() const;
+    [[nodiscard]] BasicMatrix<T> get_softmax_derivative_output() const;
+    /**
+     * Write the output of the layer (each neuron) into the given buffer (no allocation)
+     * @param output Buffer of at least size elements
+     * @param sample Sample of the batch
+     */
+    void write_output(T *output, uint32_t sample = 0) const;
+    /**
+     * Write the softmax output of the layer (each neuron) into the given buffer (no allocation), the largest input is
+     * subtracted first, so large inputs do not overflow
+     * @param output Buffer of at least size elements
+     * @param sample Sample of the batch
+     */
+    void write_softmax_output(T *output, uint32_t sample = 0) const;
+    /**
+     * Numerically stable fused softmax and categorical cross-entropy of a batch (one sample per row), log-sum-exp
+     * p = exp(z - max z) / sum exp(z - max z), loss = -sum y * log p = sum y * log(sum exp(z - max z)) - sum y * (z - max z)
+     * and the output gradient y - p are computed in one pass over each sample, the loss never takes the log of
+     * a probability, so it stays finite even for huge logits or probabilities rounded to zero
+     * @param logits Inputs of the output layer (one sample per row)
+     * @param expected_outputs Expected outputs (one sample per row, same shape as the logits)
+     * @param probabilities Buffer for the softmax probabilities (rows x cols, contiguous rows)
+     * @param gradient Buffer for the output gradient y - p (rows x cols, contiguous rows), nullptr to skip it
+     * @return Cross-entropy summed over the samples
+     */
+    static T softmax_cross_entropy(BasicMatrixView<T> logits, BasicMatrixView<T> expected_outputs, T *probabilities, T *gradient);
+    /**
+     * Write the derivative output of the layer (each neuron) into the given buffer (no allocation)
+     * @param output Buffer of at least size elements
+     * @param sample Sample of the batch
+     */
+    void write_derivative_output(T *output, uint32_t sample = 0) const;
+    /**
+     * Get the inputs of the layer for writing them in place (e.g. the weighted sums of the feed forward)
+     * @return Inputs of the neurons (batch_size x size, contiguous rows)
+     */
+    [[nodiscard]] T *get_input_data();
+    /**
+     * Get the outputs of the layer without copying them
+     * @return Outputs of the neurons, each row followed by a constant 1 for the bias term (batch_size x (size + 1),
+     * contiguous rows)
+     */
+    [[nodiscard]] const T *get_output_data() const;
+    /**
+     * Get the derivative outputs of the layer without copying them
+     * @return Derivative outputs of the neurons (batch_size x size, contiguous rows)
+     */
+    [[nodiscard]] const T *get_derivative_output_data() const;
+    /**
+     * Get a neuron of the layer (view into the arrays of the layer for the first sample of the batch, valid as long as
+     * the layer lives and its batch size does not change)
+     * @param index Index of the neuron
+     * @return Neuron
+     */
+    [[nodiscard]] BasicNeuron<T> get_neuron(uint32_t index);
     /**
      * Get the size of the layer (number of neurons)
      * @return Size of the layer (number of neurons)
@@ -126,11 +232,74 @@ public:
     [[nodiscard]] uint32_t get_size() const;
     /**
      * Get the weights of the layer (weights include bias term)
-     * @return Weights of the layer (weights include bias term)
+     * @return Weights of the layer (weights include bias term, view into the parameter buffer of the network)
+     */
+    [[nodiscard]] BasicMatrixView<T> get_weights() const;
+    /**
+     * Get the weights of the layer for in place updates (weights include bias term), drops the cached sparse weights
+     * @return First weight (rows x cols, contiguous rows)
+     */
+    [[nodiscard]] T *get_weights_data();
+    /**
+     * Forget the cached density and compressed weights (called whenever the weights may change, e.g. after the
+     * network updated its parameter buffer)
+     */
+    void invalidate_sparse_weights();
+    /**
+     * Check whether the weights were pruned (prune_weights, prune_weights_keep_top) since the last training update,
+     * only pruned layers are worth the density scan and the compressed copy
+     * @return True if the layer was pruned
+     */
+    [[nodiscard]] bool is_pruned() const;
+    /**
+     * Forget the pruning (called by the training updates, they regrow the pruned weights), also drops the caches
+     */
+    void clear_pruned();
+    /**
+     * Get the density of the weights (fraction of non-zero weights, bias included), cached until the weights change
+     * @return Density from 0 to 1
+     */
+    [[nodiscard]] double get_weights_density();
+    /**
+     * Get the weights in the compressed sparse row format, cached until the weights change
+     * @return Compressed weights (weights include bias term)
+     */
+    [[nodiscard]] const BasicSparseMatrix<T> &get_sparse_weights();
+    /**
+     * Magnitude pruning, zero all weights with absolute value below the threshold (bias terms are kept), marks the
+     * layer as pruned
+     * @param threshold Weights with smaller absolute value are set to zero
+     */
+    void prune_weights(T threshold);
+    /**
+     * Magnitude pruning, keep only the given fraction of the largest (by absolute value) weights (bias terms are kept)
+     * @param keep_fraction Fraction of the weights to keep (0 to 1)
+     */
+    void prune_weights_keep_top(double keep_fraction);
+    /**
+     * Get the type of the activation function of the layer
+     * @return Type of the activation function (number_of_activation_functions for a custom function)
      */
-    [[nodiscard]] Matrix get_weights() const;
+    [[nodiscard]] act_func_type get_activation_function_type() const;
+    /**
+     * Get the activation function of the layer
+     * @return Activation function of the layer (as a function pointer)
+     */
+    [[nodiscard]] basic_act_func<T> get_activation_function() const;
+    /**
+     * Get the activation of the layer (for kernels templated on the activation functors)
+     * @return Activation of the layer
+     */
+    [[nodiscard]] const basic_activation<T> &get_activation() const;
     /**
      * Get the name of the activation function of the layer
      */
     [[nodiscard]] std::string get_activation_function_name() const;
 };
+
+/* Instantiated in Layer.cpp */
+extern template class BasicLayer<float>;
+extern template class BasicLayer<double>;
+
+/** Layer working with doubles */
+using Layer = BasicLayer<double>;
@@ -1,15 +1,16 @@
 #include "NeuralNetwork.h"
 
-NeuralNetwork::NeuralNetwork(uint32_t input_size,
-                             uint32_t output_size,
-                             const std::vector<uint32_t> &hidden_layers_sizes,
-                             bool softmax_output)
-                             : input_size(input_size), output_size(output_size), training_error(0, 1), gradient{}, softmax_output(softmax_output) {
+template<typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(uint32_t input_size,
+                                          uint32_t output_size,
+                                          const std::vector<uint32_t> &hidden_layers_sizes,
+                                          bool softmax_output)
+                                          : input_size(input_size), output_size(output_size), training_error(0, 1), softmax_output(softmax_output) {
     this->layers.reserve(hidden_layers_sizes.size() + 2); /* +2 for input and output layers */
-    this->layers.emplace_back(std::make_shared<Layer>(this->input_size, act_func_type::linear)); /* input layer is linear */
+    this->layers.emplace_back(std::make_shared<BasicLayer<T>>(this->input_size, act_func_type::linear)); /* input layer is linear */
     for (auto &hidden_layer_size : hidden_layers_sizes)
-        this->layers.emplace_back(std::make_shared<Layer>(hidden_layer_size));
-    this->layers.emplace_back(std::make_shared<Layer>(this->output_size));
+        this->layers.emplace_back(std::make_shared<BasicLayer<T>>(hidden_layer_size));
+    this->layers.emplace_back(std::make_shared<BasicLayer<T>>(this->output_size));
 
     /* Initialize weights */
     this->init_weights();
@@ -17,17 +18,18 @@ NeuralNetwork::NeuralNetwork(uint32_t input_size,
     this->reset_gradient();
 }
 
-NeuralNetwork::NeuralNetwork(uint32_t input_size,
-                             uint32_t output_size,
-                             const std::vector<uint32_t> &hidden_layers_sizes,
-                             act_func activation_function,
-                             bool softmax_output)
-                             : input_size(input_size), output_size(output_size), training_error(0, 1), gradient{}, softmax_output(softmax_output) {
+template<typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(uint32_t input_size,
+                                          uint32_t output_size,
+                                          const std::vector<uint32_t> &hidden_layers_sizes,
+                                          basic_act_func<T> activation_function,
+                                          bool softmax_output)
+                                          : input_size(input_size), output_size(output_size), training_error(0, 1), softmax_output(softmax_output) {
     this->layers.reserve(hidden_layers_sizes.size() + 2); /* +2 for input and output layers */
-    this->layers.emplace_back(std::make_shared<Layer>(this->input_size, act_func_type::linear)); /* input layer is linear */
+    this->layers.emplace_back(std::make_shared<BasicLayer<T>>(this->input_size, act_func_type::linear)); /* input layer is linear */
     for (auto &hidden_layer_size : hidden_layers_sizes)
-        this->layers.emplace_back(std::make_shared<Layer>(hidden_layer_size, activation_function));
-    this->layers.emplace_back(std::make_shared<Layer>(this->output_size, activation_function));
+        this->layers.emplace_back(std::make_shared<BasicLayer<T>>(hidden_layer_size, activation_function));
+    this->layers.emplace_back(std::make_shared<BasicLayer<T>>(this->output_size, activation_function));
 
     /* Initialize weights */
     this->init_weights();
@@ -35,17 +37,18 @@ NeuralNetwork::NeuralNetwork(uint32_t input_size,
     this->reset_gradient();
 }
 
-NeuralNetwork::NeuralNetwork(uint32_t input_size,
-                             uint32_t output_size,
-                             const std::vector<uint32_t> &hidden_layers_sizes,
-                             act_func_type activation_function,
-                             bool softmax_output)
-                             : input_size(input_size), output_size(output_size), training_error(0, 1), gradient{}, softmax_output(softmax_output) {
+template<typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(uint32_t input_size,
+                                          uint32_t output_size,
+                                          const std::vector<uint32_t> &hidden_layers_sizes,
+                                          act_func_type activation_function,
+                                          bool softmax_output)
+                                          : input_size(input_size), output_size(output_size), training_error(0, 1), softmax_output(softmax_output) {
     this->layers.reserve(hidden_layers_sizes.size() + 2); /* +2 for input and output layers */
-    this->layers.emplace_back(std::make_shared<Layer>(this->input_size, act_func_type::linear)); /* input layer is linear */
+    this->layers.emplace_back(std::make_shared<BasicLayer<T>>(this->input_size, act_func_type::linear)); /* input layer is linear */
     for (auto &hidden_layer_size : hidden_layers_sizes)
-        this->layers.emplace_back(std::make_shared<Layer>(hidden_layer_size, activation_function));
-    this->layers.emplace_back(std::make_shared<Layer>(this->output_size, activation_function));
+        this->layers.emplace_back(std::make_shared<BasicLayer<T>>(hidden_layer_size, activation_function));
+    this->layers.emplace_back(std::make_shared<BasicLayer<T>>(this->output_size, activation_function));
 
     /* Initialize weights */
     this->init_weights();
@@ -53,171 +56,471 @@ NeuralNetwork::NeuralNetwork(uint32_t input_size,
     this->reset_gradient();
 }
 
-NeuralNetwork::~NeuralNetwork() = default;
+template<typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(const BasicNeuralNetwork<T> &nn)
+                                          : input_size(nn.input_size), output_size(nn.output_size), training_error(nn.training_error),
+                                            parameters(nn.parameters), gradients(nn.gradients.size(), T(0)),
+                                            parameter_offsets(nn.parameter_offsets), optimizer(nn.optimizer), softmax_output(nn.softmax_output),
+                                            sparse_density_cutoff(nn.sparse_density_cutoff), data_parallel_shards(nn.data_parallel_shards),
+                                            asynchronous_workers(nn.asynchronous_workers), worker_optimizers(nn.worker_optimizers) {
+    this->layers.reserve(nn.layers.size());
+    for (auto &layer : nn.layers)
+        this->layers.emplace_back(std::make_shared<BasicLayer<T>>(*layer));
+    this->bind_layers(this->parameters.data());
+}
 
-void NeuralNetwork::set_input(const Matrix &inputs) {
-    auto input = inputs;
-    if (input.get_dims()[1] != 1 and input.get_dims()[0] == 1)
-        input = input.transpose();
-    this->layers[0]->set_inputs(input);
+template<typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(const BasicNeuralNetwork<T> &nn, T *shared_parameters)
+                                          : input_size(nn.input_size), output_size(nn.output_size), training_error(0, 1),
+                                            gradients(nn.gradients.size(), T(0)), parameter_offsets(nn.parameter_offsets),
+                                            softmax_output(nn.softmax_output), sparse_density_cutoff(nn.sparse_density_cutoff) {
+    this->layers.reserve(nn.layers.size());
+    for (auto &layer : nn.layers)
+        this->layers.emplace_back(std::make_shared<BasicLayer<T>>(*layer));
+    this->bind_layers(shared_parameters);
 }
 
-Matrix NeuralNetwork::get_output() const {
+template<typename T>
+BasicNeuralNetwork<T>::~BasicNeuralNetwork() = default;
+
+template<typename T>
+void BasicNeuralNetwork<T>::set_input(BasicMatrixView<T> inputs) {
+    if (inputs.get_cols() != 1 and inputs.get_rows() == 1)
+        inputs = inputs.transpose(); /* Only the strides are swapped, no copy */
+    this->layers[0]->set_inputs(inputs);
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::set_input_rows(BasicMatrixView<T> data, const uint32_t *rows, uint32_t count) {
+    auto &input_layer = this->layers[0];
+    input_layer->set_batch_size(count);
+    T *input = input_layer->get_input_data();
+    for (uint32_t sample = 0; sample < count; sample++) {
+        const uint32_t row = rows ? rows[sample] : sample;
+        for (uint32_t i = 0; i < this->input_size; i++)
+            input[static_cast<size_t>(sample) * this->input_size + i] = data.get_value(row, i);
+    }
+}
+
+template<typename T>
+BasicMatrixView<T> BasicNeuralNetwork<T>::get_output() {
+    auto &output_layer = this->layers.back();
+    T *output = this->workspace.allocate(output_layer->get_size());
     if (this->softmax_output)
-        return this->layers.back()->get_softmax_output();
-    return this->layers.back()->get_output();
+        output_layer->write_softmax_output(output);
+    else
+        output_layer->write_output(output);
+    return {output, output_layer->get_size(), 1, 1};
 }
 
-const std::vector<std::shared_ptr<Layer>> &NeuralNetwork::get_layers() const {
+template<typename T>
+const std::vector<std::shared_ptr<BasicLayer<T>>> &BasicNeuralNetwork<T>::get_layers() const {
     return this->layers;
 }
 
-Matrix NeuralNetwork::get_training_error() const {
+template<typename T>
+BasicMatrix<T> BasicNeuralNetwork<T>::get_training_error() const {
     return this->training_error;
 }
 
-void NeuralNetwork::init_weights() {
+template<typename T>
+bool BasicNeuralNetwork<T>::is_softmax_output() const {
+    return this->softmax_output;
+}
+
+template<typename T>
+const BasicWorkspace<T> &BasicNeuralNetwork<T>::get_workspace() const {
+    return this->workspace;
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::get_sparse_density_cutoff() const {
+    return this->sparse_density_cutoff;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::set_sparse_density_cutoff(double cutoff) {
+    this->sparse_density_cutoff = cutoff;
+}
+
+template<typename T>
+uint32_t BasicNeuralNetwork<T>::get_data_parallel_shards() const {
+    return this->data_parallel_shards;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::set_data_parallel_shards(uint32_t shards) {
+    this->data_parallel_shards = std::max(shards, 1u);
+}
+
+template<typename T>
+uint32_t BasicNeuralNetwork<T>::get_asynchronous_workers() const {
+    return this->asynchronous_workers;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::set_asynchronous_workers(uint32_t workers) {
+    this->asynchronous_workers = workers;
+    this->worker_optimizers.clear();
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::prune(double threshold) {
+    for (uint32_t i = 1; i < this->layers.size(); i++)
+        this->layers[i]->prune_weights(static_cast<T>(threshold));
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::prune_keep_top(double keep_fraction) {
+    for (uint32_t i = 1; i < this->layers.size(); i++)
+        this->layers[i]->prune_weights_keep_top(keep_fraction);
+}
+
+template<typename T>
+const std::vector<T, AlignedAllocator<T>> &BasicNeuralNetwork<T>::get_parameters() const {
+    return this->parameters;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::set_parameters(const std::vector<T, AlignedAllocator<T>> &new_parameters) {
+    if (new_parameters.size() != this->parameters.size())
+        throw std::runtime_error("Parameters have to have " + std::to_string(this->parameters.size()) + " elements");
+    std::copy(new_parameters.begin(), new_parameters.end(), this->parameters.begin());
+    for (uint32_t i = 1; i < this->layers.size(); i++)
+        this->layers[i]->invalidate_sparse_weights();
+}
+
+template<typename T>
+const std::vector<T, AlignedAllocator<T>> &BasicNeuralNetwork<T>::get_gradients() const {
+    return this->gradients;
+}
+
+template<typename T>
+size_t BasicNeuralNetwork<T>::get_parameter_offset(uint32_t layer) const {
+    if (layer == 0 || layer >= this->layers.size())
+        throw std::runtime_error("Layer " + std::to_string(layer) + " has no weights");
+    return this->parameter_offsets[layer - 1];
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::allocate_parameters() {
+    /* Blocks of the layers one after another, each one starts aligned (so the kernels get aligned rows) */
+    constexpr size_t lanes = MATRIX_ALIGNMENT / sizeof(T);
+    size_t total = 0;
+    this->parameter_offsets.clear();
+    for (uint32_t i = 1; i < this->layers.size(); i++) {
+        this->parameter_offsets.push_back(total);
+        const size_t elements = static_cast<size_t>(this->layers[i]->get_size()) * (this->layers[i - 1]->get_size() + 1); /* +1 for bias */
+        total += (elements + lanes - 1) / lanes * lanes;
+    }
+
+    this->parameters.assign(total, T(0));
+    this->gradients.assign(total, T(0));
+    this->bind_layers(this->parameters.data());
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::bind_layers(T *parameter_data) {
+    for (uint32_t i = 1; i < this->layers.size(); i++)
+        this->layers[i]->bind_weights(parameter_data + this->parameter_offsets[i - 1], this->layers[i]->get_size(),
+                                      this->layers[i - 1]->get_size() + 1); /* +1 for bias */
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::init_weights() {
+    this->allocate_parameters();
     for (uint32_t i = 1; i < this->layers.size(); i++) {
         auto &previous_layer = this->layers[i - 1];
         auto &current_layer = this->layers[i];
-        current_layer->init_weights(current_layer->get_size(), previous_layer->get_size() + 1); // +1 for bias
+        current_layer->set_weights(BasicMatrix<T>(current_layer->get_size(), previous_layer->get_size() + 1, true)); // +1 for bias
     }
 }
 
-void NeuralNetwork::reset_gradient() {
-    this->gradient.clear(); /* Clear previous gradient */
-    this->gradient.reserve(this->layers.size() - 1);
-    for (uint32_t i = 1; i < this->layers.size(); i++)
-        this->gradient.emplace_back();
+template<typename T>
+void BasicNeuralNetwork<T>::reset_gradient() {
+    this->gradient_samples = 0;
+    std::fill(this->gradients.begin(), this->gradients.end(), T(0));
 }
 
-double NeuralNetwork::loss(const Matrix &expected_output) {
-    auto nn_output = this->get_output().transpose();
-    if (this->softmax_output) { /* Categorical cross-entropy */
-        return -((expected_output * nn_output.log().transpose()).get_value(0, 0));
-    } /* Mean squared error */
-    auto error = expected_output - nn_output;
-    return ((error * error.transpose()).get_value(0, 0)) / 2;
+template<typename T>
+T BasicNeuralNetwork<T>::output_loss_and_delta(BasicMatrixView<T> expected_output, T *delta) {
+    auto &output_layer = this->layers.back();
+    const uint32_t size = output_layer->get_size();
+    const uint32_t batch_size = output_layer->get_batch_size();
+    if (this->softmax_output) { /* Categorical cross-entropy, delta = y - p */
+        T *probabilities = this->workspace.allocate(static_cast<size_t>(batch_size) * size);
+        return BasicLayer<T>::softmax_cross_entropy({output_layer->get_input_data(), batch_size, size, size}, expected_output,
+                                                    probabilities, delta);
+    } /* Mean squared error, delta = (y - o) * f'(z) */
+    const T *output = output_layer->get_output_data();
+    const T *derivative_output = delta ? output_layer->get_derivative_output_data() : nullptr;
+    T error = 0;
+    for (uint32_t sample = 0; sample < batch_size; sample++)
+        for (uint32_t i = 0; i < size; i++) {
+            const T diff = expected_output.get_value(sample, i) - output[static_cast<size_t>(sample) * (size + 1) + i];
+            error += diff * diff;
+            if (delta)
+                delta[static_cast<size_t>(sample) * size + i] = diff * derivative_output[static_cast<size_t>(sample) * size + i];
+        }
+    return error / 2;
+}
+
+template<typename T>
+T BasicNeuralNetwork<T>::loss(BasicMatrixView<T> expected_output) {
+    return this->output_loss_and_delta(expected_output, nullptr);
 }
 
-void NeuralNetwork::feed_forward() {
-    this->layers[0]->activate(); /* input layer activation (linear, so just copy inputs) */
+template<typename T>
+void BasicNeuralNetwork<T>::feed_forward(bool with_derivatives) {
+    const uint32_t batch_size = this->layers[0]->get_batch_size();
+    this->layers[0]->activate(false); /* input layer activation (linear, so just copy inputs), no delta goes back to it */
     for (uint32_t i = 1; i < this->layers.size(); i++) {
         auto &previous_layer = this->layers[i - 1];
         auto &current_layer = this->layers[i];
+        const uint32_t previous_size = previous_layer->get_size();
+        const uint32_t current_size = current_layer->get_size();
+        current_layer->set_batch_size(batch_size);
+
+        /* Previous layer outputs already end with the bias term (one row per sample) */
+        const T *inputs = previous_layer->get_output_data();
+
+        /* Weighted inputs = inputs * weights^T, written straight into the inputs of the current layer, the whole batch
+         * is one matrix-matrix product (weights are read once per batch), a single sample is a matrix-vector product
+         * and pruned layers use the sparse matrix-vector product per sample (only pruned layers pay for the density
+         * scan, training clears the flag) */
+        T *weighted_inputs = current_layer->get_input_data();
+        if (this->sparse_density_cutoff > 0 && current_layer->is_pruned() &&
+            current_layer->get_weights_density() < this->sparse_density_cutoff) {
+            const auto &sparse_weights = current_layer->get_sparse_weights();
+            std::fill(weighted_inputs, weighted_inputs + static_cast<size_t>(batch_size) * current_size, T(0));
+            for (uint32_t sample = 0; sample < batch_size; sample++)
+                sparse_weights.multiply_vector(T(1), inputs + static_cast<size_t>(sample) * (previous_size + 1),
+                                               weighted_inputs + static_cast<size_t>(sample) * current_size);
+        } else {
+            const auto weights = std::as_const(*current_layer).get_weights();
+            if (batch_size == 1)
+                Backend::kernels<T>().gemv(current_size, previous_size + 1, T(1), weights.get_data(), weights.get_row_stride(),
+                                           transpose_op::none, inputs, T(0), weighted_inputs);
+            else
+                Backend::kernels<T>().gemm(batch_size, current_size, previous_size + 1, T(1), inputs, previous_size + 1,
+                                           transpose_op::none, weights.get_data(), weights.get_row_stride(), transpose_op::transpose,
+                                           T(0), weighted_inputs, current_size);
+        }
 
-        auto inputs = previous_layer->get_output(); /* previous layer output */
-        inputs.add_row({1.}); /* add bias */
+        current_layer->activate(with_derivatives);
+    }
+}
 
-        auto weights = current_layer->get_weights();
+template<typename T>
+T BasicNeuralNetwork<T>::back_propagation(BasicMatrixView<T> expected_outputs) {
+    /* Calculate output layer deltas (one row per sample) together with the loss */
+    auto &output_layer = this->layers.back();
+    const uint32_t output_size = output_layer->get_size();
+    const uint32_t batch_size = output_layer->get_batch_size();
+    T *output_deltas = this->workspace.allocate(static_cast<size_t>(batch_size) * output_size);
+    const T batch_loss = this->output_loss_and_delta(expected_outputs, output_deltas);
+
+    /* Walk the layers backwards with the deltas of the whole batch (one row per sample), two GEMMs per layer */
+    const T *delta = output_deltas;
+    uint32_t delta_stride = output_size;
+    for (uint32_t i = this->layers.size() - 1; i > 0; i--) {
+        auto &previous_layer = this->layers[i - 1];
+        const uint32_t previous_size = previous_layer->get_size();
+        const uint32_t current_size = this->layers[i]->get_size();
+        const T *previous_layer_outputs = previous_layer->get_output_data(); /* Rows end with the bias term */
 
-        inputs = weights * inputs; /* matrix multiplication */
+        /* gradient += deltas^T * previous_layer_outputs, the sum of the outer products of all samples in one product,
+         * accumulated straight into the block of the layer in the gradient buffer */
+        Backend::kernels<T>().gemm(current_size, previous_size + 1, batch_size, T(1), delta, delta_stride, transpose_op::transpose,
+                                   previous_layer_outputs, previous_size + 1, transpose_op::none, T(1),
+                                   this->gradients.data() + this->parameter_offsets[i - 1], previous_size + 1);
 
-        current_layer->set_inputs(inputs);
-        current_layer->activate();
-    }
-}
+        if (i == 1) /* Input layer has no weights, nothing to propagate to */
+            break;
 
-void NeuralNetwork::back_propagation(const Matrix &expected_output) {
-    std::vector<Matrix> cached_gradients = {};  /* Cache gradients for hidden layers */
+        /* Propagate the deltas through the weights (deltas * W), the last column of the result belongs to the bias and is ignored */
+        const auto weights = std::as_const(*this->layers[i]).get_weights();
+        T *previous_deltas = this->workspace.allocate(static_cast<size_t>(batch_size) * (previous_size + 1));
+        Backend::kernels<T>().gemm(batch_size, previous_size + 1, current_size, T(1), delta, delta_stride, transpose_op::none,
+                                   weights.get_data(), weights.get_row_stride(), transpose_op::none, T(0), previous_deltas, previous_size + 1);
 
-    /* Calculate output layer gradients */
-    auto &output_layer = this->layers.back();
-    auto output_layer_output = this->get_output(); /* gets softmax output if softmax_output is true */
-    auto output_layer_derivative_output = output_layer->get_derivative_output();
-
-    auto &previous_layer = this->layers[this->layers.size() - 2];
-    auto previous_layer_output = previous_layer->get_output();
-    previous_layer_output.add_row({1.}); /* bias */
-
-    Matrix output_layer_gradients = (expected_output - output_layer_output.transpose());
-    if (!(this->softmax_output)) { /* Mean squared error */
-        for (uint32_t i = 0; i < output_layer_gradients.get_dims()[1]; i++) {
-            auto value = output_layer_gradients.get_value(0, i) * output_layer_derivative_output.get_value(i, 0);
-            output_layer_gradients.set_value(0, i, value);
+        const T *previous_layer_derivative_outputs = previous_layer->get_derivative_output_data();
+        for (uint32_t sample = 0; sample < batch_size; sample++) {
+            T *row = previous_deltas + static_cast<size_t>(sample) * (previous_size + 1);
+            Backend::kernels<T>().mul(row, previous_layer_derivative_outputs + static_cast<size_t>(sample) * previous_size, row, previous_size);
         }
+
+        delta = previous_deltas;
+        delta_stride = previous_size + 1;
     }
 
-    cached_gradients.emplace_back(output_layer_gradients); /* Cache this part of the gradient for previous layer */
-    output_layer_gradients = output_layer_gradients.transpose() * previous_layer_output.transpose();
+    this->gradient_samples += batch_size;
+    return batch_loss;
+}
 
-    this->gradient[this->gradient.size() - 1].emplace_back(output_layer_gradients);
+template<typename T>
+T BasicNeuralNetwork<T>::train_batch(basic_x_y_matrix<T> &training_data, const uint32_t *rows, uint32_t count) {
+    this->workspace.reset(); /* Release the temporaries of the previous batch */
 
-    /* Calculate hidden layers gradients */
-    for (uint32_t i = this->layers.size() - 2; i > 0; i--) {
-        auto &current_layer = this->layers[i];
-        auto current_layer_derivative_output = current_layer->get_derivative_output();
-        current_layer_derivative_output.add_row({1.}); /* bias */
+    /* Gather the samples of the batch (inputs straight into the input layer, expected outputs into the workspace) */
+    this->set_input_rows(training_data.first, rows, count);
+    T *expected_outputs = this->workspace.allocate(static_cast<size_t>(count) * this->output_size);
+    for (uint32_t j = 0; j < count; j++)
+        for (uint32_t k = 0; k < this->output_size; k++)
+            expected_outputs[static_cast<size_t>(j) * this->output_size + k] = training_data.second.get_value(rows[j], k);
 
-        auto &next_layer = this->layers[i + 1];
-        auto next_layer_gradients = cached_gradients[this->layers.size() - 2 - i];
-        auto next_layer_weights = next_layer->get_weights();
-        next_layer_weights.remove_col(next_layer_weights.get_dims()[1] - 1); /* remove bias */
+    /* Train on batch, the whole batch goes through every layer at once */
+    this->feed_forward(); /* Feed forward */
+    return this->back_propagation({expected_outputs, count, this->output_size, this->output_size}); /* Back propagation, returns the error of the batch */
+}
 
-        auto &previous_layer = this->layers[i - 1];
-        auto previous_layer_output = previous_layer->get_output();
-        previous_layer_output.add_row({1.}); /* bias */
+template<typename T>
+T BasicNeuralNetwork<T>::train_batch_data_parallel(basic_x_y_matrix<T> &training_data, const std::vector<uint32_t> &batch,
+                                                   const std::vector<std::unique_ptr<BasicNeuralNetwork<T>>> &replicas) {
+    const auto shards = static_cast<uint32_t>(replicas.size() + 1);
+    const auto batch_rows = static_cast<uint32_t>(batch.size());
+
+    /* Forward and backward pass of each shard (contiguous part of the batch) on its own activations and gradient */
+    std::vector<T> losses(shards);
+    ThreadPool::parallel_for(shards, [&](uint32_t shard) {
+        auto &nn = shard == 0 ? *this : *replicas[shard - 1];
+        const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(batch_rows) * shard / shards);
+        const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(batch_rows) * (shard + 1) / shards);
+        if (shard > 0) /* Shared weights were updated by the previous batch (that also cleared the pruning of this network) */
+            for (uint32_t i = 1; i < nn.layers.size(); i++) {
+                if (this->layers[i]->is_pruned())
+                    nn.layers[i]->invalidate_sparse_weights();
+                else
+                    nn.layers[i]->clear_pruned();
+            }
+        nn.reset_gradient();
+        losses[shard] = nn.train_batch(training_data, batch.data() + begin, end - begin);
+    });
+
+    /* Pairwise tree reduction into the gradient of the first shard (this network), fixed order of the additions,
+     * the buffer is split into chunks, each chunk is reduced by one task */
+    std::vector<T *> shard_gradients(shards);
+    for (uint32_t shard = 0; shard < shards; shard++)
+        shard_gradients[shard] = shard == 0 ? this->gradients.data() : replicas[shard - 1]->gradients.data();
+    const size_t total = this->gradients.size();
+    const auto chunks = static_cast<uint32_t>((total + REDUCTION_CHUNK - 1) / REDUCTION_CHUNK);
+    ThreadPool::parallel_for(chunks, [&](uint32_t chunk) {
+        const size_t begin = static_cast<size_t>(chunk) * REDUCTION_CHUNK;
+        const size_t count = std::min(REDUCTION_CHUNK, total - begin);
+        for (uint32_t stride = 1; stride < shards; stride *= 2)
+            for (uint32_t shard = 0; shard + stride < shards; shard += 2 * stride)
+                Backend::kernels<T>().add(shard_gradients[shard] + begin, shard_gradients[shard + stride] + begin,
+                                          shard_gradients[shard] + begin, count);
+    });
+    for (uint32_t stride = 1; stride < shards; stride *= 2)
+        for (uint32_t shard = 0; shard + stride < shards; shard += 2 * stride)
+            losses[shard] += losses[shard + stride];
+
+    this->gradient_samples = batch_rows;
+    return losses[0];
+}
 
-        auto current_layer_gradients = (next_layer_gradients * next_layer_weights).transpose();
-        for (uint32_t j = 0; j < current_layer_gradients.get_dims()[1]; j++) {
-            auto value = current_layer_gradients.get_value(0, j) * current_layer_derivative_output.get_value(j, 0);
-            current_layer_gradients.set_value(0, j, value);
-        }
+template<typename T>
+std::vector<std::unique_ptr<BasicNeuralNetwork<T>>> BasicNeuralNetwork<T>::make_replicas(uint32_t count) {
+    std::vector<std::unique_ptr<BasicNeuralNetwork<T>>> replicas;
+    replicas.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+        replicas.emplace_back(new BasicNeuralNetwork<T>(*this, this->parameters.data()));
+    return replicas;
+}
 
-        cached_gradients.emplace_back(current_layer_gradients.transpose()); /* Cache this part of the gradient for previous layer */
-        current_layer_gradients = current_layer_gradients * previous_layer_output.transpose();
+template<typename T>
+double BasicNeuralNetwork<T>::train_asynchronous(basic_x_y_matrix<T> &training_data, const std::vector<std::vector<uint32_t>> &batches, double learning_rate) {
+    const auto workers = static_cast<uint32_t>(std::min<size_t>(this->asynchronous_workers, std::max<size_t>(batches.size(), 1)));
+    const auto replicas = this->make_replicas(workers - 1);
+    T *shared_parameters = this->parameters.data();
+    const size_t total = this->parameters.size();
+
+    /* Other workers start with the hyperparameters of the optimizer of this network and zero state */
+    if (this->worker_optimizers.size() < workers - 1) {
+        auto worker_optimizer = this->optimizer;
+        worker_optimizer.reset();
+        this->worker_optimizers.resize(workers - 1, worker_optimizer);
+    }
 
-        this->gradient[i - 1].emplace_back(current_layer_gradients);
+    /* Workers keep changing the shared weights, so the pruning is gone from the first update on */
+    for (uint32_t i = 1; i < this->layers.size(); i++) {
+        this->layers[i]->clear_pruned();
+        for (auto &replica : replicas)
+            replica->layers[i]->clear_pruned();
     }
+
+    std::atomic<uint32_t> next_batch(0);
+    std::vector<double> losses(workers, 0.);
+    ThreadPool::parallel_for(workers, [&](uint32_t worker) {
+        auto &nn = worker == 0 ? *this : *replicas[worker - 1];
+        auto &worker_optimizer = worker == 0 ? this->optimizer : this->worker_optimizers[worker - 1];
+        for (uint32_t b = next_batch.fetch_add(1, std::memory_order_relaxed); b < batches.size(); b = next_batch.fetch_add(1, std::memory_order_relaxed)) {
+            const auto &batch = batches[b];
+            nn.reset_gradient();
+            losses[worker] += nn.train_batch(training_data, batch.data(), static_cast<uint32_t>(batch.size()));
+
+            /* Lock-free update of the shared weights (plain SGD: weights += learning_rate / samples * gradient) */
+            worker_optimizer.step(shared_parameters, nn.gradients.data(), total, learning_rate, nn.gradient_samples);
+        }
+    });
+
+    this->reset_gradient();
+    return std::accumulate(losses.begin(), losses.end(), 0.);
 }
 
-void NeuralNetwork::update_weights(double learning_rate) {
-    /* Average gradients over batches */
-    std::vector<Matrix> averaged_gradients = {};
+template<typename T>
+void BasicNeuralNetwork<T>::update_weights(double learning_rate) {
+    if (this->gradient_samples == 0)
+        return;
 
-    for (auto &grad_matrices : this->gradient) {
-        /* Sum gradients */
-        Matrix averaged_gradient(grad_matrices[0].get_dims()[0], grad_matrices[0].get_dims()[1], false);
-        for (auto &grad : grad_matrices) {
-            for (uint32_t i = 0; i < grad.get_dims()[0]; i++)
-                for (uint32_t j = 0; j < grad.get_dims()[1]; j++)
-                    averaged_gradient.set_value(i, j, averaged_gradient.get_value(i, j) + grad.get_value(i, j));
-        }
-        /* Average gradients */
-        for (uint32_t i = 0; i < averaged_gradient.get_dims()[0]; i++)
-            for (uint32_t j = 0; j < averaged_gradient.get_dims()[1]; j++)
-                averaged_gradient.set_value(i, j, averaged_gradient.get_value(i, j) / grad_matrices.size());
+    /* Averaged gradient is applied in place by the optimizer (plain SGD: weights += learning_rate / samples * gradient),
+     * one pass over the whole parameter buffer (padding is zero in all buffers, so it stays zero) */
+    this->optimizer.step(this->parameters.data(), this->gradients.data(), this->parameters.size(), learning_rate, this->gradient_samples);
+    for (uint32_t i = 1; i < this->layers.size(); i++) /* Pruned weights regrow, so the layers are dense again */
+        this->layers[i]->clear_pruned();
+}
 
-        averaged_gradients.emplace_back(std::move(averaged_gradient));
-    }
+template<typename T>
+const BasicOptimizer<T> &BasicNeuralNetwork<T>::get_optimizer() const {
+    return this->optimizer;
+}
 
-    for (uint32_t i = 1; i < this->layers.size(); i++) {
-        auto &current_layer = this->layers[i];
+template<typename T>
+void BasicNeuralNetwork<T>::set_optimizer(const BasicOptimizer<T> &new_optimizer) {
+    this->optimizer = new_optimizer;
+    this->worker_optimizers.clear();
+}
 
-        auto weights = current_layer->get_weights();
-        auto gradients = averaged_gradients[i - 1];
+template<typename T>
+void BasicNeuralNetwork<T>::set_optimizer(optimizer_type type) {
+    this->optimizer = BasicOptimizer<T>(type);
+    this->worker_optimizers.clear();
+}
 
-        /* Update weights */
-        auto new_weights = weights + (gradients * learning_rate);
-        current_layer->set_weights(new_weights);
-    }
+template<typename T>
+void BasicNeuralNetwork<T>::train(basic_x_y_matrix<T> &training_data, uint32_t epochs, double learning_rate, uint32_t batch_size, optimizer_type optimizer, bool verbose, double min_loss, double delta_loss) {
+    this->set_optimizer(optimizer);
+    this->train(training_data, epochs, learning_rate, batch_size, verbose, min_loss, delta_loss);
 }
 
-void NeuralNetwork::train(x_y_matrix &training_data, uint32_t epochs, double learning_rate, uint32_t batch_size, bool verbose, double min_loss, double delta_loss) {
+template<typename T>
+void BasicNeuralNetwork<T>::train(basic_x_y_matrix<T> &training_data, uint32_t epochs, double learning_rate, uint32_t batch_size, bool verbose, double min_loss, double delta_loss) {
     for (int i = 1; i <= epochs; i++) {
         this->train_one_step(training_data, i, learning_rate, batch_size, verbose);
 
-        if ((this->training_error.get_row(i - 1).get_value(0, 0) <= min_loss) ||
-            (i > 1 && std::abs(this->training_error.get_row(i - 1).get_value(0, 0) - this->training_error.get_row(i - 2).get_value(0, 0)) <= delta_loss))
+        if ((this->training_error.get_value(i - 1, 0) <= min_loss) ||
+            (i > 1 && std::abs(this->training_error.get_value(i - 1, 0) - this->training_error.get_value(i - 2, 0)) <= delta_loss))
             break;
     }
 }
 
-void NeuralNetwork::train_one_step(x_y_matrix &training_data, uint32_t epoch, double learning_rate, uint32_t batch_size, bool verbose) {
+template<typename T>
+void BasicNeuralNetwork<T>::train_one_step(basic_x_y_matrix<T> &training_data, uint32_t epoch, double learning_rate, uint32_t batch_size, bool verbose) {
     /* Shuffle training data */
     auto shuffled_indices = std::vector<uint32_t>(training_data.first.get_dims()[0]);
     std::iota(shuffled_indices.begin(), shuffled_indices.end(), 0);
-    std::shuffle(shuffled_indices.begin(), shuffled_indices.end(), std::mt19937(std::random_device()()));
+    Random::shuffle(shuffled_indices, random_stream::shuffle);
 
     /* Create batches */
     auto batches = std::vector<std::vector<uint32_t>>(training_data.first.get_dims()[0] / batch_size,
@@ -229,46 +532,44 @@ void NeuralNetwork::train_one_step(x_y_matrix &training_data, uint32_t epoch, do
             batches[j][k] = shuffled_indices[j * batch_size + k];
         }
 
-    /* Train on batches */
-    double error = 0; /* Average error over all batches */
-    for (auto &batch : batches) { /* For each batch */
-        this->reset_gradient(); /* Reset gradient */
-
-        /* Prepare batch inputs and outputs */
-        auto batch_inputs = Matrix(batch.size(), training_data.first.get_dims()[1], false);
-        auto batch_outputs = Matrix(batch.size(), training_data.second.get_dims()[1], false);
-
-        for (uint32_t j = 0; j < batch.size(); j++) {
-            batch_inputs.set_row(j, training_data.first.get_row(batch[j]).get_values()[0]);
-            batch_outputs.set_row(j, training_data.second.get_row(batch[j]).get_values()[0]);
-        }
+    /* Replicas for the data-parallel training (one per shard except the first one) */
+    const uint32_t shards = this->asynchronous_workers > 0 ? 1 : std::min(this->data_parallel_shards, batch_size);
+    const auto replicas = this->make_replicas(shards - 1);
 
-        /* Train on batch */
-        for (uint32_t j = 0; j < batch.size(); j++) {
-            this->set_input(batch_inputs.get_row(j)); /* Set input */
-            this->feed_forward(); /* Feed forward */
-            error += this->loss(batch_outputs.get_row(j)); /* Calculate error */
-            this->back_propagation(batch_outputs.get_row(j)); /* Back propagation */
+    /* Train on batches */
+    double error = 0; /* Average error over all batches (accumulated in double even for float networks) */
+    if (this->asynchronous_workers > 0) { /* Hogwild, the workers update the weights themselves */
+        error = this->train_asynchronous(training_data, batches, learning_rate);
+    } else {
+        for (auto &batch : batches) { /* For each batch */
+            if (shards > 1) {
+                error += this->train_batch_data_parallel(training_data, batch, replicas);
+            } else {
+                this->reset_gradient(); /* Reset gradient */
+                error += this->train_batch(training_data, batch.data(), static_cast<uint32_t>(batch.size()));
+            }
+
+            /* Update weights */
+            this->update_weights(learning_rate);
         }
-
-        /* Update weights */
-        this->update_weights(learning_rate);
     }
     /* Calculate average error over all batches */
     error /= training_data.first.get_dims()[0];
-    this->training_error.add_row({error});
+    this->training_error.add_row({static_cast<T>(error)});
 
     if (verbose) /* Print epoch and error */
         std::cout << "Epoch: " << epoch << " Error: " << error << std::endl;
 }
 
-double NeuralNetwork::test(x_y_matrix &test_data) {
-    /* Calculate accuracy */
+template<typename T>
+double BasicNeuralNetwork<T>::test(basic_x_y_matrix<T> &test_data) {
+    /* Calculate accuracy, the whole test set goes through the network as one batch */
     double correct = 0;
 
+    const auto predicted_outputs = this->predict_batch(test_data.first);
     for (uint32_t i = 0; i < test_data.first.get_dims()[0]; i++) {
-        auto predicted_output = this->predict(test_data.first.get_row(i));
-        auto expected_output = test_data.second.get_row(i);
+        auto predicted_output = predicted_outputs.get_row_view(i);
+        auto expected_output = test_data.second.get_row_view(i);
         auto predicted_output_max = predicted_output.argmax();
         auto expected_output_max = expected_output.argmax();
 
@@ -280,26 +581,59 @@ double NeuralNetwork::test(x_y_matrix &test_data) {
     return correct / test_data.first.get_dims()[0];
 }
 
-Matrix NeuralNetwork::predict(const Matrix &inputs) {
+template<typename T>
+BasicMatrix<T> BasicNeuralNetwork<T>::predict(BasicMatrixView<T> inputs) {
+    this->workspace.reset();
     this->set_input(inputs);
-    this->feed_forward();
-    return this->get_output();
+    this->feed_forward(false); /* Inference, no derivatives */
+    return BasicMatrix<T>(this->get_output()); /* Copied out of the workspace */
+}
+
+template<typename T>
+BasicMatrix<T> BasicNeuralNetwork<T>::predict_batch(BasicMatrixView<T> inputs) {
+    this->workspace.reset();
+    this->set_input_rows(inputs, nullptr, inputs.get_rows());
+    this->feed_forward(false); /* Inference, no derivatives */
+
+    auto &output_layer = this->layers.back();
+    BasicMatrix<T> outputs(inputs.get_rows(), this->output_size, false);
+    for (uint32_t sample = 0; sample < inputs.get_rows(); sample++) {
+        T *output = outputs.get_data() + static_cast<size_t>(sample) * outputs.get_stride();
+        if (this->softmax_output)
+            output_layer->write_softmax_output(output, sample);
+        else
+            output_layer->write_output(output, sample);
+    }
+    return outputs;
 }
 
-NeuralNetwork &NeuralNetwork::operator=(const NeuralNetwork &nn) {
+template<typename T>
+BasicNeuralNetwork<T> &BasicNeuralNetwork<T>::operator=(const BasicNeuralNetwork<T> &nn) {
+    if (this == &nn)
+        return *this;
     this->input_size = nn.input_size;
     this->output_size = nn.output_size;
     this->layers.clear();
     this->layers.reserve(nn.layers.size());
-    this->layers = nn.layers;
-    this->init_weights();
+    for (auto &layer : nn.layers) /* Own copies of the layers, bound to the own copy of the parameters */
+        this->layers.emplace_back(std::make_shared<BasicLayer<T>>(*layer));
+    this->parameters = nn.parameters;
+    this->parameter_offsets = nn.parameter_offsets;
+    this->gradients.assign(nn.gradients.size(), T(0));
+    this->bind_layers(this->parameters.data());
+    this->optimizer = nn.optimizer;
     this->training_error = nn.training_error;
     this->reset_gradient();
     this->softmax_output = nn.softmax_output;
+    this->sparse_density_cutoff = nn.sparse_density_cutoff;
+    this->data_parallel_shards = nn.data_parallel_shards;
+    this->asynchronous_workers = nn.asynchronous_workers;
+    this->worker_optimizers = nn.worker_optimizers;
     return *this;
 }
 
-std::ostream &operator<<(std::ostream &os, const NeuralNetwork &nn) {
+template<typename T>
+std::ostream &operator<<(std::ostream &os, const BasicNeuralNetwork<T> &nn) {
     os << "NeuralNetwork: " << std::endl;
     os << "    Input layer size: " << nn.input_size << std::endl;
     os << "    Hidden layers: " << std::endl;
@@ -311,3 +645,8 @@ std::ostream &operator<<(std::ostream &os, const NeuralNetwork &nn) {
     os << "    Softmax output: " << nn.softmax_output << std::endl;
     return os;
 }
+
+template class BasicNeuralNetwork<float>;
+template class BasicNeuralNetwork<double>;
+template std::ostream &operator<<(std::ostream &os, const BasicNeuralNetwork<float> &nn);
+template std::ostream &operator<<(std::ostream &os, const BasicNeuralNetwork<double> &nn);
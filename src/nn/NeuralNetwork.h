@@ -2,70 +2,193 @@
 
 #include <iostream>
 #include <algorithm>
+#include <utility>
+#include <numeric>
+#include <atomic>
+#include <memory>
 #include "Layer.h"
+#include "Optimizer.h"
 #include "../utils/Matrix.h"
 #include "../utils/DataLoader.h"
+#include "../utils/Workspace.h"
+#include "../utils/Random.h"
+#include "../utils/ThreadPool.h"
+
+template<typename T>
+class BasicNeuralNetwork;
+
+/**
+ * Overload of the bitwise left shift operator (for printing)
+ * @param os Output stream
+ * @param nn Neural network to print
+ * @return Output stream
+ */
+template<typename T>
+std::ostream &operator<<(std::ostream &os, const BasicNeuralNetwork<T> &nn);
 
 /**
  * Class representing a neural network
  * My neural network serves as an array of layers and it does all the logic behind training and predicting
  * It also stores information for the visualization
+ * Element type of the weights and activations is a template parameter, hyperparameters (learning rate, stopping
+ * criteria) and the accuracy stay doubles
+ * @tparam T Element type (float / double)
  */
-class NeuralNetwork {
+template<typename T>
+class BasicNeuralNetwork {
+public:
+    /** Default density cutoff of the sparse feed forward (measured with the sparse benchmark) */
+    static constexpr double DEFAULT_SPARSE_DENSITY_CUTOFF = 0.5;
+    /** Number of gradient elements per task of the reduction of the data-parallel training */
+    static constexpr size_t REDUCTION_CHUNK = 4096;
+
 private:
     /** Size of the input layer */
     uint32_t input_size;
     /** Size of the output layer */
     uint32_t output_size;
     /** Vector of pointers to layers */
-    std::vector<std::shared_ptr<Layer>> layers;
+    std::vector<std::shared_ptr<BasicLayer<T>>> layers;
     /** Training error */
-    Matrix training_error;
-    /** Gradient of the neural network */
-    std::vector<std::vector<Matrix>> gradient;
+    BasicMatrix<T> training_error;
+    /** Parameters of the neural network, the weights of all layers in one contiguous buffer (the layers hold views
+     * into it, each block starts aligned, the padding between the blocks stays zero) */
+    std::vector<T, AlignedAllocator<T>> parameters;
+    /** Gradient of the neural network, same layout as the parameters (accumulated over the samples of a batch) */
+    std::vector<T, AlignedAllocator<T>> gradients;
+    /** Offset of the weights of each layer with weights in the parameter (and gradient) buffer */
+    std::vector<size_t> parameter_offsets;
+    /** Number of samples accumulated in the gradient */
+    uint32_t gradient_samples = 0;
+    /** Optimizer turning the gradient into the weight update (its state has the layout of the parameters) */
+    BasicOptimizer<T> optimizer;
     /** Softmax output */
     bool softmax_output;
+    /** Arena for the temporaries of the forward and backward pass (reset once per batch) */
+    BasicWorkspace<T> workspace;
+    /** Pruned layers with weights density below this use the sparse matrix-vector product in the feed forward */
+    double sparse_density_cutoff = DEFAULT_SPARSE_DENSITY_CUTOFF;
+    /** Number of shards each batch is split into (data-parallel training), 1 trains on one thread */
+    uint32_t data_parallel_shards = 1;
+    /** Number of asynchronous (Hogwild) workers, 0 trains synchronously */
+    uint32_t asynchronous_workers = 0;
+    /** Optimizers of the asynchronous workers other than this network (own state per worker, kept between epochs) */
+    std::vector<BasicOptimizer<T>> worker_optimizers;
+
+    /**
+     * Replica constructor (data-parallel training), the layers are copied and bound to the given parameter buffer,
+     * the replica has its own activations, workspace and gradient, but no parameters of its own
+     * @param nn Neural network to replicate
+     * @param shared_parameters Parameter buffer of nn (read only while the replica trains)
+     */
+    BasicNeuralNetwork(const BasicNeuralNetwork &nn, T *shared_parameters);
 
     /**
      * Set input of the neural network (first layer)
-     * @param inputs Inputs to the neural network
+     * @param inputs Inputs to the neural network (row or column, read in place)
      */
-    void set_input(const Matrix &inputs);
+    void set_input(BasicMatrixView<T> inputs);
     /**
-     * Get output of the neural network (last layer)
-     * @return Output of the neural network
+     * Set a batch of inputs of the neural network (first layer), one sample per row
+     * @param data Input samples (one per row, read in place)
+     * @param rows Rows of data forming the batch (in this order), nullptr for all rows of data
+     * @param count Number of samples in the batch
+     */
+    void set_input_rows(BasicMatrixView<T> data, const uint32_t *rows, uint32_t count);
+    /**
+     * Get output of the neural network (last layer) for the first sample of the batch, the output is written into the workspace
+     * @return Output of the neural network (column, valid until the workspace is reset)
      */
-    [[nodiscard]] Matrix get_output() const;
+    [[nodiscard]] BasicMatrixView<T> get_output();
 
+    /**
+     * Lay out the parameter and gradient buffers for the current layers (zeroed) and bind the layers to them
+     */
+    void allocate_parameters();
+    /**
+     * Bind the weights of the layers to their blocks of the given parameter buffer (after the buffer moved)
+     * @param parameter_data First element of the parameter buffer (laid out by allocate_parameters)
+     */
+    void bind_layers(T *parameter_data);
     /**
      * Initialize the weights of the neural network
      * Weights are initialized with random values from -1 to 1
      */
     void init_weights();
     /**
-     * Feed forward the neural network
-     * Each layer is activated with the given activation function
+     * Feed forward the neural network, the whole batch held by the input layer at once
+     * Each layer computes the weighted inputs of all samples as one matrix-matrix product and is activated with the
+     * given activation function
+     * @param with_derivatives Compute the derivative outputs of the layers as well (training), inference skips them
      */
-    void feed_forward();
+    void feed_forward(bool with_derivatives = true);
     /**
-     * Reset the gradient of the neural network
+     * Reset the gradient of the neural network (zeroes the accumulated gradient)
      */
     void reset_gradient();
+    /**
+     * Loss of the current batch and the deltas of the output layer, softmax outputs go through the fused stable
+     * softmax + cross-entropy kernel (BasicLayer::softmax_cross_entropy), so the softmax is computed only once
+     * @param expected_output Expected outputs of the neural network (one row per sample of the batch, read in place)
+     * @param delta Buffer for the deltas of the output layer (batch size x output size), nullptr for just the loss
+     * @return Loss summed over the batch (MSE / Categorical Cross Entropy)
+     */
+    T output_loss_and_delta(BasicMatrixView<T> expected_output, T *delta);
     /**
      * Calculates the loss of the neural network
      * Loss is calculated as MSE or Categorical Cross Entropy depending on the flag softmax_output
-     * @param expected_output Expected output of the neural network
-     * @return Loss of the neural network (MSE / Categorical Cross Entropy)
+     * @param expected_output Expected outputs of the neural network (one row per sample of the batch, read in place)
+     * @return Loss of the neural network summed over the batch (MSE / Categorical Cross Entropy)
      */
-    double loss(const Matrix &expected_output);
+    T loss(BasicMatrixView<T> expected_output);
     /**
      * Back propagate the neural network
      * The true magic happens here :)
-     * @param expected_output Expected output of the neural network
+     * @param expected_outputs Expected outputs of the neural network (one row per sample of the batch, read in place)
+     * @return Loss summed over the batch (same as loss(), computed in the same pass as the output deltas)
      */
-    void back_propagation(const Matrix &expected_output);
+    T back_propagation(BasicMatrixView<T> expected_outputs);
     /**
-     * Update the weights of the neural network based on the gradient and the learning rate
+     * Forward and backward pass of the given samples, the gradient is accumulated (not reset, weights not updated)
+     * @param training_data Training data
+     * @param rows Rows of the training data forming the batch
+     * @param count Number of samples in the batch
+     * @return Loss summed over the batch
+     */
+    T train_batch(basic_x_y_matrix<T> &training_data, const uint32_t *rows, uint32_t count);
+    /**
+     * Forward and backward pass of a batch split into shards, one shard per task on the thread pool (this network and
+     * the replicas), the gradients of the shards are summed by a fixed pairwise tree into the gradient of this network,
+     * so the result does not depend on the number of threads or the order the shards finish in
+     * @param training_data Training data
+     * @param batch Rows of the training data forming the batch
+     * @param replicas Replicas of this network (one per shard except the first one, which this network trains)
+     * @return Loss summed over the batch
+     */
+    T train_batch_data_parallel(basic_x_y_matrix<T> &training_data, const std::vector<uint32_t> &batch,
+                                const std::vector<std::unique_ptr<BasicNeuralNetwork>> &replicas);
+    /**
+     * Build replicas of this network sharing its parameter buffer (data-parallel and asynchronous training), built
+     * once per epoch, so they pick up the current activation functions
+     * @param count Number of replicas
+     * @return Replicas
+     */
+    std::vector<std::unique_ptr<BasicNeuralNetwork>> make_replicas(uint32_t count);
+    /**
+     * One epoch of asynchronous (Hogwild) training, the workers (this network and its replicas) pull the batches from a
+     * shared counter and each one applies the gradient of its batch straight to the shared parameters, without locks
+     * or barriers (racy but benign writes, a lost update only loses a part of one step), every worker steps with its
+     * own copy of the optimizer (worker 0 with the optimizer of this network), so the velocity / moments are not
+     * shared by the racing workers
+     * @param training_data Training data
+     * @param batches Batches of the epoch (rows of the training data)
+     * @param learning_rate Learning rate
+     * @return Loss summed over the epoch (every batch with the weights its worker saw)
+     */
+    double train_asynchronous(basic_x_y_matrix<T> &training_data, const std::vector<std::vector<uint32_t>> &batches, double learning_rate);
+    /**
+     * Update the weights of the neural network based on the gradient and the learning rate with the optimizer, one
+     * fused streaming pass over the parameter, gradient and optimizer state buffers
      * @param learning_rate Learning rate
      */
     void update_weights(double learning_rate);
@@ -78,7 +201,7 @@ public:
      * @param hidden_layers_sizes Number of neurons in each hidden layer
      * @param softmax_output Flag whether to use softmax output or not (MSE / Categorical Cross Entropy)
      */
-    NeuralNetwork(uint32_t input_size, uint32_t output_size, const std::vector<uint32_t> &hidden_layers_sizes, bool softmax_output = false);
+    BasicNeuralNetwork(uint32_t input_size, uint32_t output_size, const std::vector<uint32_t> &hidden_layers_sizes, bool softmax_output = false);
     /**
      * Constructor with activation function as a function pointer
      * @param input_size Number of neurons in the input layer
@@ -87,7 +210,7 @@ public:
      * @param activation_function Activation function of the neural network (as a function pointer)
      * @param softmax_output Flag whether to use softmax output or not (MSE / Categorical Cross Entropy)
      */
-    NeuralNetwork(uint32_t input_size, uint32_t output_size, const std::vector<uint32_t> &hidden_layers_sizes, act_func activation_function, bool softmax_output = false);
+    BasicNeuralNetwork(uint32_t input_size, uint32_t output_size, const std::vector<uint32_t> &hidden_layers_sizes, basic_act_func<T> activation_function, bool softmax_output = false);
     /**
      * Constructor with activation function as an enum value
      * @param input_size Number of neurons in the input layer
@@ -96,22 +219,133 @@ public:
      * @param activation_function Activation function of the neural network (as an enum value)
      * @param softmax_output Flag whether to use softmax output or not (MSE / Categorical Cross Entropy)
      */
-    NeuralNetwork(uint32_t input_size, uint32_t output_size, const std::vector<uint32_t> &hidden_layers_sizes, act_func_type activation_function, bool softmax_output = false);
+    BasicNeuralNetwork(uint32_t input_size, uint32_t output_size, const std::vector<uint32_t> &hidden_layers_sizes, act_func_type activation_function, bool softmax_output = false);
+    /**
+     * Copy constructor, the layers and the parameters are copied (the copy does not share anything with the original)
+     * @param nn Neural network to copy
+     */
+    BasicNeuralNetwork(const BasicNeuralNetwork &nn);
+    /**
+     * Move constructor, the layers keep their views (the parameter buffer moves with them)
+     * @param nn Neural network to move
+     */
+    BasicNeuralNetwork(BasicNeuralNetwork &&nn) noexcept = default;
     /**
      * Default destructor
      */
-    ~NeuralNetwork();
+    ~BasicNeuralNetwork();
 
     /**
      * Get the layers of the neural network (as a vector of pointers to layers)
      * @return Layers of the neural network (as a vector of pointers to layers)
      */
-    [[nodiscard]] const std::vector<std::shared_ptr<Layer>> &get_layers() const;
+    [[nodiscard]] const std::vector<std::shared_ptr<BasicLayer<T>>> &get_layers() const;
     /**
      * Get the training error of the neural network
      * @return Training error of the neural network
      */
-    [[nodiscard]] Matrix get_training_error() const;
+    [[nodiscard]] BasicMatrix<T> get_training_error() const;
+    /**
+     * Get the flag whether the neural network uses softmax output or not
+     * @return True if the output is softmax (Categorical Cross Entropy), false otherwise (MSE)
+     */
+    [[nodiscard]] bool is_softmax_output() const;
+    /**
+     * Get the workspace of the neural network (e.g. to read its high-water mark)
+     * @return Workspace of the neural network
+     */
+    [[nodiscard]] const BasicWorkspace<T> &get_workspace() const;
+    /**
+     * Get the parameters of the neural network, the weights of all layers in one contiguous buffer (snapshot or
+     * serialization is one copy of it), layer i (with weights) starts at get_parameter_offset(i)
+     * @return Parameters of the neural network
+     */
+    [[nodiscard]] const std::vector<T, AlignedAllocator<T>> &get_parameters() const;
+    /**
+     * Set the parameters of the neural network (one copy into the parameter buffer)
+     * @param new_parameters Parameters of a network with the same topology (as returned by get_parameters)
+     */
+    void set_parameters(const std::vector<T, AlignedAllocator<T>> &new_parameters);
+    /**
+     * Get the gradient of the neural network (same layout as the parameters)
+     * @return Gradient of the neural network accumulated over the current batch
+     */
+    [[nodiscard]] const std::vector<T, AlignedAllocator<T>> &get_gradients() const;
+    /**
+     * Get the offset of the weights of the given layer in the parameter (and gradient) buffer
+     * @param layer Index of the layer (input layer included, so the first layer with weights is 1)
+     * @return Offset of the first weight of the layer
+     */
+    [[nodiscard]] size_t get_parameter_offset(uint32_t layer) const;
+
+    /**
+     * Get the density cutoff of the sparse feed forward
+     * @return Pruned layers with weights density below this use the sparse matrix-vector product
+     */
+    [[nodiscard]] double get_sparse_density_cutoff() const;
+    /**
+     * Set the density cutoff of the sparse feed forward (0 disables the sparse path), only layers pruned since the last
+     * training update are checked (prune, prune_keep_top)
+     * @param cutoff Pruned layers with weights density below this use the sparse matrix-vector product
+     */
+    void set_sparse_density_cutoff(double cutoff);
+    /**
+     * Magnitude pruning of all layers, zero all weights with absolute value below the threshold (bias terms are kept)
+     * Meant for a trained network, further training updates the pruned weights again (there is no mask)
+     * @param threshold Weights with smaller absolute value are set to zero
+     */
+    void prune(double threshold);
+    /**
+     * Magnitude pruning of all layers, keep only the given fraction of the largest weights of each layer (bias terms
+     * are kept), meant for a trained network, further training updates the pruned weights again (there is no mask)
+     * @param keep_fraction Fraction of the weights to keep in each layer (0 to 1)
+     */
+    void prune_keep_top(double keep_fraction);
+    /**
+     * Get the number of shards each batch is split into (data-parallel training)
+     * @return Number of shards, 1 when training on one thread
+     */
+    [[nodiscard]] uint32_t get_data_parallel_shards() const;
+    /**
+     * Set the number of shards each batch is split into (synchronous data-parallel training), the shards run forward
+     * and backward on the thread pool (see ThreadPool), each on its own copy of the activations, and their gradients
+     * are reduced before the one weight update of the batch
+     * Training is deterministic for a given number of shards (any number of threads), it matches the training on one
+     * thread up to rounding (the gradient is summed in a different order)
+     * @param shards Number of shards (typically the number of threads), 1 trains on one thread
+     */
+    void set_data_parallel_shards(uint32_t shards);
+    /**
+     * Get the number of asynchronous (Hogwild) workers
+     * @return Number of workers, 0 when training synchronously
+     */
+    [[nodiscard]] uint32_t get_asynchronous_workers() const;
+    /**
+     * Set the number of asynchronous (Hogwild) workers, the workers run on the thread pool (see ThreadPool), pull the
+     * batches independently and update the shared weights without any synchronization (only the end of an epoch
+     * waits for all of them, the training error and early stopping are per epoch as usual)
+     * Meant for small networks, where synchronizing every batch costs more than the math, training is not reproducible
+     * (the updates race), takes precedence over the data-parallel training, every worker keeps its own optimizer state
+     * @param workers Number of workers (typically the number of threads), 0 trains synchronously
+     */
+    void set_asynchronous_workers(uint32_t workers);
+
+    /**
+     * Get the optimizer of the neural network
+     * @return Optimizer (with its state)
+     */
+    [[nodiscard]] const BasicOptimizer<T> &get_optimizer() const;
+    /**
+     * Set the optimizer of the neural network (plain SGD by default), the training continues from the state of the
+     * given optimizer (a new one starts with zero velocity / moments)
+     * @param new_optimizer Optimizer
+     */
+    void set_optimizer(const BasicOptimizer<T> &new_optimizer);
+    /**
+     * Set the optimizer of the neural network with its default hyperparameters (state starts from zero)
+     * @param type Type of the optimizer
+     */
+    void set_optimizer(optimizer_type type);
 
     /**
      * Train the neural network
@@ -122,7 +356,19 @@ public:
      * @param min_loss Minimum loss to stop the training process
      * @param delta_loss Minimum delta loss to stop the training process
      */
-    void train(x_y_matrix &training_data, uint32_t epochs, double learning_rate, uint32_t batch_size, bool verbose = false, double min_loss = 0.0, double delta_loss = 0.0);
+    void train(basic_x_y_matrix<T> &training_data, uint32_t epochs, double learning_rate, uint32_t batch_size, bool verbose = false, double min_loss = 0.0, double delta_loss = 0.0);
+    /**
+     * Train the neural network with the given optimizer (with its default hyperparameters, state starts from zero)
+     * @param training_data Training data
+     * @param epochs Number of epochs
+     * @param learning_rate Learning rate
+     * @param batch_size Batch size
+     * @param optimizer Type of the optimizer
+     * @param verbose Flag whether to print the training error after each epoch or not
+     * @param min_loss Minimum loss to stop the training process
+     * @param delta_loss Minimum delta loss to stop the training process
+     */
+    void train(basic_x_y_matrix<T> &training_data, uint32_t epochs, double learning_rate, uint32_t batch_size, optimizer_type optimizer, bool verbose = false, double min_loss = 0.0, double delta_loss = 0.0);
     /**
      * Do one step of the training process
      * @param training_data Training data
@@ -130,31 +376,53 @@ public:
      * @param learning_rate Learning rate
      * @param verbose Flag whether to print the training error after each epoch or not
      */
-    void train_one_step(x_y_matrix &training_data, uint32_t epoch, double learning_rate, uint32_t batch_size, bool verbose = false);
+    void train_one_step(basic_x_y_matrix<T> &training_data, uint32_t epoch, double learning_rate, uint32_t batch_size, bool verbose = false);
     /**
      * Test the neural network
      * @param test_data Test data
      * @return Accuracy of the neural network
      */
-    double test(x_y_matrix &test_data);
+    double test(basic_x_y_matrix<T> &test_data);
     /**
      * Predict the output of the neural network for the given inputs
-     * @param inputs Inputs to the neural network
+     * @param inputs Inputs to the neural network (matrix or view, read in place)
      * @return Output of the neural network
      */
-    Matrix predict(const Matrix &inputs);
+    BasicMatrix<T> predict(BasicMatrixView<T> inputs);
+    /**
+     * Predict the outputs of the neural network for a batch of inputs, the whole batch goes through each layer as one
+     * matrix-matrix product
+     * @param inputs Inputs to the neural network (one sample per row, read in place)
+     * @return Outputs of the neural network (one sample per row)
+     */
+    BasicMatrix<T> predict_batch(BasicMatrixView<T> inputs);
 
     /**
      * Overload of the assignment operator (copy assignment)
      * @param nn Neural network to copy
      * @return Neural network (this)
      */
-    NeuralNetwork &operator=(const NeuralNetwork &nn);
+    BasicNeuralNetwork &operator=(const BasicNeuralNetwork &nn);
+    /**
+     * Overload of the assignment operator (move assignment)
+     * @param nn Neural network to move
+     * @return Neural network (this)
+     */
+    BasicNeuralNetwork &operator=(BasicNeuralNetwork &&nn) noexcept = default;
     /**
      * Overload of the bitwise left shift operator (for printing)
      * @param os Output stream
      * @param nn Neural network to print (this)
      * @return Output stream
      */
-    friend std::ostream &operator<<(std::ostream &os, const NeuralNetwork &nn);
+    friend std::ostream &operator<< <T>(std::ostream &os, const BasicNeuralNetwork &nn);
 };
+
+/* Instantiated in NeuralNetwork.cpp */
+extern template class BasicNeuralNetwork<float>;
+extern template class BasicNeuralNetwork<double>;
+
+/** Neural network working with doubles (used by the visualization) */
+using NeuralNetwork = BasicNeuralNetwork<double>;
+/** Neural network working with floats */
+using NeuralNetworkF = BasicNeuralNetwork<float>;
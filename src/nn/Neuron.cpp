@@ -1,28 +1,41 @@
 #include "Neuron.h"
 
-Neuron::Neuron(double input) : input(input), output(input), derivative_output(input) {
+template<typename T>
+BasicNeuron<T>::BasicNeuron(T *input, T *output, T *derivative_output) : input(input), output(output), derivative_output(derivative_output) {
     /* empty */
 }
 
-Neuron::~Neuron() = default;
+template<typename T>
+void BasicNeuron<T>::activate(basic_act_func<T> activation_function, basic_act_func<T> derivative_activation_function) {
+    *this->output = activation_function(*this->input);
+    *this->derivative_output = derivative_activation_function(*this->input);
+}
 
-void Neuron::activate(act_func activation_function, act_func derivative_activation_function) {
-    this->output = activation_function(this->input);
-    this->derivative_output = derivative_activation_function(this->input);
+template<typename T>
+void BasicNeuron<T>::set_outputs(T new_output, T new_derivative_output) {
+    *this->output = new_output;
+    *this->derivative_output = new_derivative_output;
 }
 
-void Neuron::set_input(double new_input) {
-    this->input = new_input;
+template<typename T>
+void BasicNeuron<T>::set_input(T new_input) {
+    *this->input = new_input;
 }
 
-double Neuron::get_input() const {
-    return this->input;
+template<typename T>
+T BasicNeuron<T>::get_input() const {
+    return *this->input;
 }
 
-double Neuron::get_output() const {
-    return this->output;
+template<typename T>
+T BasicNeuron<T>::get_output() const {
+    return *this->output;
 }
 
-double Neuron::get_derivative_output() const {
-    return this->derivative_output;
+template<typename T>
+T BasicNeuron<T>::get_derivative_output() const {
+    return *this->derivative_output;
 }
+
+template class BasicNeuron<float>;
+template class BasicNeuron<double>;
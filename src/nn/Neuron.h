@@ -1,60 +1,74 @@
 #pragma once
 
 #include <cmath>
-
-/** Activation function */
-typedef double (*act_func)(double);
+#include "Activation.h"
 
 /**
  * Class representing a neuron
- * My neuron can only store an input and if the layer gives him a function to activate with, it can activate and
- * store the output and derivative output
+ * Neurons are not stored one by one anymore, the layer keeps the inputs, outputs and derivative outputs of all its
+ * neurons in contiguous arrays (structure of arrays), a neuron is only a view of one element of each of them (see
+ * BasicLayer::get_neuron), it can activate and store the output and derivative output
+ * View is valid as long as the layer lives
+ * @tparam T Element type (float / double)
  */
-class Neuron {
+template<typename T>
+class BasicNeuron {
 private:
     /** Input of the neuron (already weighted) */
-    double input;
+    T *input;
     /** Output of the neuron (after activation) */
-    double output;
+    T *output;
     /** Derivative of the output of the neuron (after activation with derivative function) */
-    double derivative_output;
+    T *derivative_output;
 
 public:
     /**
-     * Default constructor
-     * @param input Input of the neuron (already weighted)
-     */
-    explicit Neuron(double input);
-    /**
-     * Default destructor
+     * Constructor of the view
+     * @param input Input of the neuron (element of the inputs of the layer)
+     * @param output Output of the neuron (element of the outputs of the layer)
+     * @param derivative_output Derivative output of the neuron (element of the derivative outputs of the layer)
      */
-    ~Neuron();
+    BasicNeuron(T *input, T *output, T *derivative_output);
 
     /**
      * Activate the neuron with the given activation function and store the output and derivative output
      * @param activation_function Activation function
      * @param derivative_activation_function Derivative of the activation function
      */
-    void activate(act_func activation_function, act_func derivative_activation_function);
+    void activate(basic_act_func<T> activation_function, basic_act_func<T> derivative_activation_function);
+
+    /**
+     * Set the output and derivative output of the neuron computed elsewhere
+     * @param new_output Output of the neuron (after activation)
+     * @param new_derivative_output Derivative output of the neuron (after activation with derivative function)
+     */
+    void set_outputs(T new_output, T new_derivative_output);
 
     /**
      * Set the input of the neuron
      * @param new_input Input of the neuron (already weighted)
      */
-    void set_input(double new_input);
+    void set_input(T new_input);
     /**
      * Get the input of the neuron
      * @return Input of the neuron (already weighted)
      */
-    [[nodiscard]] double get_input() const;
+    [[nodiscard]] T get_input() const;
     /**
      * Get the output of the neuron
      * @return Output of the neuron (after activation)
      */
-    [[nodiscard]] double get_output() const;
+    [[nodiscard]] T get_output() const;
     /**
      * Get the derivative output of the neuron
      * @return Output of the neuron (after activation with derivative function)
      */
-    [[nodiscard]] double get_derivative_output() const;
+    [[nodiscard]] T get_derivative_output() const;
 };
+
+/* Instantiated in Neuron.cpp */
+extern template class BasicNeuron<float>;
+extern template class BasicNeuron<double>;
+
+/** Neuron working with doubles */
+using Neuron = BasicNeuron<double>;
@@ -0,0 +1,101 @@
+#include "Optimizer.h"
+
+#include <stdexcept>
+
+namespace {
+    /** Names of the optimizers (in the order of optimizer_type) */
+    const std::string optimizer_names[] = {
+            "SGD",
+            "Momentum",
+            "Nesterov",
+            "RMSProp",
+            "Adam",
+    };
+}
+
+template<typename T>
+BasicOptimizer<T>::BasicOptimizer(optimizer_type type)
+    : BasicOptimizer(type, type == optimizer_type::rmsprop ? DEFAULT_RHO : DEFAULT_BETA1, DEFAULT_BETA2, DEFAULT_EPSILON) {
+    /* empty */
+}
+
+template<typename T>
+BasicOptimizer<T>::BasicOptimizer(optimizer_type type, double beta1, double beta2, double epsilon)
+    : type(type), beta1(beta1), beta2(beta2), epsilon(epsilon) {
+    if (type == optimizer_type::number_of_optimizers)
+        throw std::runtime_error("Unknown optimizer");
+}
+
+template<typename T>
+void BasicOptimizer<T>::step(T *parameters, const T *gradients, size_t n, double learning_rate, uint32_t samples) {
+    if (samples == 0)
+        return;
+    const T scale = static_cast<T>(1. / samples);
+    const T rate = static_cast<T>(learning_rate);
+
+    if (this->type == optimizer_type::sgd) { /* No state, weights += learning_rate / samples * gradient */
+        Backend::kernels<T>().axpy(static_cast<T>(learning_rate / samples), gradients, parameters, n);
+        return;
+    }
+
+    /* State follows the parameter buffer (zero velocity / moments at the start) */
+    if (this->first_state.size() != n) {
+        this->first_state.assign(n, T(0));
+        this->second_state.assign(this->type == optimizer_type::adam ? n : 0, T(0));
+        this->steps = 0;
+    }
+    this->steps++;
+
+    const auto &kernels = Simd::kernels<T>().optimizer;
+    switch (this->type) {
+        case optimizer_type::momentum:
+            kernels.momentum(rate, static_cast<T>(this->beta1), scale, gradients, this->first_state.data(), parameters, n);
+            break;
+        case optimizer_type::nesterov:
+            kernels.nesterov(rate, static_cast<T>(this->beta1), scale, gradients, this->first_state.data(), parameters, n);
+            break;
+        case optimizer_type::rmsprop:
+            kernels.rmsprop(rate, static_cast<T>(this->beta1), static_cast<T>(this->epsilon), scale, gradients,
+                            this->first_state.data(), parameters, n);
+            break;
+        case optimizer_type::adam: {
+            /* Bias correction folded into the step size and epsilon:
+             * rate * m_hat / (sqrt(v_hat) + epsilon) = rate * sqrt(1 - beta2^t) / (1 - beta1^t) * m / (sqrt(v) + epsilon * sqrt(1 - beta2^t)) */
+            const double correction1 = 1 - std::pow(this->beta1, static_cast<double>(this->steps));
+            const double correction2 = std::sqrt(1 - std::pow(this->beta2, static_cast<double>(this->steps)));
+            kernels.adam(static_cast<T>(learning_rate * correction2 / correction1), static_cast<T>(this->beta1),
+                         static_cast<T>(this->beta2), static_cast<T>(this->epsilon * correction2), scale, gradients,
+                         this->first_state.data(), this->second_state.data(), parameters, n);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template<typename T>
+void BasicOptimizer<T>::reset() {
+    this->first_state.clear();
+    this->second_state.clear();
+    this->steps = 0;
+}
+
+template<typename T>
+optimizer_type BasicOptimizer<T>::get_type() const {
+    return this->type;
+}
+
+template<typename T>
+std::string BasicOptimizer<T>::get_name() const {
+    return get_name(this->type);
+}
+
+template<typename T>
+std::string BasicOptimizer<T>::get_name(optimizer_type type) {
+    if (type == optimizer_type::number_of_optimizers)
+        throw std::runtime_error("Unknown optimizer");
+    return optimizer_names[static_cast<uint32_t>(type)];
+}
+
+template class BasicOptimizer<float>;
+template class BasicOptimizer<double>;
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../utils/AlignedAllocator.h"
+#include "../utils/Backend.h"
+#include "../utils/Simd.h"
+
+/** Optimizer type */
+enum class optimizer_type {
+    sgd = 0,
+    momentum,
+    nesterov,
+    rmsprop,
+    adam,
+    number_of_optimizers /* Enum trick to get the number of optimizers */
+};
+
+/**
+ * Class representing an optimizer (the rule turning the gradient of a batch into the weight update)
+ * The optimizer works on the flat parameter and gradient buffers of the network, its state (velocity / moments) has
+ * the same layout, so every step is one fused pass over parameters, gradient and state (see simd_optimizer_kernels)
+ * The state is allocated on the first step and dropped whenever the number of parameters changes
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+class BasicOptimizer {
+public:
+    /** Default momentum (momentum, Nesterov) and first moment decay (Adam) */
+    static constexpr double DEFAULT_BETA1 = 0.9;
+    /** Default second moment decay (Adam) */
+    static constexpr double DEFAULT_BETA2 = 0.999;
+    /** Default decay of the squared gradient average (RMSProp) */
+    static constexpr double DEFAULT_RHO = 0.9;
+    /** Default term keeping the adaptive steps finite (RMSProp, Adam) */
+    static constexpr double DEFAULT_EPSILON = 1e-8;
+
+private:
+    /** Type of the optimizer */
+    optimizer_type type;
+    /** Momentum (momentum, Nesterov), decay of the squared gradient average (RMSProp), first moment decay (Adam) */
+    double beta1;
+    /** Second moment decay (Adam) */
+    double beta2;
+    /** Term keeping the adaptive steps finite (RMSProp, Adam) */
+    double epsilon;
+    /** Velocity (momentum, Nesterov), squared gradient average (RMSProp), first moment (Adam) */
+    std::vector<T, AlignedAllocator<T>> first_state;
+    /** Second moment (Adam) */
+    std::vector<T, AlignedAllocator<T>> second_state;
+    /** Number of steps taken (bias correction of Adam) */
+    uint64_t steps = 0;
+
+public:
+    /**
+     * Constructor with the default hyperparameters of the given optimizer
+     * @param type Type of the optimizer
+     */
+    explicit BasicOptimizer(optimizer_type type = optimizer_type::sgd);
+    /**
+     * Constructor
+     * @param type Type of the optimizer
+     * @param beta1 Momentum (momentum, Nesterov), decay of the squared gradient average (RMSProp), first moment decay (Adam)
+     * @param beta2 Second moment decay (Adam)
+     * @param epsilon Term keeping the adaptive steps finite (RMSProp, Adam)
+     */
+    BasicOptimizer(optimizer_type type, double beta1, double beta2, double epsilon);
+
+    /**
+     * Update the parameters with the gradient of one batch (one fused pass over the buffers)
+     * @param parameters Parameters (updated in place)
+     * @param gradients Gradient summed over the samples of the batch (ascent direction of the negative loss)
+     * @param n Number of parameters
+     * @param learning_rate Learning rate
+     * @param samples Number of samples the gradient was summed over
+     */
+    void step(T *parameters, const T *gradients, size_t n, double learning_rate, uint32_t samples);
+    /**
+     * Forget the state (velocity / moments and the number of steps), e.g. when the training starts over
+     */
+    void reset();
+
+    /**
+     * Get the type of the optimizer
+     * @return Type of the optimizer
+     */
+    [[nodiscard]] optimizer_type get_type() const;
+    /**
+     * Get the name of the optimizer
+     * @return Name of the optimizer
+     */
+    [[nodiscard]] std::string get_name() const;
+    /**
+     * Get the name of the given optimizer type
+     * @param type Type of the optimizer
+     * @return Name of the optimizer
+     */
+    static std::string get_name(optimizer_type type);
+};
+
+/* Instantiated in Optimizer.cpp */
+extern template class BasicOptimizer<float>;
+extern template class BasicOptimizer<double>;
+
+/** Optimizer working with doubles */
+using Optimizer = BasicOptimizer<double>;
@@ -0,0 +1,121 @@
+#include "QuantizedNeuralNetwork.h"
+
+template<typename T>
+BasicQuantizedNeuralNetwork<T>::BasicQuantizedNeuralNetwork(BasicNeuralNetwork<T> &nn, BasicMatrixView<T> calibration_inputs)
+                                                            : softmax_output(nn.is_softmax_output()) {
+    const auto &layers = nn.get_layers();
+    for (auto &layer : layers) {
+        this->sizes.push_back(layer->get_size());
+        this->layer_activations.push_back(layer->get_activation());
+    }
+
+    for (uint32_t i = 1; i < layers.size(); i++) {
+        const auto layer_weights = std::as_const(*layers[i]).get_weights();
+        const uint32_t bias_col = layer_weights.get_cols() - 1;
+        this->weights.emplace_back(layer_weights.get_block_view(0, 0, layer_weights.get_rows(), bias_col));
+
+        std::vector<T> bias(layer_weights.get_rows());
+        for (uint32_t j = 0; j < layer_weights.get_rows(); j++)
+            bias[j] = layer_weights.get_value(j, bias_col);
+        this->biases.push_back(std::move(bias));
+    }
+
+    const uint32_t max_size = *std::max_element(this->sizes.begin(), this->sizes.end());
+    this->activations.resize(max_size);
+    this->quantized_inputs.resize(max_size);
+    this->accumulators.resize(max_size);
+
+    this->calibrate(nn, calibration_inputs);
+}
+
+template<typename T>
+void BasicQuantizedNeuralNetwork<T>::calibrate(BasicNeuralNetwork<T> &nn, BasicMatrixView<T> calibration_inputs) {
+    const auto &layers = nn.get_layers();
+    std::vector<T> max_abs(layers.size() - 1, 0);
+    std::vector<T> output(this->activations.size());
+
+    for (uint32_t i = 0; i < calibration_inputs.get_rows(); i++) {
+        (void) nn.predict(calibration_inputs.get_row_view(i)); /* Fills the outputs of all layers */
+        for (uint32_t l = 0; l + 1 < layers.size(); l++) {
+            layers[l]->write_output(output.data());
+            for (uint32_t j = 0; j < layers[l]->get_size(); j++)
+                max_abs[l] = std::max(max_abs[l], std::abs(output[j]));
+        }
+    }
+
+    /* Layer that never sees a non-zero input gets scale 1, so nothing is divided by zero */
+    this->input_scales.clear();
+    for (T value : max_abs)
+        this->input_scales.push_back(value > 0 ? value / QuantizedMatrix::MAX_QUANTIZED : T(1));
+}
+
+template<typename T>
+void BasicQuantizedNeuralNetwork<T>::activate(uint32_t layer) {
+    T *values = this->activations.data();
+    std::visit([&](const auto &activation) { activate_kernel<T>(activation, values, values, nullptr, this->sizes[layer]); },
+               this->layer_activations[layer]);
+}
+
+template<typename T>
+BasicMatrix<T> BasicQuantizedNeuralNetwork<T>::predict(BasicMatrixView<T> inputs) {
+    if (inputs.get_cols() != 1 and inputs.get_rows() == 1)
+        inputs = inputs.transpose();
+
+    /* Input layer activation (linear, so just copy inputs) */
+    for (uint32_t i = 0; i < this->sizes[0]; i++)
+        this->activations[i] = inputs.get_value(i, 0);
+    this->activate(0);
+
+    for (uint32_t l = 1; l < this->sizes.size(); l++) {
+        const uint32_t previous_size = this->sizes[l - 1];
+        const uint32_t current_size = this->sizes[l];
+        const auto &layer_weights = this->weights[l - 1];
+        const auto &bias = this->biases[l - 1];
+        const T input_scale = this->input_scales[l - 1];
+
+        /* Integer weighted sums, then back to real values (weight scale * input scale) with the bias added */
+        QuantizedMatrix::quantize(this->activations.data(), previous_size, input_scale, this->quantized_inputs.data());
+        layer_weights.multiply_vector(this->quantized_inputs.data(), this->accumulators.data());
+        for (uint32_t i = 0; i < current_size; i++)
+            this->activations[i] = static_cast<T>(this->accumulators[i]) * (layer_weights.get_scale(i) * input_scale) + bias[i];
+
+        if (l + 1 == this->sizes.size() && this->softmax_output) { /* Softmax works with the inputs of the output layer */
+            /* Maximum subtracted first (as in BasicLayer::write_softmax_output), so large logits cannot overflow exp */
+            const T max = *std::max_element(this->activations.begin(), this->activations.begin() + current_size);
+            T sum = 0;
+            for (uint32_t i = 0; i < current_size; i++) {
+                this->activations[i] = std::exp(this->activations[i] - max);
+                sum += this->activations[i];
+            }
+            const T inverse_sum = 1 / sum;
+            for (uint32_t i = 0; i < current_size; i++)
+                this->activations[i] *= inverse_sum;
+        } else {
+            this->activate(l);
+        }
+    }
+
+    BasicMatrix<T> output(this->sizes.back(), 1, false);
+    std::copy_n(this->activations.data(), this->sizes.back(), output.get_data()); /* Column vector, data are contiguous */
+    return output;
+}
+
+template<typename T>
+double BasicQuantizedNeuralNetwork<T>::test(const basic_x_y_matrix<T> &test_data) {
+    double correct = 0;
+    for (uint32_t i = 0; i < test_data.first.get_rows(); i++)
+        if (this->predict(test_data.first.get_row_view(i)).argmax() == test_data.second.get_row_view(i).argmax())
+            correct++; /* Correct prediction */
+    return correct / test_data.first.get_rows();
+}
+
+template<typename T>
+size_t BasicQuantizedNeuralNetwork<T>::get_weights_bytes() const {
+    size_t bytes = 0;
+    for (uint32_t l = 0; l < this->weights.size(); l++)
+        bytes += this->weights[l].get_bytes() + this->biases[l].size() * sizeof(T);
+    return bytes;
+}
+
+template class BasicQuantizedNeuralNetwork<float>;
+template class BasicQuantizedNeuralNetwork<double>;
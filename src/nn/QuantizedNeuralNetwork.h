@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "NeuralNetwork.h"
+#include "../utils/QuantizedMatrix.h"
+
+/**
+ * Inference-only neural network with int8 weights (post-training quantization of a trained BasicNeuralNetwork)
+ * Weights of each layer are quantized with one scale per neuron (row), the inputs of each layer with one scale per
+ * layer calibrated on a sample of the training data (largest magnitude the layer sees), so the weighted sums are
+ * integer dot products with int32 accumulators, only the accumulators are converted back (scales applied, bias added
+ * in full precision) before the activation function
+ * Weights take 1 byte instead of sizeof(T) plus one float scale per neuron
+ * @tparam T Element type of the source network and of the activations (float / double)
+ */
+template<typename T>
+class BasicQuantizedNeuralNetwork {
+private:
+    /** Sizes of the layers (input layer included) */
+    std::vector<uint32_t> sizes;
+    /** Quantized weights of the layers with weights (bias terms are not quantized) */
+    std::vector<QuantizedMatrix> weights;
+    /** Bias terms of the layers with weights */
+    std::vector<std::vector<T>> biases;
+    /** Scale of the inputs of the layers with weights (calibrated) */
+    std::vector<T> input_scales;
+    /** Activations of the layers (input layer included), dispatched once per layer */
+    std::vector<basic_activation<T>> layer_activations;
+    /** Softmax output */
+    bool softmax_output;
+    /** Activations of the current layer (scratch buffer) */
+    std::vector<T> activations;
+    /** Quantized inputs of the current layer (scratch buffer) */
+    std::vector<int8_t> quantized_inputs;
+    /** Integer weighted sums of the current layer (scratch buffer) */
+    std::vector<int32_t> accumulators;
+
+    /**
+     * Calibrate the input scales, largest magnitude of the inputs of every layer over the calibration samples
+     * @param nn Source neural network (its predictions provide the inputs of the layers)
+     * @param calibration_inputs Calibration samples (one per row)
+     */
+    void calibrate(BasicNeuralNetwork<T> &nn, BasicMatrixView<T> calibration_inputs);
+    /**
+     * Apply the activation of the given layer to the scratch activations in place
+     * @param layer Index of the layer (input layer included)
+     */
+    void activate(uint32_t layer);
+
+public:
+    /**
+     * Constructor quantizing a trained neural network
+     * @param nn Trained neural network (only used for the calibration, it is not changed)
+     * @param calibration_inputs Calibration samples, e.g. a part of the training data (one per row)
+     */
+    BasicQuantizedNeuralNetwork(BasicNeuralNetwork<T> &nn, BasicMatrixView<T> calibration_inputs);
+
+    /**
+     * Predict the output of the neural network for the given inputs
+     * @param inputs Inputs to the neural network (row or column, read in place)
+     * @return Output of the neural network (column vector)
+     */
+    BasicMatrix<T> predict(BasicMatrixView<T> inputs);
+    /**
+     * Test the neural network
+     * @param test_data Test data
+     * @return Accuracy of the neural network
+     */
+    double test(const basic_x_y_matrix<T> &test_data);
+    /**
+     * Get the number of bytes of the weights (quantized weights, their scales and the bias terms)
+     * @return Number of bytes
+     */
+    [[nodiscard]] size_t get_weights_bytes() const;
+};
+
+/* Instantiated in QuantizedNeuralNetwork.cpp */
+extern template class BasicQuantizedNeuralNetwork<float>;
+extern template class BasicQuantizedNeuralNetwork<double>;
+
+/** Quantized neural network built from a NeuralNetwork (doubles) */
+using QuantizedNeuralNetwork = BasicQuantizedNeuralNetwork<double>;
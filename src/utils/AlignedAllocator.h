@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <limits>
+
+/** Alignment (in bytes) of all matrix buffers, one cache line (also enough for AVX-512 loads) */
+constexpr std::size_t MATRIX_ALIGNMENT = 64;
+
+/**
+ * Minimal allocator returning memory aligned to the given boundary
+ * Used as the allocator of std::vector, so matrix rows can start on a cache line
+ * @tparam T Type of the allocated elements
+ * @tparam Alignment Alignment in bytes (power of two)
+ */
+template<typename T, std::size_t Alignment = MATRIX_ALIGNMENT>
+class AlignedAllocator {
+public:
+    /** Type of the allocated elements */
+    using value_type = T;
+
+    /**
+     * Rebind helper, so containers can allocate their internal types with the same alignment
+     * @tparam U Other type
+     */
+    template<typename U>
+    struct rebind {
+        /** Allocator of the other type */
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    /**
+     * Default constructor
+     */
+    AlignedAllocator() noexcept = default;
+    /**
+     * Converting copy constructor (allocators are stateless)
+     * @param other Allocator to copy
+     */
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &other) noexcept { /* empty */ }
+
+    /**
+     * Allocate aligned memory for n elements
+     * @param n Number of elements
+     * @return Pointer to the allocated memory
+     */
+    [[nodiscard]] T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    /**
+     * Free memory allocated by allocate()
+     * @param p Pointer to the memory
+     * @param n Number of elements
+     */
+    void deallocate(T *p, std::size_t n) noexcept {
+        ::operator delete(p, n * sizeof(T), std::align_val_t(Alignment));
+    }
+
+    /**
+     * Allocators are stateless, so all of them are equal
+     * @return Always true
+     */
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept { return true; }
+};
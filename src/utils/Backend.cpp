@@ -0,0 +1,167 @@
+#include "Backend.h"
+
+#include <algorithm>
+
+namespace {
+    /**
+     * Scale the m x n matrix C by beta (beta = 0 overwrites, so uninitialized / NaN values do not leak into the result)
+     * @param m Number of rows
+     * @param n Number of columns
+     * @param beta Scalar
+     * @param c Data of C (row-major)
+     * @param ldc Row stride of C
+     */
+    template<typename T>
+    void scale_c(uint32_t m, uint32_t n, T beta, T *c, uint32_t ldc) {
+        if (beta == 1)
+            return;
+        for (uint32_t i = 0; i < m; i++) {
+            T *c_row = c + static_cast<size_t>(i) * ldc;
+            if (beta == 0)
+                std::fill(c_row, c_row + n, T(0));
+            else
+                Simd::kernels<T>().scale(c_row, beta, c_row, n);
+        }
+    }
+
+    template<typename T>
+    void gemm_reference(uint32_t m, uint32_t n, uint32_t k, T alpha, const T *a, uint32_t lda, transpose_op trans_a,
+                        const T *b, uint32_t ldb, transpose_op trans_b, T beta, T *c, uint32_t ldc) {
+        scale_c(m, n, beta, c, ldc);
+        Gemm::multiply(m, n, k, alpha, a, lda, trans_a, b, ldb, trans_b, c, ldc);
+    }
+
+    template<typename T>
+    void gemv_reference(uint32_t m, uint32_t n, T alpha, const T *a, uint32_t lda, transpose_op trans_a, const T *x, T beta, T *y) {
+        if (trans_a == transpose_op::none) { /* y (column) = A * x */
+            scale_c(m, 1, beta, y, 1);
+            Gemm::multiply(m, 1, n, alpha, a, lda, transpose_op::none, x, 1, transpose_op::none, y, 1);
+        } else { /* y^T (row) = x^T * A, so the rows of A are read contiguously */
+            scale_c(1, n, beta, y, n);
+            Gemm::multiply(1, n, m, alpha, x, m, transpose_op::none, a, lda, transpose_op::none, y, n);
+        }
+    }
+
+    template<typename T>
+    T dot_reference(const T *x, const T *y, size_t n) {
+        T result = 0;
+        for (size_t i = 0; i < n; i++)
+            result += x[i] * y[i];
+        return result;
+    }
+
+    template<typename T>
+    T sum_reference(const T *x, size_t n) {
+        T result = 0;
+        for (size_t i = 0; i < n; i++)
+            result += x[i];
+        return result;
+    }
+
+    /* Elementwise kernels go through Simd, so the instruction set is still picked at runtime */
+
+    template<typename T>
+    void add_reference(const T *a, const T *b, T *c, size_t n) {
+        Simd::kernels<T>().add(a, b, c, n);
+    }
+
+    template<typename T>
+    void sub_reference(const T *a, const T *b, T *c, size_t n) {
+        Simd::kernels<T>().sub(a, b, c, n);
+    }
+
+    template<typename T>
+    void mul_reference(const T *a, const T *b, T *c, size_t n) {
+        Simd::kernels<T>().mul(a, b, c, n);
+    }
+
+    template<typename T>
+    void scale_reference(const T *a, T alpha, T *c, size_t n) {
+        Simd::kernels<T>().scale(a, alpha, c, n);
+    }
+
+    template<typename T>
+    void axpy_reference(T alpha, const T *x, T *y, size_t n) {
+        Simd::kernels<T>().axpy(alpha, x, y, n);
+    }
+
+    template<typename T>
+    void log_reference(const T *a, T *c, size_t n) {
+        Simd::math<T>().log(a, c, n); /* Exact or fast depending on the math mode */
+    }
+
+    /**
+     * Build the reference kernels for one element type
+     * @return Reference kernels
+     */
+    template<typename T>
+    constexpr backend_kernels<T> make_reference_kernels() {
+        return {gemm_reference<T>, gemv_reference<T>, add_reference<T>, sub_reference<T>, mul_reference<T>,
+                scale_reference<T>, axpy_reference<T>, log_reference<T>, dot_reference<T>, sum_reference<T>};
+    }
+}
+
+const backend_kernel_set backend_kernels_reference = {
+        make_reference_kernels<double>(),
+        make_reference_kernels<float>(),
+};
+
+std::atomic<const backend_kernel_set *> Backend::active = nullptr;
+std::atomic<backend_type> Backend::active_type = backend_type::reference;
+
+const backend_kernel_set *Backend::init() {
+    auto type = backend_type::reference;
+    if (const char *env = std::getenv("NSES_BACKEND")) {
+        for (int i = 0; i < static_cast<int>(backend_type::number_of_backends); i++)
+            if (get_name(static_cast<backend_type>(i)) == env && is_available(static_cast<backend_type>(i)))
+                type = static_cast<backend_type>(i);
+    }
+
+    set_type(type);
+    return active.load(std::memory_order_acquire);
+}
+
+bool Backend::is_available(backend_type type) {
+    switch (type) {
+        case backend_type::reference:
+            return true;
+        case backend_type::cblas:
+#ifdef NSES_BACKEND_CBLAS
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+backend_type Backend::get_type() {
+    kernels<double>(); /* Make sure the startup backend is picked */
+    return active_type.load(std::memory_order_acquire);
+}
+
+backend_type Backend::set_type(backend_type type) {
+    const backend_kernel_set *kernel_set = &backend_kernels_reference;
+#ifdef NSES_BACKEND_CBLAS
+    if (type == backend_type::cblas)
+        kernel_set = &backend_kernels_cblas;
+#endif
+    if (!is_available(type))
+        type = backend_type::reference;
+
+    active_type.store(type, std::memory_order_release);
+    active.store(kernel_set, std::memory_order_release);
+    return type;
+}
+
+std::string Backend::get_name(backend_type type) {
+    switch (type) {
+        case backend_type::reference:
+            return "reference";
+        case backend_type::cblas:
+            return "cblas";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <atomic>
+#include <type_traits>
+#include "Gemm.h"
+#include "Simd.h"
+
+/** Compute backend (implementation of the numeric kernels) */
+enum class backend_type {
+    reference = 0,
+    cblas,
+    number_of_backends /* Enum trick to get the number of backends */
+};
+
+/**
+ * Table of numeric kernels of one backend for one element type
+ * Matrices are row-major with a row stride (ld), vectors are contiguous
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+struct backend_kernels {
+    /** C = alpha * op(A) * op(B) + beta * C (m x n result, k shared dimension, beta = 0 overwrites C) */
+    void (*gemm)(uint32_t m, uint32_t n, uint32_t k, T alpha, const T *a, uint32_t lda, transpose_op trans_a,
+                 const T *b, uint32_t ldb, transpose_op trans_b, T beta, T *c, uint32_t ldc);
+    /** y = alpha * op(A) * x + beta * y (A is m x n, beta = 0 overwrites y) */
+    void (*gemv)(uint32_t m, uint32_t n, T alpha, const T *a, uint32_t lda, transpose_op trans_a, const T *x, T beta, T *y);
+    /** c = a + b */
+    void (*add)(const T *a, const T *b, T *c, size_t n);
+    /** c = a - b */
+    void (*sub)(const T *a, const T *b, T *c, size_t n);
+    /** c = a * b (elementwise) */
+    void (*mul)(const T *a, const T *b, T *c, size_t n);
+    /** c = alpha * a */
+    void (*scale)(const T *a, T alpha, T *c, size_t n);
+    /** y = alpha * x + y */
+    void (*axpy)(T alpha, const T *x, T *y, size_t n);
+    /** c = log(a) (exact or fast, see Simd::get_math_mode) */
+    void (*log)(const T *a, T *c, size_t n);
+    /** Dot product of x and y */
+    T (*dot)(const T *x, const T *y, size_t n);
+    /** Sum of the elements of x */
+    T (*sum)(const T *x, size_t n);
+};
+
+/**
+ * Kernels of one backend for all supported element types
+ */
+struct backend_kernel_set {
+    /** Kernels for doubles */
+    backend_kernels<double> f64;
+    /** Kernels for floats */
+    backend_kernels<float> f32;
+};
+
+/** Reference kernels (in-house Gemm and Simd kernels, always available) */
+extern const backend_kernel_set backend_kernels_reference;
+#ifdef NSES_BACKEND_CBLAS
+/** Kernels of the system BLAS (through the CBLAS interface) */
+extern const backend_kernel_set backend_kernels_cblas;
+#endif
+
+/**
+ * Class responsible for picking the compute backend at runtime
+ * All numeric work of Matrix and NeuralNetwork goes through the active backend, so the in-house kernels can be
+ * benchmarked against a tuned BLAS in the same binary
+ * The CBLAS backend exists only when built with the CMake option NSES_ENABLE_CBLAS, the reference backend is the
+ * default, environment variable NSES_BACKEND (reference / cblas) picks the startup backend
+ * Kernels a backend does not have (e.g. BLAS has no elementwise multiplication) fall back to the reference ones
+ */
+class Backend {
+private:
+    /** Currently active kernels */
+    static std::atomic<const backend_kernel_set *> active;
+    /** Currently active backend */
+    static std::atomic<backend_type> active_type;
+
+    /**
+     * Pick the startup backend (reference, unless NSES_BACKEND names an available one)
+     * @return Pointer to the active kernels
+     */
+    static const backend_kernel_set *init();
+
+public:
+    /**
+     * Get the active kernels for the given element type
+     * @tparam T Element type (float / double)
+     * @return Active kernels
+     */
+    template<typename T>
+    static const backend_kernels<T> &kernels() {
+        const backend_kernel_set *current = active.load(std::memory_order_acquire);
+        if (!current) [[unlikely]]
+            current = init();
+        if constexpr (std::is_same_v<T, float>)
+            return current->f32;
+        else
+            return current->f64;
+    }
+
+    /**
+     * Check whether the backend was built into the binary
+     * @param type Backend
+     * @return True if the backend can be used
+     */
+    static bool is_available(backend_type type);
+    /**
+     * Get the active backend
+     * @return Active backend
+     */
+    static backend_type get_type();
+    /**
+     * Set the active backend (unavailable backends are ignored)
+     * @param type Wanted backend
+     * @return Backend that is really active
+     */
+    static backend_type set_type(backend_type type);
+    /**
+     * Get the name of the backend
+     * @param type Backend
+     * @return Name of the backend
+     */
+    static std::string get_name(backend_type type);
+};
@@ -0,0 +1,104 @@
+#include "Backend.h"
+
+#include <algorithm>
+#include <cblas.h>
+
+/* Only built with NSES_ENABLE_CBLAS (links the system BLAS), kernels BLAS does not have use the reference ones */
+
+namespace {
+    /**
+     * Convert the transposition to the CBLAS one
+     * @param trans Transposition
+     * @return CBLAS transposition
+     */
+    CBLAS_TRANSPOSE to_cblas(transpose_op trans) {
+        return trans == transpose_op::none ? CblasNoTrans : CblasTrans;
+    }
+
+    /**
+     * BLAS checks the row stride even when there is only one stored row (vectors from the workspace have stride 1)
+     * @param ld Row stride
+     * @param cols Number of stored columns
+     * @return Row stride BLAS accepts
+     */
+    uint32_t fix_ld(uint32_t ld, uint32_t cols) {
+        return std::max({ld, cols, 1u});
+    }
+
+    template<typename T>
+    void gemm_cblas(uint32_t m, uint32_t n, uint32_t k, T alpha, const T *a, uint32_t lda, transpose_op trans_a,
+                    const T *b, uint32_t ldb, transpose_op trans_b, T beta, T *c, uint32_t ldc) {
+        /* Stored dimensions of the operands (before op is applied) */
+        const uint32_t a_rows = trans_a == transpose_op::none ? m : k, a_cols = trans_a == transpose_op::none ? k : m;
+        const uint32_t b_rows = trans_b == transpose_op::none ? k : n, b_cols = trans_b == transpose_op::none ? n : k;
+        lda = a_rows == 1 ? fix_ld(lda, a_cols) : lda;
+        ldb = b_rows == 1 ? fix_ld(ldb, b_cols) : ldb;
+        ldc = m == 1 ? fix_ld(ldc, n) : ldc;
+
+        if constexpr (std::is_same_v<T, float>)
+            cblas_sgemm(CblasRowMajor, to_cblas(trans_a), to_cblas(trans_b), static_cast<int>(m), static_cast<int>(n), static_cast<int>(k),
+                        alpha, a, static_cast<int>(lda), b, static_cast<int>(ldb), beta, c, static_cast<int>(ldc));
+        else
+            cblas_dgemm(CblasRowMajor, to_cblas(trans_a), to_cblas(trans_b), static_cast<int>(m), static_cast<int>(n), static_cast<int>(k),
+                        alpha, a, static_cast<int>(lda), b, static_cast<int>(ldb), beta, c, static_cast<int>(ldc));
+    }
+
+    template<typename T>
+    void gemv_cblas(uint32_t m, uint32_t n, T alpha, const T *a, uint32_t lda, transpose_op trans_a, const T *x, T beta, T *y) {
+        lda = m == 1 ? fix_ld(lda, n) : lda;
+        if constexpr (std::is_same_v<T, float>)
+            cblas_sgemv(CblasRowMajor, to_cblas(trans_a), static_cast<int>(m), static_cast<int>(n), alpha, a, static_cast<int>(lda), x, 1, beta, y, 1);
+        else
+            cblas_dgemv(CblasRowMajor, to_cblas(trans_a), static_cast<int>(m), static_cast<int>(n), alpha, a, static_cast<int>(lda), x, 1, beta, y, 1);
+    }
+
+    template<typename T>
+    void axpy_cblas(T alpha, const T *x, T *y, size_t n) {
+        if constexpr (std::is_same_v<T, float>)
+            cblas_saxpy(static_cast<int>(n), alpha, x, 1, y, 1);
+        else
+            cblas_daxpy(static_cast<int>(n), alpha, x, 1, y, 1);
+    }
+
+    template<typename T>
+    void scale_cblas(const T *a, T alpha, T *c, size_t n) {
+        if (a != c) { /* BLAS scales in place only */
+            if constexpr (std::is_same_v<T, float>)
+                cblas_scopy(static_cast<int>(n), a, 1, c, 1);
+            else
+                cblas_dcopy(static_cast<int>(n), a, 1, c, 1);
+        }
+        if constexpr (std::is_same_v<T, float>)
+            cblas_sscal(static_cast<int>(n), alpha, c, 1);
+        else
+            cblas_dscal(static_cast<int>(n), alpha, c, 1);
+    }
+
+    template<typename T>
+    T dot_cblas(const T *x, const T *y, size_t n) {
+        if constexpr (std::is_same_v<T, float>)
+            return cblas_sdot(static_cast<int>(n), x, 1, y, 1);
+        else
+            return cblas_ddot(static_cast<int>(n), x, 1, y, 1);
+    }
+
+    /**
+     * Build the CBLAS kernels for one element type (on top of the reference ones)
+     * @param reference Reference kernels
+     * @return CBLAS kernels
+     */
+    template<typename T>
+    backend_kernels<T> make_cblas_kernels(backend_kernels<T> reference) {
+        reference.gemm = gemm_cblas<T>;
+        reference.gemv = gemv_cblas<T>;
+        reference.axpy = axpy_cblas<T>;
+        reference.scale = scale_cblas<T>;
+        reference.dot = dot_cblas<T>;
+        return reference;
+    }
+}
+
+const backend_kernel_set backend_kernels_cblas = {
+        make_cblas_kernels(backend_kernels_reference.f64),
+        make_cblas_kernels(backend_kernels_reference.f32),
+};
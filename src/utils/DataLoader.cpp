@@ -15,8 +15,8 @@ x_y_pairs DataLoader::load_file(const std::string &filename, uint32_t input_size
         std::vector<double> outputs(output_size);
 
         uint32_t i = 0; /* i is the index of the current input/output */
-        uint32_t start; /* start is the index of the start of the current token */
-        uint32_t end = 0; /* end is the index of the end of the current token */
+        size_t start; /* start is the index of the start of the current token */
+        size_t end = 0; /* end is the index of the end of the current token (size_t, so npos compares correctly) */
         while ((start = line.find_first_not_of(delimiter, end)) != std::string::npos) {
             end = line.find(delimiter, start);
             std::string token = line.substr(start, end - start);
@@ -62,7 +62,7 @@ std::pair<x_y_pairs, x_y_pairs> DataLoader::split_data(const x_y_pairs &data, do
     /* Shuffle data, so the training and test data are not biased */
     auto shuffled_indices = std::vector<uint32_t>(data.size());
     std::iota(shuffled_indices.begin(), shuffled_indices.end(), 0);
-    std::shuffle(shuffled_indices.begin(), shuffled_indices.end(), std::mt19937(std::random_device()()));
+    Random::shuffle(shuffled_indices, random_stream::split);
 
     auto train_size = static_cast<uint32_t>(data.size() * train_test_split);
     auto test_size = data.size() - train_size;
@@ -78,16 +78,20 @@ std::pair<x_y_pairs, x_y_pairs> DataLoader::split_data(const x_y_pairs &data, do
     return std::make_pair(train_data, test_data);
 }
 
-x_y_matrix DataLoader::transform_to_matrices(const x_y_pairs &data) {
+template<typename T>
+basic_x_y_matrix<T> DataLoader::transform_to_matrices(const x_y_pairs &data) {
     /* Get input and output sizes */
-    Matrix x(data.size(), data[0].first.size(), false);
-    Matrix y(data.size(), data[0].second.size(), false);
+    BasicMatrix<T> x(data.size(), data[0].first.size(), false);
+    BasicMatrix<T> y(data.size(), data[0].second.size(), false);
 
     for (uint32_t i = 0; i < data.size(); i++) {
-        auto pair = data[i];
-        x.set_row(i, pair.first); /* Set input row */
-        y.set_row(i, pair.second); /* Set output row */
+        auto &pair = data[i];
+        x.set_row(i, std::vector<T>(pair.first.begin(), pair.first.end())); /* Set input row */
+        y.set_row(i, std::vector<T>(pair.second.begin(), pair.second.end())); /* Set output row */
     }
 
     return std::make_pair(x, y);
 }
+
+template basic_x_y_matrix<float> DataLoader::transform_to_matrices<float>(const x_y_pairs &data);
+template basic_x_y_matrix<double> DataLoader::transform_to_matrices<double>(const x_y_pairs &data);
@@ -8,11 +8,15 @@
 #include <map>
 #include <algorithm>
 #include "Matrix.h"
+#include "Random.h"
 
 /** Vector of pairs of vectors of doubles */
 typedef std::vector<std::pair<std::vector<double>, std::vector<double>>> x_y_pairs;
+/** Pair of matrices for the given element type */
+template<typename T>
+using basic_x_y_matrix = std::pair<BasicMatrix<T>, BasicMatrix<T>>;
 /** Pair of matrices */
-typedef std::pair<Matrix, Matrix> x_y_matrix;
+typedef basic_x_y_matrix<double> x_y_matrix;
 
 /**
  * Class used for loading data from files and transforming it into usable formats
@@ -43,8 +47,10 @@ public:
     static std::pair<x_y_pairs, x_y_pairs> split_data(const x_y_pairs &data, double train_test_split);
     /**
      * Transforms the data into matrices
+     * @tparam T Element type of the matrices (float / double)
      * @param data Vector of pairs of vectors of doubles (outputs can be one-hot encoded, don't have to be)
      * @return Pair of matrices (first matrix is inputs, second matrix is outputs)
      */
-    static x_y_matrix transform_to_matrices(const x_y_pairs &data);
-};
\ No newline at end of file
+    template<typename T = double>
+    static basic_x_y_matrix<T> transform_to_matrices(const x_y_pairs &data);
+};
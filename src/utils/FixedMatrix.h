@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include "AlignedAllocator.h"
+#include "MatrixView.h"
+
+/**
+ * Class representing a matrix with dimensions known at compile time
+ * Data live inside the object (on the stack), all loop bounds are constants, so the compiler can fully unroll and
+ * vectorize the small products of tiny networks, there is no allocation and no dimension check at runtime
+ * Meant for small matrices only (the whole matrix is one object), bigger ones belong into BasicMatrix
+ * Header only, every instantiation has its own dimensions
+ * @tparam T Element type (float / double)
+ * @tparam R Number of rows
+ * @tparam C Number of columns
+ */
+template<typename T, uint32_t R, uint32_t C>
+class FixedMatrix {
+public:
+    /** Element type */
+    using value_type = T;
+    /** Number of rows */
+    static constexpr uint32_t ROWS = R;
+    /** Number of columns */
+    static constexpr uint32_t COLS = C;
+
+private:
+    /** Data of the matrix (row-major, no padding) */
+    alignas(MATRIX_ALIGNMENT) std::array<T, static_cast<size_t>(R) * C> data{};
+
+public:
+    /**
+     * Default constructor (all values are zero)
+     */
+    FixedMatrix() = default;
+    /**
+     * Constructor copying a dynamic matrix or a view (dimensions have to match)
+     * @param other Matrix or view to copy
+     */
+    explicit FixedMatrix(BasicMatrixView<T> other) {
+        if (other.get_rows() != R || other.get_cols() != C)
+            throw std::runtime_error("Fixed matrix error: incompatible dimensions");
+        for (uint32_t i = 0; i < R; i++)
+            for (uint32_t j = 0; j < C; j++)
+                this->data[i * C + j] = other.get_value(i, j);
+    }
+
+    /**
+     * Get the number of rows of the matrix
+     * @return Number of rows
+     */
+    [[nodiscard]] static constexpr uint32_t get_rows() { return R; }
+    /**
+     * Get the number of columns of the matrix
+     * @return Number of columns
+     */
+    [[nodiscard]] static constexpr uint32_t get_cols() { return C; }
+    /**
+     * Get the value at the given position
+     * @param row Row index
+     * @param col Column index
+     * @return Value at the given position
+     */
+    [[nodiscard]] T get_value(uint32_t row, uint32_t col) const { return this->data[row * C + col]; }
+    /**
+     * Set the value at the given position
+     * @param row Row index
+     * @param col Column index
+     * @param value Value to set
+     */
+    void set_value(uint32_t row, uint32_t col, T value) { this->data[row * C + col] = value; }
+    /**
+     * Get the pointer to the raw data of the matrix (row-major, no padding)
+     * @return Pointer to the raw data
+     */
+    [[nodiscard]] T *get_data() { return this->data.data(); }
+    /**
+     * Get the pointer to the raw data of the matrix (row-major, no padding)
+     * @return Pointer to the raw data
+     */
+    [[nodiscard]] const T *get_data() const { return this->data.data(); }
+    /**
+     * Get the view of the matrix (to use it with the dynamic code)
+     * @return View of the matrix
+     */
+    [[nodiscard]] BasicMatrixView<T> get_view() const { return {this->data.data(), R, C, C}; }
+    /**
+     * Get the index of the maximum value in the matrix
+     * @return Index of the maximum value in the matrix
+     */
+    [[nodiscard]] uint32_t argmax() const {
+        uint32_t max_idx = 0;
+        for (uint32_t i = 1; i < R * C; i++)
+            if (this->data[i] > this->data[max_idx])
+                max_idx = i;
+        return max_idx;
+    }
+
+    /**
+     * Overloaded multiplication operator (plain i-p-j loop, the blocked kernel of the dynamic matrices can sum in a
+     * different order, so the results match up to rounding)
+     * @tparam K Number of columns of the other matrix
+     * @param other Matrix to multiply
+     * @return Result of the matrix multiplication
+     */
+    template<uint32_t K>
+    FixedMatrix<T, R, K> operator*(const FixedMatrix<T, C, K> &other) const {
+        FixedMatrix<T, R, K> result;
+        T *c = result.get_data();
+        const T *b = other.get_data();
+        for (uint32_t i = 0; i < R; i++)
+            for (uint32_t p = 0; p < C; p++) {
+                const T a_ip = this->data[i * C + p];
+                for (uint32_t j = 0; j < K; j++)
+                    c[i * K + j] += a_ip * b[p * K + j];
+            }
+        return result;
+    }
+};
@@ -0,0 +1,206 @@
+#include "Gemm.h"
+
+template<typename T>
+void Gemm::multiply(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                    const T *a, uint32_t lda, transpose_op trans_a,
+                    const T *b, uint32_t ldb, transpose_op trans_b,
+                    T *c, uint32_t ldc) {
+    const uint64_t work = static_cast<uint64_t>(m) * n * k;
+    if (work < BLOCKED_THRESHOLD || n < NR<T>)
+        reference<T>(m, n, k, alpha, a, lda, trans_a, b, ldb, trans_b, c, ldc);
+    else if (work >= PARALLEL_THRESHOLD && ThreadPool::get_num_threads() > 1)
+        parallel<T>(m, n, k, alpha, a, lda, trans_a, b, ldb, trans_b, c, ldc);
+    else
+        blocked<T>(m, n, k, alpha, a, lda, trans_a, b, ldb, trans_b, c, ldc);
+}
+
+template<typename T>
+void Gemm::parallel(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                    const T *a, uint32_t lda, transpose_op trans_a,
+                    const T *b, uint32_t ldb, transpose_op trans_b,
+                    T *c, uint32_t ldc) {
+    /* Grid of tiles of C, rows are split first (each tile repacks its whole block of B, splitting columns instead
+     * would repack A), columns only when there are not enough row tiles to go around */
+    const uint32_t target = ThreadPool::get_num_threads() * TILES_PER_THREAD;
+    const uint32_t tiles_m = std::clamp((m + MIN_TILE - 1) / MIN_TILE, 1u, target);
+    const uint32_t tiles_n = std::clamp((target + tiles_m - 1) / tiles_m, 1u, std::max(1u, n / MIN_TILE));
+
+    /* Tile sizes rounded up to the register tile, so only the last tile in a row / column is partial */
+    const uint32_t tile_m = ((m + tiles_m - 1) / tiles_m + MR - 1) / MR * MR;
+    const uint32_t tile_n = ((n + tiles_n - 1) / tiles_n + NR<T> - 1) / NR<T> * NR<T>;
+    const uint32_t grid_m = (m + tile_m - 1) / tile_m;
+    const uint32_t grid_n = (n + tile_n - 1) / tile_n;
+
+    ThreadPool::parallel_for(grid_m * grid_n, [&](uint32_t tile) {
+        const uint32_t i0 = tile / grid_n * tile_m;
+        const uint32_t j0 = tile % grid_n * tile_n;
+        const T *a_tile = trans_a == transpose_op::none ? a + static_cast<size_t>(i0) * lda : a + i0;
+        const T *b_tile = trans_b == transpose_op::none ? b + j0 : b + static_cast<size_t>(j0) * ldb;
+        blocked<T>(std::min(tile_m, m - i0), std::min(tile_n, n - j0), k, alpha, a_tile, lda, trans_a, b_tile, ldb, trans_b,
+                   c + static_cast<size_t>(i0) * ldc + j0, ldc);
+    });
+}
+
+template<typename T>
+void Gemm::reference(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                     const T *a, uint32_t lda, transpose_op trans_a,
+                     const T *b, uint32_t ldb, transpose_op trans_b,
+                     T *c, uint32_t ldc) {
+    if (n == 1 && trans_a == transpose_op::none) {
+        /* Matrix-vector product, each element of C is a dot product accumulated in a register (updating C in memory
+         * would chain every multiply-add through a store and a load) */
+        for (uint32_t i = 0; i < m; i++) {
+            const T *a_row = a + static_cast<size_t>(i) * lda;
+            const size_t b_step = trans_b == transpose_op::none ? ldb : 1;
+            T sum = 0;
+            for (uint32_t p = 0; p < k; p++)
+                sum += a_row[p] * b[p * b_step];
+            c[static_cast<size_t>(i) * ldc] += alpha * sum;
+        }
+    } else if (trans_b == transpose_op::none) {
+        /* Rows of op(B) are contiguous, so C is updated row by row (axpy of rows of B) */
+        for (uint32_t i = 0; i < m; i++) {
+            T *c_row = c + static_cast<size_t>(i) * ldc;
+            for (uint32_t p = 0; p < k; p++) {
+                const T a_ip = alpha * (trans_a == transpose_op::none ? a[static_cast<size_t>(i) * lda + p] : a[static_cast<size_t>(p) * lda + i]);
+                const T *b_row = b + static_cast<size_t>(p) * ldb;
+                for (uint32_t j = 0; j < n; j++)
+                    c_row[j] += a_ip * b_row[j];
+            }
+        }
+    } else if (trans_a == transpose_op::none) {
+        /* A * B^T, each element of C is a dot product of two contiguous rows */
+        for (uint32_t i = 0; i < m; i++) {
+            const T *a_row = a + static_cast<size_t>(i) * lda;
+            T *c_row = c + static_cast<size_t>(i) * ldc;
+            for (uint32_t j = 0; j < n; j++) {
+                const T *b_row = b + static_cast<size_t>(j) * ldb;
+                T sum = 0;
+                for (uint32_t p = 0; p < k; p++)
+                    sum += a_row[p] * b_row[p];
+                c_row[j] += alpha * sum;
+            }
+        }
+    } else {
+        /* A^T * B^T, both operands are strided (rare) */
+        for (uint32_t i = 0; i < m; i++) {
+            T *c_row = c + static_cast<size_t>(i) * ldc;
+            for (uint32_t j = 0; j < n; j++) {
+                const T *b_row = b + static_cast<size_t>(j) * ldb;
+                T sum = 0;
+                for (uint32_t p = 0; p < k; p++)
+                    sum += a[static_cast<size_t>(p) * lda + i] * b_row[p];
+                c_row[j] += alpha * sum;
+            }
+        }
+    }
+}
+
+template<typename T>
+void Gemm::blocked(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                   const T *a, uint32_t lda, transpose_op trans_a,
+                   const T *b, uint32_t ldb, transpose_op trans_b,
+                   T *c, uint32_t ldc) {
+    /* Packing buffers are reused between calls (one set per thread) */
+    thread_local std::vector<T, AlignedAllocator<T>> packed_a;
+    thread_local std::vector<T, AlignedAllocator<T>> packed_b;
+    packed_a.resize(static_cast<size_t>(MC) * KC);
+    packed_b.resize(static_cast<size_t>(KC) * NC);
+
+    /* Offsets of the (row, col) element of op(A) / op(B) in the untransposed buffers */
+    auto a_at = [&](uint32_t row, uint32_t col) {
+        return trans_a == transpose_op::none ? a + static_cast<size_t>(row) * lda + col : a + static_cast<size_t>(col) * lda + row;
+    };
+    auto b_at = [&](uint32_t row, uint32_t col) {
+        return trans_b == transpose_op::none ? b + static_cast<size_t>(row) * ldb + col : b + static_cast<size_t>(col) * ldb + row;
+    };
+
+    for (uint32_t jc = 0; jc < n; jc += NC) { /* Column blocks of op(B) and C */
+        const uint32_t nc = std::min(NC, n - jc);
+
+        for (uint32_t pc = 0; pc < k; pc += KC) { /* Blocks of the shared dimension */
+            const uint32_t kc = std::min(KC, k - pc);
+            pack_b(kc, nc, b_at(pc, jc), ldb, trans_b, packed_b.data());
+
+            for (uint32_t ic = 0; ic < m; ic += MC) { /* Row blocks of op(A) and C */
+                const uint32_t mc = std::min(MC, m - ic);
+                pack_a(mc, kc, alpha, a_at(ic, pc), lda, trans_a, packed_a.data());
+
+                /* Sweep the register tiles of the current C block */
+                for (uint32_t jr = 0; jr < nc; jr += NR<T>) {
+                    const uint32_t nr = std::min(NR<T>, nc - jr);
+                    for (uint32_t ir = 0; ir < mc; ir += MR) {
+                        const uint32_t mr = std::min(MR, mc - ir);
+                        micro_kernel(kc, packed_a.data() + static_cast<size_t>(ir) * kc, packed_b.data() + static_cast<size_t>(jr) * kc,
+                                     c + static_cast<size_t>(ic + ir) * ldc + jc + jr, ldc, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+void Gemm::pack_a(uint32_t mc, uint32_t kc, T alpha, const T *a, uint32_t lda, transpose_op trans_a, T *packed) {
+    for (uint32_t ir = 0; ir < mc; ir += MR) {
+        const uint32_t mr = std::min(MR, mc - ir);
+        for (uint32_t p = 0; p < kc; p++) {
+            for (uint32_t i = 0; i < mr; i++)
+                packed[i] = alpha * (trans_a == transpose_op::none ? a[static_cast<size_t>(ir + i) * lda + p] : a[static_cast<size_t>(p) * lda + ir + i]);
+            for (uint32_t i = mr; i < MR; i++) /* Zero padding of the last panel */
+                packed[i] = 0;
+            packed += MR;
+        }
+    }
+}
+
+template<typename T>
+void Gemm::pack_b(uint32_t kc, uint32_t nc, const T *b, uint32_t ldb, transpose_op trans_b, T *packed) {
+    for (uint32_t jr = 0; jr < nc; jr += NR<T>) {
+        const uint32_t nr = std::min(NR<T>, nc - jr);
+        for (uint32_t p = 0; p < kc; p++) {
+            if (trans_b == transpose_op::none) {
+                const T *b_row = b + static_cast<size_t>(p) * ldb + jr;
+                for (uint32_t j = 0; j < nr; j++)
+                    packed[j] = b_row[j];
+            } else {
+                for (uint32_t j = 0; j < nr; j++)
+                    packed[j] = b[static_cast<size_t>(jr + j) * ldb + p];
+            }
+            for (uint32_t j = nr; j < NR<T>; j++) /* Zero padding of the last panel */
+                packed[j] = 0;
+            packed += NR<T>;
+        }
+    }
+}
+
+template<typename T>
+void Gemm::micro_kernel(uint32_t kc, const T *__restrict a, const T *__restrict b, T *c, uint32_t ldc, uint32_t mr, uint32_t nr) {
+    /* Fixed trip counts, so the compiler keeps the whole tile in vector registers */
+    T acc[MR][NR<T>] = {};
+    for (uint32_t p = 0; p < kc; p++) {
+        for (uint32_t i = 0; i < MR; i++) {
+            const T a_ip = a[i];
+            for (uint32_t j = 0; j < NR<T>; j++)
+                acc[i][j] += a_ip * b[j];
+        }
+        a += MR;
+        b += NR<T>;
+    }
+
+    /* Write back only the valid part of the tile */
+    for (uint32_t i = 0; i < mr; i++) {
+        T *c_row = c + static_cast<size_t>(i) * ldc;
+        for (uint32_t j = 0; j < nr; j++)
+            c_row[j] += acc[i][j];
+    }
+}
+
+template void Gemm::multiply<float>(uint32_t, uint32_t, uint32_t, float, const float *, uint32_t, transpose_op, const float *, uint32_t, transpose_op, float *, uint32_t);
+template void Gemm::multiply<double>(uint32_t, uint32_t, uint32_t, double, const double *, uint32_t, transpose_op, const double *, uint32_t, transpose_op, double *, uint32_t);
+template void Gemm::parallel<float>(uint32_t, uint32_t, uint32_t, float, const float *, uint32_t, transpose_op, const float *, uint32_t, transpose_op, float *, uint32_t);
+template void Gemm::parallel<double>(uint32_t, uint32_t, uint32_t, double, const double *, uint32_t, transpose_op, const double *, uint32_t, transpose_op, double *, uint32_t);
+template void Gemm::reference<float>(uint32_t, uint32_t, uint32_t, float, const float *, uint32_t, transpose_op, const float *, uint32_t, transpose_op, float *, uint32_t);
+template void Gemm::reference<double>(uint32_t, uint32_t, uint32_t, double, const double *, uint32_t, transpose_op, const double *, uint32_t, transpose_op, double *, uint32_t);
+template void Gemm::blocked<float>(uint32_t, uint32_t, uint32_t, float, const float *, uint32_t, transpose_op, const float *, uint32_t, transpose_op, float *, uint32_t);
+template void Gemm::blocked<double>(uint32_t, uint32_t, uint32_t, double, const double *, uint32_t, transpose_op, const double *, uint32_t, transpose_op, double *, uint32_t);
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "AlignedAllocator.h"
+#include "ThreadPool.h"
+
+/** Operation applied to a gemm operand before the multiplication (the operand itself is never copied) */
+enum class transpose_op {
+    none = 0,
+    transpose,
+};
+
+/**
+ * Class containing the general matrix multiplication kernels (C += alpha * op(A) * op(B)) working on raw row-major
+ * buffers, op(X) is either X or X^T (read in place, no transposed copy is made)
+ * Kernels are templated on the element type (instantiated for float and double in Gemm.cpp)
+ * Small products use the straightforward reference loops, bigger products go through a packed, cache-blocked and
+ * register-tiled kernel (the same scheme as GotoBLAS / BLIS use), transposition is resolved while packing
+ * Large products are split into tiles of C computed in parallel by the ThreadPool (each tile runs the blocked kernel,
+ * so every element of C is summed in the same order and the result does not depend on the number of threads)
+ */
+class Gemm {
+public:
+    /** Rows of the register tile computed by the micro-kernel */
+    static constexpr uint32_t MR = 4;
+    /** Columns of the register tile computed by the micro-kernel (one cache line of C: 8 doubles / 16 floats) */
+    template<typename T>
+    static constexpr uint32_t NR = MATRIX_ALIGNMENT / sizeof(T);
+    /** Rows of the packed block of A (MC x KC block of A is meant to stay in the L2 cache) */
+    static constexpr uint32_t MC = 128;
+    /** Shared dimension of the packed blocks (KC x NR micro-panel of B is meant to stay in the L1 cache) */
+    static constexpr uint32_t KC = 256;
+    /** Columns of the packed block of B (KC x NC block of B is meant to stay in the L3 cache) */
+    static constexpr uint32_t NC = 2048;
+    /** Products with less multiply-adds (m * n * k) than this use the reference loop (packing would not pay off) */
+    static constexpr uint64_t BLOCKED_THRESHOLD = 32 * 32 * 32;
+    /** Products with less multiply-adds (m * n * k) than this stay on the calling thread (waking workers costs more) */
+    static constexpr uint64_t PARALLEL_THRESHOLD = 128 * 128 * 128;
+    /** Minimum number of rows / columns of a parallel tile of C (keeps the repacking of A and B per tile cheap) */
+    static constexpr uint32_t MIN_TILE = 64;
+    /** Number of tiles per thread the parallel product aims at (dynamic scheduling evens out the slower threads) */
+    static constexpr uint32_t TILES_PER_THREAD = 4;
+
+    /**
+     * Compute C += alpha * op(A) * op(B), picks the kernel automatically based on the size of the product
+     * @param m Number of rows of op(A) and C
+     * @param n Number of columns of op(B) and C
+     * @param k Number of columns of op(A) and rows of op(B)
+     * @param alpha Scalar multiplying the product
+     * @param a Data of A (row-major)
+     * @param lda Row stride of A
+     * @param trans_a Operation applied to A
+     * @param b Data of B (row-major)
+     * @param ldb Row stride of B
+     * @param trans_b Operation applied to B
+     * @param c Data of C (row-major)
+     * @param ldc Row stride of C
+     */
+    template<typename T>
+    static void multiply(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                         const T *a, uint32_t lda, transpose_op trans_a,
+                         const T *b, uint32_t ldb, transpose_op trans_b,
+                         T *c, uint32_t ldc);
+    /**
+     * Compute C += alpha * op(A) * op(B) with the blocked kernel split into tiles of C computed by the ThreadPool
+     * Tiles are aligned to the register tile (columns to whole cache lines), so no two threads write the same line
+     * @param m Number of rows of op(A) and C
+     * @param n Number of columns of op(B) and C
+     * @param k Number of columns of op(A) and rows of op(B)
+     * @param alpha Scalar multiplying the product
+     * @param a Data of A (row-major)
+     * @param lda Row stride of A
+     * @param trans_a Operation applied to A
+     * @param b Data of B (row-major)
+     * @param ldb Row stride of B
+     * @param trans_b Operation applied to B
+     * @param c Data of C (row-major)
+     * @param ldc Row stride of C
+     */
+    template<typename T>
+    static void parallel(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                         const T *a, uint32_t lda, transpose_op trans_a,
+                         const T *b, uint32_t ldb, transpose_op trans_b,
+                         T *c, uint32_t ldc);
+    /**
+     * Compute C += alpha * op(A) * op(B) with straightforward loops (loop order picked per transposition, so the
+     * innermost loop is contiguous whenever possible), serves as the reference for the blocked kernel
+     * @param m Number of rows of op(A) and C
+     * @param n Number of columns of op(B) and C
+     * @param k Number of columns of op(A) and rows of op(B)
+     * @param alpha Scalar multiplying the product
+     * @param a Data of A (row-major)
+     * @param lda Row stride of A
+     * @param trans_a Operation applied to A
+     * @param b Data of B (row-major)
+     * @param ldb Row stride of B
+     * @param trans_b Operation applied to B
+     * @param c Data of C (row-major)
+     * @param ldc Row stride of C
+     */
+    template<typename T>
+    static void reference(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                          const T *a, uint32_t lda, transpose_op trans_a,
+                          const T *b, uint32_t ldb, transpose_op trans_b,
+                          T *c, uint32_t ldc);
+    /**
+     * Compute C += alpha * op(A) * op(B) with the packed, cache-blocked and register-tiled kernel
+     * @param m Number of rows of op(A) and C
+     * @param n Number of columns of op(B) and C
+     * @param k Number of columns of op(A) and rows of op(B)
+     * @param alpha Scalar multiplying the product
+     * @param a Data of A (row-major)
+     * @param lda Row stride of A
+     * @param trans_a Operation applied to A
+     * @param b Data of B (row-major)
+     * @param ldb Row stride of B
+     * @param trans_b Operation applied to B
+     * @param c Data of C (row-major)
+     * @param ldc Row stride of C
+     */
+    template<typename T>
+    static void blocked(uint32_t m, uint32_t n, uint32_t k, T alpha,
+                        const T *a, uint32_t lda, transpose_op trans_a,
+                        const T *b, uint32_t ldb, transpose_op trans_b,
+                        T *c, uint32_t ldc);
+
+private:
+    /**
+     * Pack a mc x kc block of op(A) into row panels of MR rows (each panel is stored k-major, zero padded)
+     * alpha is folded in here, so the micro-kernel does not have to care about it
+     * @param mc Number of rows of the block
+     * @param kc Number of columns of the block
+     * @param alpha Scalar multiplying the product
+     * @param a Top left element of the block in A (row-major, not transposed)
+     * @param lda Row stride of A
+     * @param trans_a Operation applied to A
+     * @param packed Destination buffer (ceil(mc / MR) * MR * kc elements)
+     */
+    template<typename T>
+    static void pack_a(uint32_t mc, uint32_t kc, T alpha, const T *a, uint32_t lda, transpose_op trans_a, T *packed);
+    /**
+     * Pack a kc x nc block of op(B) into column panels of NR columns (each panel is stored k-major, zero padded)
+     * @param kc Number of rows of the block
+     * @param nc Number of columns of the block
+     * @param b Top left element of the block in B (row-major, not transposed)
+     * @param ldb Row stride of B
+     * @param trans_b Operation applied to B
+     * @param packed Destination buffer (ceil(nc / NR) * NR * kc elements)
+     */
+    template<typename T>
+    static void pack_b(uint32_t kc, uint32_t nc, const T *b, uint32_t ldb, transpose_op trans_b, T *packed);
+    /**
+     * Micro-kernel, computes one MR x NR tile of C from one packed panel of A and one packed panel of B
+     * The whole tile is accumulated in registers and written to C only once
+     * @param kc Shared dimension of the panels
+     * @param a Packed panel of A (kc x MR)
+     * @param b Packed panel of B (kc x NR)
+     * @param c Top left element of the tile of C
+     * @param ldc Row stride of C
+     * @param mr Number of valid rows of the tile (<= MR, for the edges of C)
+     * @param nr Number of valid columns of the tile (<= NR, for the edges of C)
+     */
+    template<typename T>
+    static void micro_kernel(uint32_t kc, const T *a, const T *b, T *c, uint32_t ldc, uint32_t mr, uint32_t nr);
+};
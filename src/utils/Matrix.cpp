@@ -1,222 +1,404 @@
 #include "Matrix.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+template<typename T>
+uint32_t BasicMatrix<T>::compute_stride(uint32_t cols) {
+    /* Rows shorter than one cache line are packed densely (vectors and tiny matrices would waste most of the memory) */
+    constexpr uint32_t lanes = MATRIX_ALIGNMENT / sizeof(T);
+    if (cols < lanes)
+        return cols;
+    return (cols + lanes - 1) / lanes * lanes;
+}
+
+template<typename T>
+void BasicMatrix<T>::restride(uint32_t new_stride) {
+    std::vector<T, AlignedAllocator<T>> new_data(static_cast<size_t>(this->rows) * new_stride, 0.);
+    for (uint32_t i = 0; i < this->rows; i++)
+        std::memcpy(new_data.data() + static_cast<size_t>(i) * new_stride, this->data.data() + static_cast<size_t>(i) * this->stride, this->cols * sizeof(T));
+
+    this->data = std::move(new_data);
+    this->stride = new_stride;
+}
+
+template<typename T>
+void BasicMatrix<T>::elementwise(void (*kernel)(const T *, const T *, T *, size_t), const BasicMatrix<T> &a, const BasicMatrix<T> &b, BasicMatrix<T> &c) {
+    if (a.stride == a.cols && b.stride == b.cols && c.stride == c.cols) {
+        kernel(a.data.data(), b.data.data(), c.data.data(), static_cast<size_t>(a.rows) * a.cols);
+        return;
+    }
+
+    for (uint32_t i = 0; i < a.rows; i++)
+        kernel(a.data.data() + static_cast<size_t>(i) * a.stride, b.data.data() + static_cast<size_t>(i) * b.stride,
+               c.data.data() + static_cast<size_t>(i) * c.stride, a.cols);
+}
 
-Matrix::Matrix(uint32_t rows, uint32_t cols, bool randomize) : rows(rows), cols(cols) {
-    this->data = std::vector<std::vector<double>>(rows, std::vector<double>(cols, 0));
+template<typename T>
+void BasicMatrix<T>::scale(const BasicMatrix<T> &a, T alpha, BasicMatrix<T> &c) {
+    const auto &kernels = Backend::kernels<T>();
+    if (a.stride == c.stride) { /* Same layout, padding is zero, so the whole buffer can be scaled at once */
+        kernels.scale(a.data.data(), alpha, c.data.data(), static_cast<size_t>(a.rows) * a.stride);
+        return;
+    }
+
+    for (uint32_t i = 0; i < a.rows; i++)
+        kernels.scale(a.data.data() + static_cast<size_t>(i) * a.stride, alpha, c.data.data() + static_cast<size_t>(i) * c.stride, a.cols);
+}
+
+template<typename T>
+BasicMatrix<T>::BasicMatrix(uint32_t rows, uint32_t cols, bool randomize) : rows(rows), cols(cols), stride(compute_stride(cols)) {
+    this->data = std::vector<T, AlignedAllocator<T>>(static_cast<size_t>(rows) * this->stride, 0.);
     if (randomize)
         this->randomize();
 }
 
-Matrix::Matrix(uint32_t rows, uint32_t cols, const std::vector<std::vector<double>> &data) : rows(rows), cols(cols) {
+template<typename T>
+BasicMatrix<T>::BasicMatrix(uint32_t rows, uint32_t cols, const std::vector<std::vector<T>> &data) : rows(rows), cols(cols), stride(compute_stride(cols)) {
     /* Creates a deep copy of the data */
-    auto data_deep_copy = std::vector<std::vector<double>>(rows, std::vector<double>(cols, 0));
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < cols; j++)
-            data_deep_copy[i][j] = data[i][j];
-
-    this->data = data_deep_copy;
+    this->data = std::vector<T, AlignedAllocator<T>>(static_cast<size_t>(rows) * this->stride, 0.);
+    for (uint32_t i = 0; i < rows; i++)
+        std::memcpy(this->data.data() + static_cast<size_t>(i) * this->stride, data[i].data(), cols * sizeof(T));
 }
 
-Matrix::Matrix(const Matrix &other) noexcept : rows(other.rows), cols(other.cols) {
-    /* Creates a deep copy of the data */
-    auto data_deep_copy = std::vector<std::vector<double>>(rows, std::vector<double>(cols, 0));
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < cols; j++)
-            data_deep_copy[i][j] = other.data[i][j];
+template<typename T>
+template<typename U> requires (!std::is_same_v<U, T>)
+BasicMatrix<T>::BasicMatrix(const BasicMatrix<U> &other) : rows(other.rows), cols(other.cols), stride(compute_stride(other.cols)) {
+    this->data = std::vector<T, AlignedAllocator<T>>(static_cast<size_t>(rows) * this->stride, 0.);
+    for (uint32_t i = 0; i < this->rows; i++) {
+        const U *src = other.data.data() + static_cast<size_t>(i) * other.stride;
+        T *dst = this->data.data() + static_cast<size_t>(i) * this->stride;
+        for (uint32_t j = 0; j < this->cols; j++)
+            dst[j] = static_cast<T>(src[j]);
+    }
+}
 
-    this->data = data_deep_copy;
+template<typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix<T> &other) noexcept : rows(other.rows), cols(other.cols), stride(other.stride), data(other.data) {
+    /* empty (one contiguous buffer, so the copy is a single allocation and memcpy) */
 }
 
-Matrix::Matrix(Matrix &&other) noexcept : rows(other.rows), cols(other.cols) {
+template<typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix<T> &&other) noexcept : rows(other.rows), cols(other.cols), stride(other.stride) {
     this->data = std::move(other.data);
     other.rows = 0;
     other.cols = 0;
+    other.stride = 0;
 }
 
-Matrix::~Matrix() = default;
+template<typename T>
+BasicMatrix<T>::~BasicMatrix() = default;
+
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::transpose() const {
+    BasicMatrix transposed(this->cols, this->rows, false);
+    for (uint32_t i = 0; i < this->rows; i++) {
+        const T *src = this->data.data() + static_cast<size_t>(i) * this->stride;
+        for (uint32_t j = 0; j < this->cols; j++)
+            transposed.data[static_cast<size_t>(j) * transposed.stride + i] = src[j];
+    }
+
+    return transposed;
+}
+
+template<typename T>
+void BasicMatrix<T>::gemm(T alpha, BasicMatrixView<T> a, transpose_op trans_a, BasicMatrixView<T> b, transpose_op trans_b, T beta, BasicMatrix<T> &c) {
+    const uint32_t m = trans_a == transpose_op::none ? a.get_rows() : a.get_cols();
+    const uint32_t k = trans_a == transpose_op::none ? a.get_cols() : a.get_rows();
+    const uint32_t k_b = trans_b == transpose_op::none ? b.get_rows() : b.get_cols();
+    const uint32_t n = trans_b == transpose_op::none ? b.get_cols() : b.get_rows();
+
+    /* Check if the dimensions are compatible */
+    if (k != k_b || ((c.rows != m || c.cols != n) && beta != 0.)) {
+        std::cerr << m << " x " << k << " * " << k_b << " x " << n << " -> " << c.rows << " x " << c.cols << std::endl;
+        throw std::runtime_error("Matrix multiplication error: incompatible dimensions");
+    }
+
+    /* Kernels read row-major operands only, a view with unit row stride is a transposed row-major block instead */
+    auto resolve = [](const BasicMatrixView<T> &view, transpose_op trans, uint32_t &ld, transpose_op &op) {
+        if (view.get_col_stride() == 1 || view.get_cols() == 1) {
+            ld = view.get_cols() == 1 && view.get_rows() == 1 ? 1 : static_cast<uint32_t>(view.get_row_stride());
+            op = trans;
+        } else if (view.get_row_stride() == 1 || view.get_rows() == 1) {
+            ld = static_cast<uint32_t>(view.get_col_stride());
+            op = trans == transpose_op::none ? transpose_op::transpose : transpose_op::none;
+        } else {
+            throw std::runtime_error("Matrix multiplication error: operand view has no unit stride");
+        }
+    };
+    uint32_t lda, ldb;
+    transpose_op op_a, op_b;
+    resolve(a, trans_a, lda, op_a);
+    resolve(b, trans_b, ldb, op_b);
+
+    /* New C has nothing to scale (beta = 0 overwrites, so uninitialized / NaN values in C do not leak into the result) */
+    if (c.rows != m || c.cols != n) {
+        c = BasicMatrix(m, n, false);
+        beta = 0;
+    }
+
+    Backend::kernels<T>().gemm(m, n, k, alpha, a.get_data(), lda, op_a, b.get_data(), ldb, op_b, beta, c.data.data(), c.stride);
+}
+
+template<typename T>
+void BasicMatrix<T>::axpy(T alpha, const BasicMatrix<T> &x, BasicMatrix<T> &y) {
+    if (x.rows != y.rows || x.cols != y.cols)
+        throw std::runtime_error("Matrix elementwise operation error: incompatible dimensions");
+
+    const auto &kernels = Backend::kernels<T>();
+    if (x.stride == y.stride) { /* Same layout, padding is zero, so the whole buffer can be processed at once */
+        kernels.axpy(alpha, x.data.data(), y.data.data(), static_cast<size_t>(y.rows) * y.stride);
+        return;
+    }
+
+    for (uint32_t i = 0; i < y.rows; i++)
+        kernels.axpy(alpha, x.data.data() + static_cast<size_t>(i) * x.stride, y.data.data() + static_cast<size_t>(i) * y.stride, y.cols);
+}
 
-Matrix Matrix::transpose() const {
-    std::vector<std::vector<double>> transposed_data(this->cols, std::vector<double>(this->rows, 0));
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++)
-            transposed_data[j][i] = this->data[i][j];
+template<typename T>
+void BasicMatrix<T>::scal(T alpha, BasicMatrix<T> &x) {
+    scale(x, alpha, x);
+}
 
-    return {this->cols, this->rows, transposed_data};
+template<typename T>
+void BasicMatrix<T>::zero() {
+    std::fill(this->data.begin(), this->data.end(), 0.);
 }
 
-void Matrix::randomize() {
-    std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
-    std::uniform_real_distribution<double> dist(-1, 1);
+template<typename T>
+void BasicMatrix<T>::randomize() {
+    /* Element (i, j) is element i * cols + j of the sequence, so the rows can be filled in any order by any thread */
+    const auto generator = Random::get_generator(random_stream::weights);
+    const auto fill_rows = [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; i++)
+            generator.fill_uniform<T>(this->data.data() + static_cast<size_t>(i) * this->stride, this->cols,
+                                      static_cast<uint64_t>(i) * this->cols, -1, 1);
+    };
+
+    const size_t size = static_cast<size_t>(this->rows) * this->cols;
+    const uint32_t threads = ThreadPool::get_num_threads();
+    if (size < PARALLEL_RANDOMIZE_THRESHOLD || threads == 1 || this->rows == 1) {
+        fill_rows(0, this->rows);
+        return;
+    }
 
-    for (auto &row : this->data)
-        for (auto &col : row)
-            col = dist(gen);
+    const uint32_t chunks = std::min(this->rows, threads * RANDOMIZE_CHUNKS_PER_THREAD);
+    ThreadPool::parallel_for(chunks, [&](uint32_t chunk) {
+        fill_rows(static_cast<uint32_t>(static_cast<uint64_t>(this->rows) * chunk / chunks),
+                  static_cast<uint32_t>(static_cast<uint64_t>(this->rows) * (chunk + 1) / chunks));
+    });
 }
 
-Matrix Matrix::log() const {
-    auto result = std::vector<std::vector<double>>(this->rows, std::vector<double>(this->cols, 0));
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++)
-            result[i][j] = std::log(this->data[i][j]);
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::log() const {
+    BasicMatrix result(this->rows, this->cols, false);
+    const auto &kernels = Backend::kernels<T>();
+    if (this->stride == this->cols) { /* No padding, so the whole buffer can be processed at once */
+        kernels.log(this->data.data(), result.data.data(), this->data.size());
+        return result;
+    }
+    for (uint32_t i = 0; i < this->rows; i++)
+        kernels.log(this->data.data() + static_cast<size_t>(i) * this->stride, result.data.data() + static_cast<size_t>(i) * result.stride, this->cols);
 
-    return {this->rows, this->cols, result};
+    return result;
 }
 
-void Matrix::set_value(uint32_t row, uint32_t col, double value) {
-    this->data[row][col] = value;
+template<typename T>
+void BasicMatrix<T>::set_value(uint32_t row, uint32_t col, T value) {
+    this->data[static_cast<size_t>(row) * this->stride + col] = value;
 }
 
-void Matrix::set_row(uint32_t row, const std::vector<double> &values) {
-    this->data[row] = values;
+template<typename T>
+void BasicMatrix<T>::set_row(uint32_t row, const std::vector<T> &values) {
+    std::memcpy(this->data.data() + static_cast<size_t>(row) * this->stride, values.data(), this->cols * sizeof(T));
 }
 
-void Matrix::set_col(uint32_t col, const std::vector<double> &values) {
-    for (int i = 0; i < this->rows; i++)
-        this->data[i][col] = values[i];
+template<typename T>
+void BasicMatrix<T>::set_col(uint32_t col, const std::vector<T> &values) {
+    for (uint32_t i = 0; i < this->rows; i++)
+        this->data[static_cast<size_t>(i) * this->stride + col] = values[i];
 }
 
-void Matrix::set_values(const std::vector<std::vector<double>> &values) {
-    this->data = values;
+template<typename T>
+void BasicMatrix<T>::set_values(const std::vector<std::vector<T>> &values) {
+    this->rows = values.size();
+    this->cols = values.empty() ? 0 : values[0].size();
+    this->stride = compute_stride(this->cols);
+    this->data.assign(static_cast<size_t>(this->rows) * this->stride, 0.);
+    for (uint32_t i = 0; i < this->rows; i++)
+        std::memcpy(this->data.data() + static_cast<size_t>(i) * this->stride, values[i].data(), this->cols * sizeof(T));
 }
 
-void Matrix::add_row(const std::vector<double> &values) {
-    this->data.push_back(values);
+template<typename T>
+void BasicMatrix<T>::add_row(const std::vector<T> &values) {
+    /* Buffer grows geometrically (std::vector), so appending rows is amortized O(cols) */
+    this->data.resize(static_cast<size_t>(this->rows + 1) * this->stride, 0.);
+    std::memcpy(this->data.data() + static_cast<size_t>(this->rows) * this->stride, values.data(), this->cols * sizeof(T));
     this->rows++;
 }
 
-void Matrix::add_col(const std::vector<double> &values) {
-    for (int i = 0; i < this->rows; i++)
-        this->data[i].push_back(values[i]);
+template<typename T>
+void BasicMatrix<T>::add_col(const std::vector<T> &values) {
+    if (this->cols == this->stride) /* No padding left, the rows have to be spread */
+        this->restride(compute_stride(this->cols + 1));
+    for (uint32_t i = 0; i < this->rows; i++)
+        this->data[static_cast<size_t>(i) * this->stride + this->cols] = values[i];
     this->cols++;
 }
 
-void Matrix::remove_row(uint32_t row_idx) {
-    this->data.erase(this->data.begin() + row_idx);
+template<typename T>
+void BasicMatrix<T>::remove_row(uint32_t row_idx) {
+    this->data.erase(this->data.begin() + static_cast<std::ptrdiff_t>(row_idx) * this->stride,
+                     this->data.begin() + static_cast<std::ptrdiff_t>(row_idx + 1) * this->stride);
     this->rows--;
 }
 
-void Matrix::remove_col(uint32_t col_idx) {
-    for (int i = 0; i < this->rows; i++)
-        this->data[i].erase(this->data[i].begin() + col_idx);
+template<typename T>
+void BasicMatrix<T>::remove_col(uint32_t col_idx) {
+    /* The stride is kept, the freed column becomes padding */
+    for (uint32_t i = 0; i < this->rows; i++) {
+        T *row = this->data.data() + static_cast<size_t>(i) * this->stride;
+        std::memmove(row + col_idx, row + col_idx + 1, (this->cols - col_idx - 1) * sizeof(T));
+        row[this->cols - 1] = 0.;
+    }
     this->cols--;
 }
 
 
-double Matrix::get_value(uint32_t row, uint32_t col) const {
-    return this->data[row][col];
+template<typename T>
+T BasicMatrix<T>::get_value(uint32_t row, uint32_t col) const {
+    return this->data[static_cast<size_t>(row) * this->stride + col];
 }
 
-Matrix Matrix::get_row(uint32_t row) const {
-    auto row_data = this->data[row];
-    auto new_matrix_data = std::vector<std::vector<double>>(1, row_data);
-    Matrix result(1, this->cols, new_matrix_data);
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::get_row(uint32_t row) const {
+    BasicMatrix result(1, this->cols, false);
+    std::memcpy(result.data.data(), this->data.data() + static_cast<size_t>(row) * this->stride, this->cols * sizeof(T));
     return result;
 }
 
-Matrix Matrix::get_col(uint32_t col) const {
-    std::vector<double> col_data;
-    col_data.reserve(this->rows);
-    for (int i = 0; i < this->rows; i++)
-        col_data.push_back(this->data[i][col]);
-    auto new_matrix_data = std::vector<std::vector<double>>(this->rows, col_data);
-    Matrix result(this->rows, 1, new_matrix_data);
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::get_col(uint32_t col) const {
+    BasicMatrix result(this->rows, 1, false);
+    for (uint32_t i = 0; i < this->rows; i++)
+        result.data[i] = this->data[static_cast<size_t>(i) * this->stride + col];
     return result;
 }
 
-std::vector<std::vector<double>> Matrix::get_values() const {
-    return this->data;
+template<typename T>
+std::vector<std::vector<T>> BasicMatrix<T>::get_values() const {
+    std::vector<std::vector<T>> values(this->rows);
+    for (uint32_t i = 0; i < this->rows; i++) {
+        auto row = this->data.begin() + static_cast<std::ptrdiff_t>(i) * this->stride;
+        values[i].assign(row, row + this->cols);
+    }
+    return values;
 }
 
-std::vector<uint32_t> Matrix::get_dims() const {
+template<typename T>
+std::vector<uint32_t> BasicMatrix<T>::get_dims() const {
     return {this->rows, this->cols};
 }
 
-uint32_t Matrix::argmax() const {
-    double max = this->data[0][0];
+template<typename T>
+uint32_t BasicMatrix<T>::get_stride() const {
+    return this->stride;
+}
+
+template<typename T>
+T *BasicMatrix<T>::get_data() {
+    return this->data.data();
+}
+
+template<typename T>
+const T *BasicMatrix<T>::get_data() const {
+    return this->data.data();
+}
+
+template<typename T>
+uint32_t BasicMatrix<T>::argmax() const {
+    T max = this->data[0];
     uint32_t max_idx = 0;
 
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++)
-            if (this->data[i][j] > max) {
-                max = this->data[i][j];
+    for (uint32_t i = 0; i < this->rows; i++)
+        for (uint32_t j = 0; j < this->cols; j++)
+            if (this->data[static_cast<size_t>(i) * this->stride + j] > max) {
+                max = this->data[static_cast<size_t>(i) * this->stride + j];
                 max_idx = i * this->cols + j;
             }
 
     return max_idx;
 }
 
-Matrix &Matrix::operator=(const Matrix &other) noexcept {
+template<typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator=(const BasicMatrix<T> &other) noexcept {
     this->rows = other.rows;
     this->cols = other.cols;
-
-    auto data_deep_copy = std::vector<std::vector<double>>(rows, std::vector<double>(cols, 0));
-    for (int i = 0; i < rows; i++)
-        for (int j = 0; j < cols; j++)
-            data_deep_copy[i][j] = other.data[i][j];
-
-    this->data = data_deep_copy;
+    this->stride = other.stride;
+    this->data = other.data; /* Reuses the existing buffer if it is large enough */
     return *this;
 }
 
-Matrix &Matrix::operator=(Matrix &&other) noexcept {
+template<typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator=(BasicMatrix<T> &&other) noexcept {
     this->rows = other.rows;
     this->cols = other.cols;
+    this->stride = other.stride;
     this->data = std::move(other.data);
     other.rows = 0;
     other.cols = 0;
+    other.stride = 0;
     return *this;
 }
 
-Matrix Matrix::operator+(const Matrix &other) const {
-    auto result = std::vector<std::vector<double>>(this->rows, std::vector<double>(this->cols, 0));
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++)
-            result[i][j] = this->data[i][j] + other.data[i][j];
-
-    return {this->rows, this->cols, result};
-}
-
-Matrix Matrix::operator-(const Matrix &other) const {
-    auto result = std::vector<std::vector<double>>(this->rows, std::vector<double>(this->cols, 0));
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++)
-            result[i][j] = this->data[i][j] - other.data[i][j];
-
-    return {this->rows, this->cols, result};
-}
-
-Matrix Matrix::operator*(const Matrix &other) const {
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix<T> &other) const {
     /* Check if the dimensions are compatible */
     if (this->cols != other.rows) {
         std::cerr << this->rows << " x " << this->cols << " * " << other.rows << " x " << other.cols << std::endl;
         throw std::runtime_error("Matrix multiplication error: incompatible dimensions");
     }
 
-    /* Perform matrix multiplication */
-    auto result = std::vector<std::vector<double>>(this->rows, std::vector<double>(other.cols, 0));
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < other.cols; j++)
-            for (int k = 0; k < this->cols; k++)
-                result[i][j] += this->data[i][k] * other.data[k][j];
+    /* Perform matrix multiplication (backend picks the kernel) */
+    BasicMatrix result(this->rows, other.cols, false);
+    Backend::kernels<T>().gemm(this->rows, other.cols, this->cols, T(1), this->data.data(), this->stride, transpose_op::none,
+                               other.data.data(), other.stride, transpose_op::none, T(0), result.data.data(), result.stride);
 
-    return {this->rows, other.cols, result};
+    return result;
 }
 
-Matrix Matrix::operator*(double scalar) const {
-    auto result = std::vector<std::vector<double>>(this->rows, std::vector<double>(this->cols, 0));
-    for (int i = 0; i < this->rows; i++)
-        for (int j = 0; j < this->cols; j++)
-            result[i][j] = this->data[i][j] * scalar;
+template<typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator+=(const BasicMatrix<T> &other) {
+    elementwise(Backend::kernels<T>().add, *this, other, *this);
+    return *this;
+}
 
-    return {this->rows, this->cols, result};
+template<typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator-=(const BasicMatrix<T> &other) {
+    elementwise(Backend::kernels<T>().sub, *this, other, *this);
+    return *this;
+}
+
+template<typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator*=(T scalar) {
+    scal(scalar, *this);
+    return *this;
 }
 
 
-std::ostream &operator<<(std::ostream &os, const Matrix &matrix) {
-    for (const auto &row : matrix.data) {
-        for (const auto &col : row)
-            os << col << " ";
+template<typename T>
+std::ostream &operator<<(std::ostream &os, const BasicMatrix<T> &matrix) {
+    for (uint32_t i = 0; i < matrix.get_rows(); i++) {
+        for (uint32_t j = 0; j < matrix.get_cols(); j++)
+            os << matrix.get_value(i, j) << " ";
         os << std::endl;
     }
 
     return os;
 }
+
+template class BasicMatrix<float>;
+template class BasicMatrix<double>;
+template BasicMatrix<float>::BasicMatrix(const BasicMatrix<double> &other);
+template BasicMatrix<double>::BasicMatrix(const BasicMatrix<float> &other);
+template std::ostream &operator<<(std::ostream &os, const BasicMatrix<float> &matrix);
+template std::ostream &operator<<(std::ostream &os, const BasicMatrix<double> &matrix);
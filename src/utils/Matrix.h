@@ -5,19 +5,92 @@
 #include <memory>
 #include <random>
 #include <chrono>
+#include <cstring>
+#include "AlignedAllocator.h"
+#include "Backend.h"
+#include "MatrixExpr.h"
+#include "MatrixView.h"
 
 /**
- * Class representing a matrix of doubles
+ * Class representing a matrix of floating point values
  * Main reason for this class is to make matrix operations easier
+ * Data are stored row-major in one contiguous aligned buffer, rows are "stride" elements apart
+ * Member functions are defined in Matrix.cpp and instantiated for float and double (see Matrix / MatrixF below)
+ * @tparam T Element type (float / double)
  */
-class Matrix {
+template<typename T>
+class BasicMatrix {
+    /* Converting constructor reads the buffer of the other precision directly */
+    template<typename U>
+    friend class BasicMatrix;
+
+public:
+    /** Element type */
+    using value_type = T;
+
 private:
+    /** Number of elements from which randomize() fills the rows in parallel */
+    static constexpr size_t PARALLEL_RANDOMIZE_THRESHOLD = 1 << 16;
+    /** Number of row chunks per thread of the parallel randomize() (dynamic load balancing) */
+    static constexpr uint32_t RANDOMIZE_CHUNKS_PER_THREAD = 4;
     /** Number of rows */
     uint32_t rows;
     /** Number of columns */
     uint32_t cols;
-    /** Data of the matrix */
-    std::vector<std::vector<double>> data;
+    /** Distance (in elements) between the starts of two consecutive rows (stride >= cols) */
+    uint32_t stride;
+    /** Data of the matrix (row-major, rows * stride elements, padding is kept at zero) */
+    std::vector<T, AlignedAllocator<T>> data;
+
+    /**
+     * Compute the row stride for the given number of columns
+     * Narrow rows are packed densely, wider rows are padded so each row starts on a cache line
+     * @param cols Number of columns
+     * @return Row stride (in elements)
+     */
+    static uint32_t compute_stride(uint32_t cols);
+    /**
+     * Change the row stride of the matrix (moves the data into a new buffer)
+     * @param new_stride New row stride (has to be >= cols)
+     */
+    void restride(uint32_t new_stride);
+    /**
+     * Apply an elementwise kernel (c = a op b) to matrices of the same dimensions
+     * Buffers without padding are processed in one call, otherwise row by row
+     * @param kernel Elementwise kernel (from Backend)
+     * @param a First operand
+     * @param b Second operand
+     * @param c Result (can alias a or b)
+     */
+    static void elementwise(void (*kernel)(const T *, const T *, T *, size_t), const BasicMatrix &a, const BasicMatrix &b, BasicMatrix &c);
+    /**
+     * Scale a matrix into another matrix of the same dimensions (c = alpha * a)
+     * @param a Operand
+     * @param alpha Scalar
+     * @param c Result (can alias a)
+     */
+    static void scale(const BasicMatrix &a, T alpha, BasicMatrix &c);
+    /**
+     * Evaluate a matrix expression into this matrix (dimensions have to match already)
+     * Simple expressions are mapped onto the backend kernels, everything else is evaluated in one fused loop
+     * @param expr Expression to evaluate
+     */
+    template<matrix_expr E>
+    void assign(const E &expr) {
+        if constexpr (std::is_same_v<E, MatrixBinaryExpr<BasicMatrix, BasicMatrix, matrix_op_add>>)
+            elementwise(Backend::kernels<T>().add, expr.get_left(), expr.get_right(), *this);
+        else if constexpr (std::is_same_v<E, MatrixBinaryExpr<BasicMatrix, BasicMatrix, matrix_op_sub>>)
+            elementwise(Backend::kernels<T>().sub, expr.get_left(), expr.get_right(), *this);
+        else if constexpr (std::is_same_v<E, MatrixScalarExpr<BasicMatrix, matrix_op_mul>>)
+            scale(expr.get_operand(), expr.get_scalar(), *this);
+        else {
+            for (uint32_t i = 0; i < this->rows; i++) {
+                T *row = this->data.data() + static_cast<size_t>(i) * this->stride;
+                for (uint32_t j = 0; j < this->cols; j++)
+                    row[j] = expr.eval(i, j);
+            }
+        }
+    }
 
 public:
     /**
@@ -26,43 +99,90 @@ public:
      * @param cols Number of columns
      * @param randomize Flag if the matrix should be randomized
      */
-    Matrix(uint32_t rows, uint32_t cols, bool randomize = false);
+    BasicMatrix(uint32_t rows, uint32_t cols, bool randomize = false);
     /**
      * Constructor with data
      * @param rows Number of rows
      * @param cols Number of columns
      * @param data Data of the matrix
      */
-    Matrix(uint32_t rows, uint32_t cols, const std::vector<std::vector<double>> &data);
+    BasicMatrix(uint32_t rows, uint32_t cols, const std::vector<std::vector<T>> &data);
+    /**
+     * Constructor from a matrix expression (evaluates the expression in one fused pass)
+     * @param expr Expression to evaluate
+     */
+    template<matrix_expr_of<T> E>
+    BasicMatrix(const E &expr) : BasicMatrix(expr.get_rows(), expr.get_cols(), false) {
+        this->assign(expr);
+    }
+    /**
+     * Converting constructor from a matrix of the other precision (explicit, so precision changes are always visible)
+     * @param other Matrix to convert
+     */
+    template<typename U> requires (!std::is_same_v<U, T>)
+    explicit BasicMatrix(const BasicMatrix<U> &other);
     /**
      * Copy constructor
      * @param other Matrix to copy
      */
-    Matrix(const Matrix &other) noexcept;
+    BasicMatrix(const BasicMatrix &other) noexcept;
     /**
      * Move constructor
      * @param other Matrix to move
      */
-    Matrix(Matrix &&other) noexcept;
+    BasicMatrix(BasicMatrix &&other) noexcept;
     /**
      * Default destructor
      */
-    ~Matrix();
+    ~BasicMatrix();
 
     /**
      * Transpose the matrix
      * @return New transposed matrix (original matrix is not changed)
      */
-    [[nodiscard]] Matrix transpose() const;
+    [[nodiscard]] BasicMatrix transpose() const;
+    /**
+     * General matrix multiplication C = alpha * op(A) * op(B) + beta * C (BLAS gemm)
+     * Transposed operands are read in place (no transposed copies), with beta = 1 the product is accumulated into C
+     * If beta is 0, C is resized to the dimensions of the product when needed (and its old values are ignored)
+     * A and B can be whole matrices or views (rows, slices, transposed views), C must not overlap them
+     * @param alpha Scalar multiplying the product
+     * @param a Matrix A
+     * @param trans_a Operation applied to A (none / transpose)
+     * @param b Matrix B
+     * @param trans_b Operation applied to B (none / transpose)
+     * @param beta Scalar multiplying C
+     * @param c Matrix C (result)
+     */
+    static void gemm(T alpha, BasicMatrixView<T> a, transpose_op trans_a, BasicMatrixView<T> b, transpose_op trans_b, T beta, BasicMatrix &c);
+    /**
+     * Y = alpha * X + Y (BLAS axpy), in place
+     * @param alpha Scalar multiplying X
+     * @param x Matrix X
+     * @param y Matrix Y (result)
+     */
+    static void axpy(T alpha, const BasicMatrix &x, BasicMatrix &y);
+    /**
+     * X = alpha * X (BLAS scal), in place
+     * @param alpha Scalar
+     * @param x Matrix X (result)
+     */
+    static void scal(T alpha, BasicMatrix &x);
+    /**
+     * Set all values of the matrix to zero (dimensions are kept, no allocation)
+     */
+    void zero();
     /**
      * Randomize the matrix data values (uniform real distribution from -1 to 1)
+     * Values come from the next sequence of the weights stream (see Random), big matrices are filled in parallel
+     * with the same result for any number of threads
      */
     void randomize();
     /**
      * Apply log function to all values in the matrix
      * @return New matrix with log values (original matrix is not changed)
      */
-    [[nodiscard]] Matrix log() const;
+    [[nodiscard]] BasicMatrix log() const;
 
     /**
      * Set the value at the given position
@@ -70,34 +190,34 @@ public:
      * @param col Column index
      * @param value Value to set
      */
-    void set_value(uint32_t row, uint32_t col, double value);
+    void set_value(uint32_t row, uint32_t col, T value);
     /**
      * Set the values of the given row
      * @param row Row index
      * @param values Values to set
      */
-    void set_row(uint32_t row, const std::vector<double> &values);
+    void set_row(uint32_t row, const std::vector<T> &values);
     /**
      * Set the values of the given column
      * @param col Column index
      * @param values Values to set
      */
-    void set_col(uint32_t col, const std::vector<double> &values);
+    void set_col(uint32_t col, const std::vector<T> &values);
     /**
      * Set the values of the matrix
      * @param values Values to set
      */
-    void set_values(const std::vector<std::vector<double>> &values);
+    void set_values(const std::vector<std::vector<T>> &values);
     /**
      * Add a row to the matrix
      * @param values Values of the row to add
      */
-    void add_row(const std::vector<double> &values);
+    void add_row(const std::vector<T> &values);
     /**
      * Add a column to the matrix
      * @param values Values of the column to add
      */
-    void add_col(const std::vector<double> &values);
+    void add_col(const std::vector<T> &values);
     /**
      * Remove a row from the matrix
      * @param row_idx Index of the row to remove
@@ -114,29 +234,94 @@ public:
      * @param col Column index
      * @return Value at the given position
      */
-    [[nodiscard]] double get_value(uint32_t row, uint32_t col) const;
+    [[nodiscard]] T get_value(uint32_t row, uint32_t col) const;
+    /**
+     * Get the view of the whole matrix (no copy)
+     * @return View of the matrix
+     */
+    [[nodiscard]] BasicMatrixView<T> get_view() const { return {this->data.data(), this->rows, this->cols, this->stride}; }
+    /**
+     * Get the view of the row at the given position (no copy)
+     * @param row Row index
+     * @return View of the row (1 x cols)
+     */
+    [[nodiscard]] BasicMatrixView<T> get_row_view(uint32_t row) const { return this->get_view().get_row_view(row); }
+    /**
+     * Get the view of the column at the given position (no copy)
+     * @param col Column index
+     * @return View of the column (rows x 1)
+     */
+    [[nodiscard]] BasicMatrixView<T> get_col_view(uint32_t col) const { return this->get_view().get_col_view(col); }
+    /**
+     * Get the view of a rectangular block of the matrix (no copy)
+     * @param row First row of the block
+     * @param col First column of the block
+     * @param block_rows Number of rows of the block
+     * @param block_cols Number of columns of the block
+     * @return View of the block
+     */
+    [[nodiscard]] BasicMatrixView<T> get_block_view(uint32_t row, uint32_t col, uint32_t block_rows, uint32_t block_cols) const {
+        return this->get_view().get_block_view(row, col, block_rows, block_cols);
+    }
+    /**
+     * Implicit conversion to a view, so functions taking views accept whole matrices too
+     * @return View of the matrix
+     */
+    operator BasicMatrixView<T>() const { return this->get_view(); }
     /**
      * Get the row at the given position
      * @param row Row index
      * @return Row at the given position
      */
-    [[nodiscard]] Matrix get_row(uint32_t row) const;
+    [[nodiscard]] BasicMatrix get_row(uint32_t row) const;
     /**
      * Get the column at the given position
      * @param col Column index
      * @return Column at the given position
      */
-    [[nodiscard]] Matrix get_col(uint32_t col) const;
+    [[nodiscard]] BasicMatrix get_col(uint32_t col) const;
     /**
      * Get the values of the matrix
      * @return Values of the matrix
      */
-    [[nodiscard]] std::vector<std::vector<double>> get_values() const;
+    [[nodiscard]] std::vector<std::vector<T>> get_values() const;
     /**
      * Get the dimensions of the matrix (rows x cols)
      * @return Dimensions of the matrix (rows x cols)
      */
     [[nodiscard]] std::vector<uint32_t> get_dims() const;
+    /**
+     * Get the number of rows of the matrix
+     * @return Number of rows
+     */
+    [[nodiscard]] uint32_t get_rows() const { return this->rows; }
+    /**
+     * Get the number of columns of the matrix
+     * @return Number of columns
+     */
+    [[nodiscard]] uint32_t get_cols() const { return this->cols; }
+    /**
+     * Get the value at the given position (inline variant of get_value used by the expression templates)
+     * @param row Row index
+     * @param col Column index
+     * @return Value at the given position
+     */
+    [[nodiscard]] T eval(uint32_t row, uint32_t col) const { return this->data[static_cast<size_t>(row) * this->stride + col]; }
+    /**
+     * Get the row stride of the matrix (distance between two rows in elements)
+     * @return Row stride of the matrix
+     */
+    [[nodiscard]] uint32_t get_stride() const;
+    /**
+     * Get the pointer to the raw data of the matrix (row-major, rows are get_stride() elements apart)
+     * @return Pointer to the raw data
+     */
+    [[nodiscard]] T *get_data();
+    /**
+     * Get the pointer to the raw data of the matrix (row-major, rows are get_stride() elements apart)
+     * @return Pointer to the raw data
+     */
+    [[nodiscard]] const T *get_data() const;
     /**
      * Get the index of the maximum value in the matrix
      * @return Index of the maximum value in the matrix
@@ -148,42 +333,91 @@ public:
      * @param other Matrix to copy
      * @return Copied matrix
      */
-    Matrix &operator=(const Matrix &other) noexcept;
+    BasicMatrix &operator=(const BasicMatrix &other) noexcept;
     /**
      * Move assignment operator
      * @param other Matrix to move
      * @return Moved matrix
      */
-    Matrix &operator=(Matrix &&other) noexcept;
-    /**
-     * Overloaded addition operator
-     * @param other Matrix to add
-     * @return Result of the addition
-     */
-    Matrix operator+(const Matrix &other) const;
+    BasicMatrix &operator=(BasicMatrix &&other) noexcept;
     /**
-     * Overloaded subtraction operator
-     * @param other Matrix to subtract
-     * @return Result of the subtraction
+     * Assignment of a matrix expression (evaluates the expression in one fused pass, reuses the buffer if possible)
+     * @param expr Expression to evaluate
+     * @return This matrix
      */
-    Matrix operator-(const Matrix &other) const;
+    template<matrix_expr_of<T> E>
+    BasicMatrix &operator=(const E &expr) {
+        if (this->rows != expr.get_rows() || this->cols != expr.get_cols()) {
+            /* Evaluated into a new buffer first, the expression may still view the old one */
+            BasicMatrix result(expr.get_rows(), expr.get_cols(), false);
+            result.assign(expr);
+            return *this = std::move(result);
+        }
+        this->assign(expr);
+        return *this;
+    }
     /**
      * Overloaded multiplication operator
      * @param other Matrix to multiply
      * @return Result of the matrix multiplication
      */
-    Matrix operator*(const Matrix &other) const;
+    BasicMatrix operator*(const BasicMatrix &other) const;
     /**
-     * Overloaded multiplication operator
-     * @param scalar Scalar to multiply
-     * @return Result of the scalar multiplication
+     * Overloaded addition assignment operator (in place, no allocation)
+     * @param other Matrix to add
+     * @return This matrix
+     */
+    BasicMatrix &operator+=(const BasicMatrix &other);
+    /**
+     * Overloaded subtraction assignment operator (in place, no allocation)
+     * @param other Matrix to subtract
+     * @return This matrix
      */
-    Matrix operator*(double scalar) const;
+    BasicMatrix &operator-=(const BasicMatrix &other);
     /**
-     * Overloaded left shift operator (for printing)
-     * @param os Output stream
-     * @param matrix Matrix to print (this)
-     * @return Output stream
+     * Overloaded addition assignment operator for matrix expressions (in place, fused, no allocation)
+     * this += alpha * X is mapped onto the axpy kernel
+     * @param expr Expression to add
+     * @return This matrix
      */
-    friend std::ostream &operator<<(std::ostream &os, const Matrix &matrix);
+    template<matrix_expr_of<T> E>
+    BasicMatrix &operator+=(const E &expr) {
+        if (this->rows != expr.get_rows() || this->cols != expr.get_cols())
+            throw std::runtime_error("Matrix elementwise operation error: incompatible dimensions");
+
+        if constexpr (std::is_same_v<E, MatrixScalarExpr<BasicMatrix, matrix_op_mul>>) {
+            axpy(expr.get_scalar(), expr.get_operand(), *this);
+        } else {
+            for (uint32_t i = 0; i < this->rows; i++) {
+                T *row = this->data.data() + static_cast<size_t>(i) * this->stride;
+                for (uint32_t j = 0; j < this->cols; j++)
+                    row[j] += expr.eval(i, j);
+            }
+        }
+        return *this;
+    }
+    /**
+     * Overloaded multiplication assignment operator (in place, no allocation)
+     * @param scalar Scalar to multiply
+     * @return This matrix
+     */
+    BasicMatrix &operator*=(T scalar);
 };
+
+/**
+ * Overloaded left shift operator (for printing)
+ * @param os Output stream
+ * @param matrix Matrix to print
+ * @return Output stream
+ */
+template<typename T>
+std::ostream &operator<<(std::ostream &os, const BasicMatrix<T> &matrix);
+
+/* Instantiated in Matrix.cpp */
+extern template class BasicMatrix<float>;
+extern template class BasicMatrix<double>;
+
+/** Matrix of doubles (default precision used by the network and the visualization) */
+using Matrix = BasicMatrix<double>;
+/** Matrix of floats (half the memory traffic, twice the SIMD lanes) */
+using MatrixF = BasicMatrix<float>;
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+ * Expression templates for the elementwise matrix arithmetic
+ * Operators +, - and * scalar do not compute anything, they return lightweight expression objects describing the
+ * computation, which are evaluated in one fused pass (no temporaries) once assigned to a Matrix
+ * Expressions reference their matrix operands, so they have to be assigned within the same statement
+ * (never store them in an auto variable, the operands could be gone by then)
+ */
+
+template<typename T>
+class BasicMatrix;
+
+/**
+ * Trait marking the matrix types (leaves of the expressions)
+ * @tparam T Type
+ */
+template<typename T>
+struct is_basic_matrix : std::false_type {};
+
+template<typename T>
+struct is_basic_matrix<BasicMatrix<T>> : std::true_type {};
+
+/**
+ * Trait marking the types that can take part in matrix expressions
+ * @tparam T Type
+ */
+template<typename T>
+struct is_matrix_expr : std::false_type {};
+
+/**
+ * Matrix is the leaf of every expression
+ */
+template<typename T>
+struct is_matrix_expr<BasicMatrix<T>> : std::true_type {};
+
+/** Concept of a matrix expression (Matrix or any expression object) */
+template<typename T>
+concept matrix_expr = is_matrix_expr<std::remove_cvref_t<T>>::value;
+
+/** Concept of a matrix expression object (not a plain matrix) evaluating to elements of type T */
+template<typename E, typename T>
+concept matrix_expr_of = matrix_expr<E> && !is_basic_matrix<std::remove_cvref_t<E>>::value &&
+                         std::is_same_v<typename std::remove_cvref_t<E>::value_type, T>;
+
+/** How an operand is held inside an expression (matrices by reference, nested expressions by value) */
+template<typename T>
+using matrix_expr_operand = std::conditional_t<is_basic_matrix<T>::value, const T &, const T>;
+
+/** Elementwise addition */
+struct matrix_op_add {
+    template<typename T>
+    static T apply(T a, T b) { return a + b; }
+};
+
+/** Elementwise subtraction */
+struct matrix_op_sub {
+    template<typename T>
+    static T apply(T a, T b) { return a - b; }
+};
+
+/** Multiplication (used with a scalar) */
+struct matrix_op_mul {
+    template<typename T>
+    static T apply(T a, T b) { return a * b; }
+};
+
+/**
+ * Expression combining two matrix expressions of the same dimensions elementwise
+ * @tparam L Type of the left operand
+ * @tparam R Type of the right operand
+ * @tparam Op Elementwise operation
+ */
+template<typename L, typename R, typename Op>
+class MatrixBinaryExpr {
+public:
+    /** Element type of the expression */
+    using value_type = typename L::value_type;
+    static_assert(std::is_same_v<value_type, typename R::value_type>, "Matrix expressions cannot mix element types");
+
+private:
+    /** Left operand */
+    matrix_expr_operand<L> left;
+    /** Right operand */
+    matrix_expr_operand<R> right;
+
+public:
+    /**
+     * Default constructor
+     * @param left Left operand
+     * @param right Right operand
+     */
+    MatrixBinaryExpr(const L &left, const R &right) : left(left), right(right) {
+        if (left.get_rows() != right.get_rows() || left.get_cols() != right.get_cols())
+            throw std::runtime_error("Matrix elementwise operation error: incompatible dimensions");
+    }
+
+    /**
+     * Get the number of rows of the result
+     * @return Number of rows
+     */
+    [[nodiscard]] uint32_t get_rows() const { return left.get_rows(); }
+    /**
+     * Get the number of columns of the result
+     * @return Number of columns
+     */
+    [[nodiscard]] uint32_t get_cols() const { return left.get_cols(); }
+    /**
+     * Evaluate one element of the result
+     * @param row Row index
+     * @param col Column index
+     * @return Value of the element
+     */
+    [[nodiscard]] value_type eval(uint32_t row, uint32_t col) const { return Op::apply(left.eval(row, col), right.eval(row, col)); }
+    /**
+     * Get the left operand (used to map simple expressions onto the SIMD kernels)
+     * @return Left operand
+     */
+    [[nodiscard]] const L &get_left() const { return left; }
+    /**
+     * Get the right operand (used to map simple expressions onto the SIMD kernels)
+     * @return Right operand
+     */
+    [[nodiscard]] const R &get_right() const { return right; }
+};
+
+template<typename L, typename R, typename Op>
+struct is_matrix_expr<MatrixBinaryExpr<L, R, Op>> : std::true_type {};
+
+/**
+ * Expression combining a matrix expression with a scalar elementwise
+ * @tparam E Type of the matrix operand
+ * @tparam Op Elementwise operation
+ */
+template<typename E, typename Op>
+class MatrixScalarExpr {
+public:
+    /** Element type of the expression */
+    using value_type = typename E::value_type;
+
+private:
+    /** Matrix operand */
+    matrix_expr_operand<E> operand;
+    /** Scalar operand */
+    value_type scalar;
+
+public:
+    /**
+     * Default constructor
+     * @param operand Matrix operand
+     * @param scalar Scalar operand
+     */
+    MatrixScalarExpr(const E &operand, value_type scalar) : operand(operand), scalar(scalar) { /* empty */ }
+
+    /**
+     * Get the number of rows of the result
+     * @return Number of rows
+     */
+    [[nodiscard]] uint32_t get_rows() const { return operand.get_rows(); }
+    /**
+     * Get the number of columns of the result
+     * @return Number of columns
+     */
+    [[nodiscard]] uint32_t get_cols() const { return operand.get_cols(); }
+    /**
+     * Evaluate one element of the result
+     * @param row Row index
+     * @param col Column index
+     * @return Value of the element
+     */
+    [[nodiscard]] value_type eval(uint32_t row, uint32_t col) const { return Op::apply(operand.eval(row, col), scalar); }
+    /**
+     * Get the matrix operand (used to map simple expressions onto the SIMD kernels)
+     * @return Matrix operand
+     */
+    [[nodiscard]] const E &get_operand() const { return operand; }
+    /**
+     * Get the scalar operand
+     * @return Scalar operand
+     */
+    [[nodiscard]] value_type get_scalar() const { return scalar; }
+};
+
+template<typename E, typename Op>
+struct is_matrix_expr<MatrixScalarExpr<E, Op>> : std::true_type {};
+
+/**
+ * Elementwise addition of two matrix expressions (lazy)
+ * @param left Left operand
+ * @param right Right operand
+ * @return Expression object
+ */
+template<matrix_expr L, matrix_expr R>
+MatrixBinaryExpr<L, R, matrix_op_add> operator+(const L &left, const R &right) {
+    return {left, right};
+}
+
+/**
+ * Elementwise subtraction of two matrix expressions (lazy)
+ * @param left Left operand
+ * @param right Right operand
+ * @return Expression object
+ */
+template<matrix_expr L, matrix_expr R>
+MatrixBinaryExpr<L, R, matrix_op_sub> operator-(const L &left, const R &right) {
+    return {left, right};
+}
+
+/**
+ * Multiplication of a matrix expression by a scalar (lazy)
+ * @param operand Matrix operand
+ * @param scalar Scalar
+ * @return Expression object
+ */
+template<matrix_expr E>
+MatrixScalarExpr<E, matrix_op_mul> operator*(const E &operand, std::type_identity_t<typename E::value_type> scalar) {
+    return {operand, scalar};
+}
+
+/**
+ * Multiplication of a matrix expression by a scalar (lazy)
+ * @param scalar Scalar
+ * @param operand Matrix operand
+ * @return Expression object
+ */
+template<matrix_expr E>
+MatrixScalarExpr<E, matrix_op_mul> operator*(std::type_identity_t<typename E::value_type> scalar, const E &operand) {
+    return {operand, scalar};
+}
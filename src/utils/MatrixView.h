@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include "MatrixExpr.h"
+
+/**
+ * Read-only, non-owning view of a sub-block of a matrix (rows, columns, slices and their transpositions)
+ * A view is just a pointer and the layout (dimensions and strides), so creating and passing it around copies nothing
+ * Views are matrix expressions too, so they can be used in the elementwise arithmetic and assigned to a matrix
+ * The viewed matrix has to outlive the view and must not be resized while the view is in use
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+class BasicMatrixView {
+public:
+    /** Element type */
+    using value_type = T;
+
+private:
+    /** First element of the view */
+    const T *data;
+    /** Number of rows */
+    uint32_t rows;
+    /** Number of columns */
+    uint32_t cols;
+    /** Distance (in elements) between two consecutive rows */
+    size_t row_stride;
+    /** Distance (in elements) between two consecutive columns (1 unless the view is transposed) */
+    size_t col_stride;
+
+public:
+    /**
+     * Default constructor
+     * @param data First element of the view
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param row_stride Distance (in elements) between two consecutive rows
+     * @param col_stride Distance (in elements) between two consecutive columns
+     */
+    BasicMatrixView(const T *data, uint32_t rows, uint32_t cols, size_t row_stride, size_t col_stride = 1)
+        : data(data), rows(rows), cols(cols), row_stride(row_stride), col_stride(col_stride) { /* empty */ }
+
+    /**
+     * Get the number of rows of the view
+     * @return Number of rows
+     */
+    [[nodiscard]] uint32_t get_rows() const { return this->rows; }
+    /**
+     * Get the number of columns of the view
+     * @return Number of columns
+     */
+    [[nodiscard]] uint32_t get_cols() const { return this->cols; }
+    /**
+     * Get the distance (in elements) between two consecutive rows
+     * @return Row stride
+     */
+    [[nodiscard]] size_t get_row_stride() const { return this->row_stride; }
+    /**
+     * Get the distance (in elements) between two consecutive columns
+     * @return Column stride
+     */
+    [[nodiscard]] size_t get_col_stride() const { return this->col_stride; }
+    /**
+     * Get the pointer to the first element of the view
+     * @return Pointer to the first element
+     */
+    [[nodiscard]] const T *get_data() const { return this->data; }
+    /**
+     * Get the value at the given position
+     * @param row Row index
+     * @param col Column index
+     * @return Value at the given position
+     */
+    [[nodiscard]] T get_value(uint32_t row, uint32_t col) const { return this->data[row * this->row_stride + col * this->col_stride]; }
+    /**
+     * Get the value at the given position (used by the expression templates)
+     * @param row Row index
+     * @param col Column index
+     * @return Value at the given position
+     */
+    [[nodiscard]] T eval(uint32_t row, uint32_t col) const { return this->get_value(row, col); }
+
+    /**
+     * Get the view of one row of this view
+     * @param row Row index
+     * @return View of the row (1 x cols)
+     */
+    [[nodiscard]] BasicMatrixView get_row_view(uint32_t row) const {
+        return {this->data + row * this->row_stride, 1, this->cols, this->row_stride, this->col_stride};
+    }
+    /**
+     * Get the view of one column of this view
+     * @param col Column index
+     * @return View of the column (rows x 1)
+     */
+    [[nodiscard]] BasicMatrixView get_col_view(uint32_t col) const {
+        return {this->data + col * this->col_stride, this->rows, 1, this->row_stride, this->col_stride};
+    }
+    /**
+     * Get the view of a rectangular block of this view
+     * @param row First row of the block
+     * @param col First column of the block
+     * @param block_rows Number of rows of the block
+     * @param block_cols Number of columns of the block
+     * @return View of the block
+     */
+    [[nodiscard]] BasicMatrixView get_block_view(uint32_t row, uint32_t col, uint32_t block_rows, uint32_t block_cols) const {
+        if (row + block_rows > this->rows || col + block_cols > this->cols)
+            throw std::runtime_error("Matrix view error: block out of range");
+        return {this->data + row * this->row_stride + col * this->col_stride, block_rows, block_cols, this->row_stride, this->col_stride};
+    }
+    /**
+     * Get the transposed view (no data are moved, only the strides are swapped)
+     * @return Transposed view
+     */
+    [[nodiscard]] BasicMatrixView transpose() const {
+        return {this->data, this->cols, this->rows, this->col_stride, this->row_stride};
+    }
+    /**
+     * Get the index of the maximum value in the view (row-major index)
+     * @return Index of the maximum value in the view
+     */
+    [[nodiscard]] uint32_t argmax() const {
+        T max = this->get_value(0, 0);
+        uint32_t max_idx = 0;
+
+        for (uint32_t i = 0; i < this->rows; i++)
+            for (uint32_t j = 0; j < this->cols; j++)
+                if (this->get_value(i, j) > max) {
+                    max = this->get_value(i, j);
+                    max_idx = i * this->cols + j;
+                }
+
+        return max_idx;
+    }
+};
+
+template<typename T>
+struct is_matrix_expr<BasicMatrixView<T>> : std::true_type {};
+
+/** View of a matrix of doubles */
+using MatrixView = BasicMatrixView<double>;
+/** View of a matrix of floats */
+using MatrixViewF = BasicMatrixView<float>;
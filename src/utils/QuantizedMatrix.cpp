@@ -0,0 +1,55 @@
+#include "QuantizedMatrix.h"
+
+QuantizedMatrix::QuantizedMatrix() : rows(0), cols(0), stride(0) {
+    /* empty */
+}
+
+template<typename T>
+QuantizedMatrix::QuantizedMatrix(BasicMatrixView<T> matrix) : rows(matrix.get_rows()), cols(matrix.get_cols()) {
+    this->stride = this->cols; /* Dense rows, padding to a cache line would double the size of the small layers */
+    this->data.assign(static_cast<size_t>(this->rows) * this->stride, 0);
+    this->scales.resize(this->rows);
+
+    std::vector<T> row(this->cols);
+    for (uint32_t i = 0; i < this->rows; i++) {
+        T max_abs = 0;
+        for (uint32_t j = 0; j < this->cols; j++) {
+            row[j] = matrix.get_value(i, j);
+            max_abs = std::max(max_abs, std::abs(row[j]));
+        }
+
+        /* Row of zeros gets scale 1, so nothing is divided by zero */
+        const T scale = max_abs > 0 ? max_abs / MAX_QUANTIZED : T(1);
+        this->scales[i] = static_cast<float>(scale);
+        quantize(row.data(), this->cols, scale, this->data.data() + static_cast<size_t>(i) * this->stride);
+    }
+}
+
+void QuantizedMatrix::multiply_vector(const int8_t *x, int32_t *y) const {
+    const auto dot = Simd::kernel_set().dot_i8;
+    for (uint32_t i = 0; i < this->rows; i++)
+        y[i] = dot(this->data.data() + static_cast<size_t>(i) * this->stride, x, this->cols);
+}
+
+uint32_t QuantizedMatrix::get_rows() const {
+    return this->rows;
+}
+
+uint32_t QuantizedMatrix::get_cols() const {
+    return this->cols;
+}
+
+int8_t QuantizedMatrix::get_value(uint32_t row, uint32_t col) const {
+    return this->data[static_cast<size_t>(row) * this->stride + col];
+}
+
+float QuantizedMatrix::get_scale(uint32_t row) const {
+    return this->scales[row];
+}
+
+size_t QuantizedMatrix::get_bytes() const {
+    return this->data.size() * sizeof(int8_t) + this->scales.size() * sizeof(float);
+}
+
+template QuantizedMatrix::QuantizedMatrix(BasicMatrixView<float> matrix);
+template QuantizedMatrix::QuantizedMatrix(BasicMatrixView<double> matrix);
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "AlignedAllocator.h"
+#include "MatrixView.h"
+#include "Simd.h"
+
+/**
+ * Class representing a matrix quantized to int8 with one scale per row (symmetric quantization)
+ * Value (i, j) is approximately get_scale(i) * get_value(i, j), every row uses the whole int8 range [-127, 127] of its
+ * largest magnitude, so a row of small weights does not lose its precision because of a row of big ones
+ * Rows are stored densely (the kernels use unaligned loads), the matrix-vector product uses the int8 SIMD dot product
+ * with int32 accumulators
+ */
+class QuantizedMatrix {
+public:
+    /** Largest magnitude of a quantized value (-128 is not used, so the range is symmetric) */
+    static constexpr int32_t MAX_QUANTIZED = 127;
+
+private:
+    /** Number of rows */
+    uint32_t rows;
+    /** Number of columns */
+    uint32_t cols;
+    /** Distance (in elements) between two consecutive rows */
+    uint32_t stride;
+    /** Quantized values (row-major) */
+    std::vector<int8_t, AlignedAllocator<int8_t>> data;
+    /** Scale of each row */
+    std::vector<float> scales;
+
+public:
+    /**
+     * Default constructor (empty matrix)
+     */
+    QuantizedMatrix();
+    /**
+     * Constructor quantizing a matrix or a view (scale of a row is its largest magnitude / MAX_QUANTIZED)
+     * @tparam T Element type (float / double)
+     * @param matrix Matrix or view to quantize
+     */
+    template<typename T>
+    explicit QuantizedMatrix(BasicMatrixView<T> matrix);
+
+    /**
+     * Compute y = A * x in integers (int8 products summed in int32), the row scales are not applied
+     * @param x Quantized vector (cols elements)
+     * @param y Result (rows elements)
+     */
+    void multiply_vector(const int8_t *x, int32_t *y) const;
+
+    /**
+     * Quantize a vector with the given scale (rounded to nearest, clamped to [-MAX_QUANTIZED, MAX_QUANTIZED])
+     * @tparam T Element type (float / double)
+     * @param x Vector
+     * @param n Number of elements
+     * @param scale Scale (x is approximately scale * result)
+     * @param result Quantized vector
+     */
+    template<typename T>
+    static void quantize(const T *x, size_t n, T scale, int8_t *result) {
+        const T inverse = 1 / scale;
+        for (size_t i = 0; i < n; i++) {
+            const long value = std::lround(x[i] * inverse);
+            result[i] = static_cast<int8_t>(std::clamp<long>(value, -MAX_QUANTIZED, MAX_QUANTIZED));
+        }
+    }
+
+    /**
+     * Get the number of rows of the matrix
+     * @return Number of rows
+     */
+    [[nodiscard]] uint32_t get_rows() const;
+    /**
+     * Get the number of columns of the matrix
+     * @return Number of columns
+     */
+    [[nodiscard]] uint32_t get_cols() const;
+    /**
+     * Get the quantized value at the given position
+     * @param row Row index
+     * @param col Column index
+     * @return Quantized value
+     */
+    [[nodiscard]] int8_t get_value(uint32_t row, uint32_t col) const;
+    /**
+     * Get the scale of the given row
+     * @param row Row index
+     * @return Scale of the row
+     */
+    [[nodiscard]] float get_scale(uint32_t row) const;
+    /**
+     * Get the number of bytes of the quantized values and the scales
+     * @return Number of bytes
+     */
+    [[nodiscard]] size_t get_bytes() const;
+};
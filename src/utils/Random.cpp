@@ -0,0 +1,150 @@
+#include "Random.h"
+
+#include <mutex>
+#include <utility>
+
+namespace {
+    /** Philox multipliers */
+    constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+    constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+    /** Philox key increments (golden ratio, sqrt(3) - 1) */
+    constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+    constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+    /** Number of Philox rounds */
+    constexpr uint32_t PHILOX_ROUNDS = 10;
+
+    /** Guards the startup seed */
+    std::once_flag seed_once;
+
+    /**
+     * Convert a random word to a uniform float from [0, 1) (24 bits of mantissa)
+     * @param word Random word
+     * @return Uniform float
+     */
+    inline float to_unit(uint32_t word) {
+        return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /**
+     * Convert two random words to a uniform double from [0, 1) (53 bits of mantissa)
+     * @param high First random word
+     * @param low Second random word
+     * @return Uniform double
+     */
+    inline double to_unit(uint32_t high, uint32_t low) {
+        const uint64_t bits = ((static_cast<uint64_t>(high) << 32) | low) >> 11;
+        return static_cast<double>(bits) * (1.0 / 9007199254740992.0);
+    }
+}
+
+PhiloxGenerator::PhiloxGenerator(uint64_t seed, uint32_t sequence, random_stream stream)
+                                 : key({static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}),
+                                   sequence(sequence), stream(static_cast<uint32_t>(stream)), next_block(0),
+                                   block(), used_words(4) {
+    /* empty */
+}
+
+philox_block PhiloxGenerator::philox(philox_block counter, std::array<uint32_t, 2> key) {
+    for (uint32_t round = 0; round < PHILOX_ROUNDS; round++) {
+        const uint64_t product0 = static_cast<uint64_t>(PHILOX_M0) * counter[0];
+        const uint64_t product1 = static_cast<uint64_t>(PHILOX_M1) * counter[2];
+        counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product1),
+                   static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product0)};
+        key[0] += PHILOX_W0;
+        key[1] += PHILOX_W1;
+    }
+    return counter;
+}
+
+philox_block PhiloxGenerator::get_block(uint64_t index) const {
+    return philox({static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), this->sequence, this->stream}, this->key);
+}
+
+template<typename T>
+void PhiloxGenerator::fill_uniform(T *result, size_t n, uint64_t offset, T low, T high) const {
+    /* Values per block, element e of the sequence is value e % per_block of block e / per_block */
+    constexpr uint64_t per_block = sizeof(T) == sizeof(double) ? 2 : 4;
+    const T range = high - low;
+
+    size_t i = 0;
+    while (i < n) {
+        const uint64_t element = offset + i;
+        const philox_block words = this->get_block(element / per_block);
+        for (uint64_t k = element % per_block; k < per_block && i < n; k++, i++) {
+            if constexpr (per_block == 2)
+                result[i] = low + range * static_cast<T>(to_unit(words[2 * k], words[2 * k + 1]));
+            else
+                result[i] = low + range * static_cast<T>(to_unit(words[k]));
+        }
+    }
+}
+
+PhiloxGenerator::result_type PhiloxGenerator::operator()() {
+    if (this->used_words == 4) {
+        this->block = this->get_block(this->next_block++);
+        this->used_words = 0;
+    }
+    return this->block[this->used_words++];
+}
+
+uint32_t PhiloxGenerator::next_below(uint32_t bound) {
+    /* Lemire's multiply-shift with rejection, unbiased */
+    uint64_t product = static_cast<uint64_t>((*this)()) * bound;
+    auto low = static_cast<uint32_t>(product);
+    if (low < bound) {
+        const uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            product = static_cast<uint64_t>((*this)()) * bound;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+template void PhiloxGenerator::fill_uniform(float *result, size_t n, uint64_t offset, float low, float high) const;
+template void PhiloxGenerator::fill_uniform(double *result, size_t n, uint64_t offset, double low, double high) const;
+
+std::atomic<uint64_t> Random::seed = 0;
+std::array<std::atomic<uint32_t>, static_cast<size_t>(random_stream::number_of_streams)> Random::sequences = {};
+std::atomic<bool> Random::initialized = false;
+
+void Random::init() {
+    std::call_once(seed_once, [] {
+        uint64_t value = (static_cast<uint64_t>(std::random_device()()) << 32) | std::random_device()();
+        if (const char *env = std::getenv("NSES_SEED")) {
+            /* Invalid values are ignored (same as NSES_NUM_THREADS) */
+            char *end = nullptr;
+            unsigned long long parsed = std::strtoull(env, &end, 10);
+            if (end != env && *end == '\0')
+                value = parsed;
+        }
+        seed.store(value, std::memory_order_relaxed);
+        initialized.store(true, std::memory_order_release);
+    });
+}
+
+uint64_t Random::get_seed() {
+    if (!initialized.load(std::memory_order_acquire))
+        init();
+    return seed.load(std::memory_order_relaxed);
+}
+
+void Random::set_seed(uint64_t value) {
+    if (!initialized.load(std::memory_order_acquire))
+        init(); /* Startup seed must not overwrite this one later */
+    seed.store(value, std::memory_order_relaxed);
+    for (auto &sequence : sequences)
+        sequence.store(0, std::memory_order_relaxed);
+}
+
+PhiloxGenerator Random::get_generator(random_stream stream) {
+    const uint64_t value = get_seed();
+    const uint32_t sequence = sequences[static_cast<size_t>(stream)].fetch_add(1, std::memory_order_relaxed);
+    return {value, sequence, stream};
+}
+
+void Random::shuffle(std::vector<uint32_t> &indices, random_stream stream) {
+    auto generator = get_generator(stream);
+    for (size_t i = indices.size(); i > 1; i--)
+        std::swap(indices[i - 1], indices[generator.next_below(static_cast<uint32_t>(i))]);
+}
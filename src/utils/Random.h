@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <random>
+
+/** Independent random streams (each consumer gets its own, so e.g. shuffling does not shift the weight init) */
+enum class random_stream {
+    weights,
+    shuffle,
+    split,
+    number_of_streams
+};
+
+/** Block of four 32-bit random words (output of one Philox evaluation) */
+using philox_block = std::array<uint32_t, 4>;
+
+/**
+ * Philox4x32-10 counter-based random number generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+ * The n-th block of random words is a pure function of (key, counter), so any element of a sequence can be computed
+ * independently of the others: the weight init fills rows in parallel and gets the same values for any number of
+ * threads, a sequence can also be consumed serially (operator(), e.g. for shuffling)
+ * Counter layout: words 0 - 1 are the index of the block within the sequence, word 2 is the sequence number, word 3
+ * the stream, the key is the global seed
+ */
+class PhiloxGenerator {
+public:
+    /** Type of the generated words (UniformRandomBitGenerator) */
+    using result_type = uint32_t;
+
+private:
+    /** Key (global seed) */
+    std::array<uint32_t, 2> key;
+    /** Sequence number within the stream */
+    uint32_t sequence;
+    /** Stream */
+    uint32_t stream;
+    /** Index of the next block of the serial interface */
+    uint64_t next_block;
+    /** Current block of the serial interface */
+    philox_block block;
+    /** Number of words of the current block already used (4 means a new block is needed) */
+    uint32_t used_words;
+
+public:
+    /**
+     * Constructor
+     * @param seed Seed (key)
+     * @param sequence Sequence number within the stream
+     * @param stream Stream
+     */
+    PhiloxGenerator(uint64_t seed, uint32_t sequence, random_stream stream);
+
+    /**
+     * Compute the block of random words with the given index (random access, thread safe)
+     * @param index Index of the block within the sequence
+     * @return Four random words
+     */
+    [[nodiscard]] philox_block get_block(uint64_t index) const;
+    /**
+     * Fill the array with uniform random values from [low, high), value i of the array is element offset + i of the
+     * sequence, so a big array can be filled in independent parts (double takes two words, float one)
+     * @tparam T Element type (float / double)
+     * @param result Array
+     * @param n Number of elements
+     * @param offset Index of the first element within the sequence
+     * @param low Lower bound
+     * @param high Upper bound
+     */
+    template<typename T>
+    void fill_uniform(T *result, size_t n, uint64_t offset, T low, T high) const;
+
+    /**
+     * Get the next random word of the serial interface
+     * @return Random word
+     */
+    result_type operator()();
+    /**
+     * Get a uniform random integer from [0, bound) (serial interface, same result on every platform unlike
+     * std::uniform_int_distribution)
+     * @param bound Upper bound (exclusive, not 0)
+     * @return Random integer
+     */
+    uint32_t next_below(uint32_t bound);
+
+    /**
+     * Smallest generated word (UniformRandomBitGenerator)
+     * @return 0
+     */
+    static constexpr result_type min() { return 0; }
+    /**
+     * Largest generated word (UniformRandomBitGenerator)
+     * @return 2^32 - 1
+     */
+    static constexpr result_type max() { return UINT32_MAX; }
+    /**
+     * Evaluate the Philox4x32-10 function
+     * @param counter Counter
+     * @param key Key
+     * @return Four random words
+     */
+    static philox_block philox(philox_block counter, std::array<uint32_t, 2> key);
+};
+
+/**
+ * Class holding the global seed and handing out the random sequences
+ * Every call of get_generator() returns a new sequence of the stream (sequence numbers count up from 0), so a run
+ * with a fixed seed and the same calls in the same order is reproduced exactly (bit-identical for any number of
+ * threads), set_seed() restarts all the streams
+ * Seed defaults to a random one (every run differs, as before), environment variable NSES_SEED fixes it at startup
+ */
+class Random {
+private:
+    /** Global seed */
+    static std::atomic<uint64_t> seed;
+    /** Number of sequences handed out per stream */
+    static std::array<std::atomic<uint32_t>, static_cast<size_t>(random_stream::number_of_streams)> sequences;
+    /** Flag if the seed was picked already */
+    static std::atomic<bool> initialized;
+
+    /**
+     * Pick the startup seed (NSES_SEED or a random one)
+     */
+    static void init();
+
+public:
+    /**
+     * Get the global seed
+     * @return Seed
+     */
+    static uint64_t get_seed();
+    /**
+     * Set the global seed and restart all the streams
+     * @param value Seed
+     */
+    static void set_seed(uint64_t value);
+    /**
+     * Get the next sequence of the given stream
+     * @param stream Stream
+     * @return Generator of the sequence
+     */
+    static PhiloxGenerator get_generator(random_stream stream);
+    /**
+     * Shuffle the indices (Fisher-Yates) with the next sequence of the given stream
+     * @param indices Indices
+     * @param stream Stream
+     */
+    static void shuffle(std::vector<uint32_t> &indices, random_stream stream);
+};
@@ -0,0 +1,293 @@
+#include "SimdImpl.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef NSES_SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+    /**
+     * Scalar "registers" of one element, lets the scalar table reuse the generic fast math and optimizer kernels of
+     * SimdImpl.h, so the scalar fast kernels compute exactly the same approximations as the SIMD ones
+     * @tparam T Element type (float / double)
+     * @tparam B Unsigned integer type of the same size
+     * @tparam MANTISSA_BITS Number of mantissa bits
+     * @tparam BIAS Exponent bias
+     */
+    template<typename T, typename B, uint32_t MANTISSA_BITS, B BIAS>
+    struct scalar_traits {
+        using value_type = T;
+        using reg = T;
+        static constexpr size_t width = 1;
+        static constexpr bool masked_tail = false;
+        static reg load(const T *p) { return *p; }
+        static void store(T *p, reg v) { *p = v; }
+        static reg set1(T v) { return v; }
+        static reg add(reg a, reg b) { return a + b; }
+        static reg sub(reg a, reg b) { return a - b; }
+        static reg mul(reg a, reg b) { return a * b; }
+        static reg div(reg a, reg b) { return a / b; }
+        static reg sqrt(reg a) { return std::sqrt(a); }
+        static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+        static reg min(reg a, reg b) { return a < b ? a : b; }
+        static reg max(reg a, reg b) { return a > b ? a : b; }
+        static reg select_gt(reg a, reg b, reg x, reg y) { return a > b ? x : y; }
+        static B to_bits(reg v) { B bits; std::memcpy(&bits, &v, sizeof(bits)); return bits; }
+        static reg from_bits(B bits) { T v; std::memcpy(&v, &bits, sizeof(v)); return v; }
+        static reg pow2_of_rounded(reg t) { return from_bits(static_cast<B>((to_bits(t) + BIAS) << MANTISSA_BITS)); }
+        static reg exponent(reg x) { return static_cast<T>(static_cast<int64_t>(to_bits(x) >> MANTISSA_BITS) - static_cast<int64_t>(BIAS)); }
+        static reg mantissa(reg x) { return from_bits((to_bits(x) & ((B(1) << MANTISSA_BITS) - 1)) | (BIAS << MANTISSA_BITS)); }
+    };
+
+    /** Scalar double */
+    using scalar_f64 = scalar_traits<double, uint64_t, 52, 1023>;
+    /** Scalar float */
+    using scalar_f32 = scalar_traits<float, uint32_t, 23, 127>;
+
+    template<typename T>
+    void add_scalar(const T *a, const T *b, T *c, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            c[i] = a[i] + b[i];
+    }
+
+    template<typename T>
+    void sub_scalar(const T *a, const T *b, T *c, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            c[i] = a[i] - b[i];
+    }
+
+    template<typename T>
+    void mul_scalar(const T *a, const T *b, T *c, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            c[i] = a[i] * b[i];
+    }
+
+    template<typename T>
+    void scale_scalar(const T *a, T alpha, T *c, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            c[i] = alpha * a[i];
+    }
+
+    template<typename T>
+    void axpy_scalar(T alpha, const T *x, T *y, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            y[i] += alpha * x[i];
+    }
+
+    int32_t dot_i8_scalar(const int8_t *a, const int8_t *b, size_t n) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += static_cast<int32_t>(a[i]) * b[i];
+        return sum;
+    }
+
+#ifdef NSES_SIMD_X86
+    /**
+     * Execute the CPUID instruction
+     * @param leaf Leaf (eax)
+     * @param subleaf Subleaf (ecx)
+     * @param regs Output registers (eax, ebx, ecx, edx)
+     */
+    void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+        int out[4];
+        __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; i++)
+            regs[i] = static_cast<uint32_t>(out[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    /**
+     * Read the XCR0 register (which register states the operating system saves on context switch)
+     * @return Value of XCR0
+     */
+    uint64_t xgetbv0() {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+#endif
+}
+
+/* Exact kernels, there are no exp / log / tanh instructions, so every lane goes through the standard library */
+
+template<typename T>
+void simd_exact_exp(const T *a, T *c, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        c[i] = std::exp(a[i]);
+}
+
+template<typename T>
+void simd_exact_log(const T *a, T *c, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        c[i] = std::log(a[i]);
+}
+
+template<typename T>
+void simd_exact_tanh(const T *a, T *c, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        c[i] = std::tanh(a[i]);
+}
+
+template<typename T>
+void simd_exact_sigmoid(const T *a, T *c, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        c[i] = 1 / (1 + std::exp(-a[i]));
+}
+
+template void simd_exact_exp<float>(const float *, float *, size_t);
+template void simd_exact_exp<double>(const double *, double *, size_t);
+template void simd_exact_log<float>(const float *, float *, size_t);
+template void simd_exact_log<double>(const double *, double *, size_t);
+template void simd_exact_tanh<float>(const float *, float *, size_t);
+template void simd_exact_tanh<double>(const double *, double *, size_t);
+template void simd_exact_sigmoid<float>(const float *, float *, size_t);
+template void simd_exact_sigmoid<double>(const double *, double *, size_t);
+
+const simd_kernel_set simd_kernels_scalar = {
+        {add_scalar<double>, sub_scalar<double>, mul_scalar<double>, scale_scalar<double>, axpy_scalar<double>,
+         simd_make_exact_math_kernels<double>(), simd_make_fast_math_kernels<scalar_f64>(), simd_make_optimizer_kernels<scalar_f64>()},
+        {add_scalar<float>, sub_scalar<float>, mul_scalar<float>, scale_scalar<float>, axpy_scalar<float>,
+         simd_make_exact_math_kernels<float>(), simd_make_fast_math_kernels<scalar_f32>(), simd_make_optimizer_kernels<scalar_f32>()},
+        dot_i8_scalar,
+};
+
+std::atomic<const simd_kernel_set *> Simd::active = nullptr;
+std::atomic<simd_level> Simd::active_level = simd_level::scalar;
+std::atomic<math_mode> Simd::active_math_mode = math_mode::number_of_math_modes;
+
+const simd_kernel_set *Simd::init() {
+    auto level = detect_level();
+
+    /* Environment variable can only lower the level (forcing an unsupported level would crash) */
+    if (const char *env = std::getenv("NSES_SIMD")) {
+        for (int i = 0; i < static_cast<int>(simd_level::number_of_simd_levels); i++)
+            if (get_level_name(static_cast<simd_level>(i)) == env && i < static_cast<int>(level))
+                level = static_cast<simd_level>(i);
+    }
+
+    set_level(level);
+    return active.load(std::memory_order_acquire);
+}
+
+math_mode Simd::init_math_mode() {
+    auto mode = math_mode::exact;
+    if (const char *env = std::getenv("NSES_MATH")) {
+        for (int i = 0; i < static_cast<int>(math_mode::number_of_math_modes); i++)
+            if (get_math_mode_name(static_cast<math_mode>(i)) == env)
+                mode = static_cast<math_mode>(i);
+    }
+
+    /* Mode set by set_math_mode() in the meantime wins */
+    auto expected = math_mode::number_of_math_modes;
+    active_math_mode.compare_exchange_strong(expected, mode, std::memory_order_relaxed);
+    return active_math_mode.load(std::memory_order_relaxed);
+}
+
+void Simd::set_math_mode(math_mode mode) {
+    if (mode != math_mode::exact && mode != math_mode::fast)
+        mode = math_mode::exact;
+    active_math_mode.store(mode, std::memory_order_relaxed);
+}
+
+std::string Simd::get_math_mode_name(math_mode mode) {
+    switch (mode) {
+        case math_mode::exact:
+            return "exact";
+        case math_mode::fast:
+            return "fast";
+        default:
+            return "unknown";
+    }
+}
+
+simd_level Simd::detect_level() {
+#ifdef NSES_SIMD_X86
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    const bool sse2 = regs[3] & (1u << 26);
+    const bool osxsave = regs[2] & (1u << 27);
+    const bool fma = regs[2] & (1u << 12);
+    if (!sse2)
+        return simd_level::scalar;
+    if (!osxsave || max_leaf < 7)
+        return simd_level::sse2;
+
+    /* The CPU flags are not enough, the OS also has to save the YMM / ZMM registers */
+    const uint64_t xcr0 = xgetbv0();
+    const bool os_ymm = (xcr0 & 0x6) == 0x6;
+    const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid(7, 0, regs);
+    const bool avx2 = regs[1] & (1u << 5);
+    const bool avx512f = regs[1] & (1u << 16);
+
+    if (avx512f && os_zmm)
+        return simd_level::avx512;
+    if (avx2 && fma && os_ymm)
+        return simd_level::avx2;
+    return simd_level::sse2;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+simd_level Simd::get_level() {
+    kernels<double>(); /* Make sure the startup level is picked */
+    return active_level.load(std::memory_order_acquire);
+}
+
+simd_level Simd::set_level(simd_level level) {
+    if (static_cast<int>(level) > static_cast<int>(detect_level()))
+        level = detect_level();
+
+    active_level.store(level, std::memory_order_release);
+    active.store(&get_kernels(level), std::memory_order_release);
+    return level;
+}
+
+std::string Simd::get_level_name(simd_level level) {
+    switch (level) {
+        case simd_level::scalar:
+            return "scalar";
+        case simd_level::sse2:
+            return "sse2";
+        case simd_level::avx2:
+            return "avx2";
+        case simd_level::avx512:
+            return "avx512";
+        default:
+            return "unknown";
+    }
+}
+
+const simd_kernel_set &Simd::get_kernels(simd_level level) {
+#ifdef NSES_SIMD_X86
+    switch (level) {
+        case simd_level::sse2:
+            return simd_kernels_sse2;
+        case simd_level::avx2:
+            return simd_kernels_avx2;
+        case simd_level::avx512:
+            return simd_kernels_avx512;
+        default:
+            break;
+    }
+#endif
+    return simd_kernels_scalar;
+}
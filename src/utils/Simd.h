@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <atomic>
+#include <type_traits>
+
+/** Instruction set level of the elementwise kernels */
+enum class simd_level {
+    scalar = 0,
+    sse2,
+    avx2,
+    avx512,
+    number_of_simd_levels /* Enum trick to get the number of simd levels */
+};
+
+/** Math mode of the transcendental kernels (activations, softmax and loss) */
+enum class math_mode {
+    exact = 0,
+    fast,
+    number_of_math_modes /* Enum trick to get the number of math modes */
+};
+
+/**
+ * Table of transcendental kernels for one element type
+ * Exact kernels call the standard library lane by lane, fast kernels are polynomial approximations evaluated in SIMD
+ * registers (exp: Cody-Waite reduction to |r| <= ln(2) / 2 + Taylor polynomial, log: exponent / mantissa split +
+ * atanh series, tanh and sigmoid built from the fast exp)
+ * Maximum error of the fast kernels (measured against long double std:: functions, "bench math" mode):
+ *   double: exp 1.8e-16, log 3.7e-16, sigmoid 2.4e-16 (relative), tanh 1.7e-16 (absolute)
+ *   float: exp 9.9e-8, log 2.0e-7, sigmoid 1.5e-7 (relative), tanh 1.3e-7 (absolute)
+ * Limits of the fast kernels: exp clamps its input to [-708, 709] (double) / [-87, 88] (float), so it neither
+ * overflows nor underflows to 0, log expects positive normal numbers, NaN is not propagated
+ * All kernels work on n contiguous elements and allow the output to alias the input
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+struct simd_math_kernels {
+    /** c = exp(a) */
+    void (*exp)(const T *a, T *c, size_t n);
+    /** c = log(a) */
+    void (*log)(const T *a, T *c, size_t n);
+    /** c = tanh(a) */
+    void (*tanh)(const T *a, T *c, size_t n);
+    /** c = 1 / (1 + exp(-a)) */
+    void (*sigmoid)(const T *a, T *c, size_t n);
+};
+
+/**
+ * Exact exp kernel (std::exp lane by lane), shared by the tables of all levels
+ * Exact kernels are defined (and instantiated for float and double) only in Simd.cpp, which is compiled without the
+ * instruction set flags of the Simd_<isa>.cpp files
+ * @tparam T Element type (float / double)
+ * @param a Operand
+ * @param c Result
+ * @param n Number of elements
+ */
+template<typename T>
+void simd_exact_exp(const T *a, T *c, size_t n);
+/**
+ * Exact log kernel (std::log lane by lane), shared by the tables of all levels
+ * @tparam T Element type (float / double)
+ * @param a Operand
+ * @param c Result
+ * @param n Number of elements
+ */
+template<typename T>
+void simd_exact_log(const T *a, T *c, size_t n);
+/**
+ * Exact tanh kernel (std::tanh lane by lane), shared by the tables of all levels
+ * @tparam T Element type (float / double)
+ * @param a Operand
+ * @param c Result
+ * @param n Number of elements
+ */
+template<typename T>
+void simd_exact_tanh(const T *a, T *c, size_t n);
+/**
+ * Exact sigmoid kernel (1 / (1 + std::exp(-a)) lane by lane), shared by the tables of all levels
+ * @tparam T Element type (float / double)
+ * @param a Operand
+ * @param c Result
+ * @param n Number of elements
+ */
+template<typename T>
+void simd_exact_sigmoid(const T *a, T *c, size_t n);
+
+/**
+ * Table of fused optimizer kernels for one element type
+ * Each kernel reads the gradient and updates the optimizer state and the parameters in one pass over the arrays
+ * The gradient is an ascent direction of the (negative) loss as accumulated by the back propagation, scale turns the
+ * sum over the samples into the mean, every step adds to the parameters
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+struct simd_optimizer_kernels {
+    /** v = beta * v + scale * g, w = w + rate * v (momentum) */
+    void (*momentum)(T rate, T beta, T scale, const T *g, T *v, T *w, size_t n);
+    /** v = beta * v + scale * g, w = w + rate * (scale * g + beta * v) (Nesterov momentum) */
+    void (*nesterov)(T rate, T beta, T scale, const T *g, T *v, T *w, size_t n);
+    /** s = rho * s + (1 - rho) * (scale * g)^2, w = w + rate * scale * g / (sqrt(s) + epsilon) (RMSProp) */
+    void (*rmsprop)(T rate, T rho, T epsilon, T scale, const T *g, T *s, T *w, size_t n);
+    /** m = beta1 * m + (1 - beta1) * scale * g, v = beta2 * v + (1 - beta2) * (scale * g)^2,
+     * w = w + rate * m / (sqrt(v) + epsilon) (Adam, the caller folds the bias correction into rate and epsilon) */
+    void (*adam)(T rate, T beta1, T beta2, T epsilon, T scale, const T *g, T *m, T *v, T *w, size_t n);
+};
+
+/**
+ * Table of elementwise kernels for one instruction set level and one element type
+ * All kernels work on n contiguous elements and allow the output to alias any of the inputs
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+struct simd_kernels {
+    /** c = a + b */
+    void (*add)(const T *a, const T *b, T *c, size_t n);
+    /** c = a - b */
+    void (*sub)(const T *a, const T *b, T *c, size_t n);
+    /** c = a * b (elementwise) */
+    void (*mul)(const T *a, const T *b, T *c, size_t n);
+    /** c = alpha * a */
+    void (*scale)(const T *a, T alpha, T *c, size_t n);
+    /** y = alpha * x + y */
+    void (*axpy)(T alpha, const T *x, T *y, size_t n);
+    /** Exact transcendental kernels */
+    simd_math_kernels<T> exact_math;
+    /** Fast transcendental kernels */
+    simd_math_kernels<T> fast_math;
+    /** Fused optimizer kernels */
+    simd_optimizer_kernels<T> optimizer;
+};
+
+/**
+ * Kernels of one instruction set level for all supported element types
+ */
+struct simd_kernel_set {
+    /** Kernels for doubles */
+    simd_kernels<double> f64;
+    /** Kernels for floats */
+    simd_kernels<float> f32;
+    /** Dot product of two int8 vectors accumulated in int32 (products are widened before they are summed) */
+    int32_t (*dot_i8)(const int8_t *a, const int8_t *b, size_t n);
+};
+
+/** Scalar kernels (always available, serve as the reference) */
+extern const simd_kernel_set simd_kernels_scalar;
+#ifdef NSES_SIMD_X86
+/** SSE2 kernels */
+extern const simd_kernel_set simd_kernels_sse2;
+/** AVX2 kernels */
+extern const simd_kernel_set simd_kernels_avx2;
+/** AVX-512 kernels */
+extern const simd_kernel_set simd_kernels_avx512;
+#endif
+
+/**
+ * Class responsible for picking the elementwise kernels at runtime
+ * The best level supported by the CPU (CPUID) is picked on first use, so one binary runs at full speed everywhere
+ * Environment variable NSES_SIMD (scalar / sse2 / avx2 / avx512) caps the level, e.g. NSES_SIMD=scalar forces the
+ * scalar path for validation and A/B benchmarking
+ * Transcendental kernels (math()) follow the math mode, exact by default, environment variable NSES_MATH (exact /
+ * fast) picks it at startup, set_math_mode() at any time
+ */
+class Simd {
+private:
+    /** Currently active kernels */
+    static std::atomic<const simd_kernel_set *> active;
+    /** Currently active level */
+    static std::atomic<simd_level> active_level;
+    /** Currently active math mode (number_of_math_modes until it is picked) */
+    static std::atomic<math_mode> active_math_mode;
+
+    /**
+     * Pick the startup level (detected level, capped by the NSES_SIMD environment variable)
+     * @return Pointer to the active kernels
+     */
+    static const simd_kernel_set *init();
+    /**
+     * Pick the startup math mode (NSES_MATH environment variable, exact otherwise)
+     * @return Math mode
+     */
+    static math_mode init_math_mode();
+
+public:
+    /**
+     * Get the active kernels for the given element type
+     * @tparam T Element type (float / double)
+     * @return Active kernels
+     */
+    template<typename T>
+    static const simd_kernels<T> &kernels() {
+        const simd_kernel_set *current = active.load(std::memory_order_acquire);
+        if (!current) [[unlikely]]
+            current = init();
+        if constexpr (std::is_same_v<T, float>)
+            return current->f32;
+        else
+            return current->f64;
+    }
+    /**
+     * Get the transcendental kernels of the active level and math mode for the given element type
+     * @tparam T Element type (float / double)
+     * @return Active transcendental kernels
+     */
+    template<typename T>
+    static const simd_math_kernels<T> &math() {
+        const simd_kernels<T> &current = kernels<T>();
+        return get_math_mode() == math_mode::fast ? current.fast_math : current.exact_math;
+    }
+    /**
+     * Get the active math mode
+     * @return Math mode
+     */
+    static math_mode get_math_mode() {
+        const math_mode mode = active_math_mode.load(std::memory_order_relaxed);
+        if (mode == math_mode::number_of_math_modes) [[unlikely]]
+            return init_math_mode();
+        return mode;
+    }
+    /**
+     * Set the active math mode
+     * @param mode Math mode
+     */
+    static void set_math_mode(math_mode mode);
+    /**
+     * Get the name of the math mode
+     * @param mode Math mode
+     * @return Name of the math mode
+     */
+    static std::string get_math_mode_name(math_mode mode);
+    /**
+     * Get the whole active kernel set (e.g. for the integer kernels)
+     * @return Active kernels
+     */
+    static const simd_kernel_set &kernel_set() {
+        const simd_kernel_set *current = active.load(std::memory_order_acquire);
+        if (!current) [[unlikely]]
+            current = init();
+        return *current;
+    }
+
+    /**
+     * Detect the best level supported by the CPU and the operating system
+     * @return Best supported level
+     */
+    static simd_level detect_level();
+    /**
+     * Get the active level
+     * @return Active level
+     */
+    static simd_level get_level();
+    /**
+     * Set the active level (clamped to the best supported level)
+     * @param level Wanted level, simd_level::scalar forces the scalar path
+     * @return Level that is really active
+     */
+    static simd_level set_level(simd_level level);
+    /**
+     * Get the name of the level
+     * @param level Level
+     * @return Name of the level
+     */
+    static std::string get_level_name(simd_level level);
+    /**
+     * Get the kernels of the given level (no support check, meant for validation)
+     * @param level Level
+     * @return Kernels of the level
+     */
+    static const simd_kernel_set &get_kernels(simd_level level);
+};
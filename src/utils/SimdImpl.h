@@ -0,0 +1,395 @@
+#pragma once
+
+#include "Simd.h"
+
+/*
+ * Generic bodies of the elementwise kernels, shared by the per-instruction-set translation units
+ * Every Simd_<isa>.cpp describes its registers with a small traits struct (load, store, set1, add, sub, mul, fmadd,
+ * plus div, sqrt, min, max, select_gt and the exponent bit tricks used by the fast math) and instantiates these templates
+ * with it, the unnamed namespace keeps the copies compiled with different instruction set flags apart
+ * Traits with masked_tail = true process the tail with masked loads / stores, the others with a scalar loop
+ * Nothing here may call into the standard library: its inline functions instantiated in the Simd_<isa>.cpp files
+ * would be weak symbols compiled with the instruction set flags, and the linker may pick them for the whole program
+ * (the exact kernels calling std::exp / log / tanh live in Simd.cpp for that reason)
+ */
+
+namespace {
+    /**
+     * Apply a binary operation elementwise (c = op(a, b))
+     * @tparam V Register traits
+     * @param a First operand
+     * @param b Second operand
+     * @param c Result
+     * @param n Number of elements
+     * @param vector_op Operation on registers
+     * @param scalar_op Operation on scalars (tail)
+     */
+    template<typename V, typename VectorOp, typename ScalarOp>
+    inline void simd_binary(const typename V::value_type *a, const typename V::value_type *b, typename V::value_type *c, size_t n,
+                            VectorOp vector_op, ScalarOp scalar_op) {
+        size_t i = 0;
+        for (; i + V::width <= n; i += V::width)
+            V::store(c + i, vector_op(V::load(a + i), V::load(b + i)));
+        if constexpr (V::masked_tail) {
+            if (i < n) {
+                const auto m = V::mask(n - i);
+                V::store_masked(c + i, m, vector_op(V::load_masked(m, a + i), V::load_masked(m, b + i)));
+            }
+        } else {
+            for (; i < n; i++)
+                c[i] = scalar_op(a[i], b[i]);
+        }
+    }
+
+    template<typename V>
+    void simd_add(const typename V::value_type *a, const typename V::value_type *b, typename V::value_type *c, size_t n) {
+        simd_binary<V>(a, b, c, n, [](auto x, auto y) { return V::add(x, y); }, [](auto x, auto y) { return x + y; });
+    }
+
+    template<typename V>
+    void simd_sub(const typename V::value_type *a, const typename V::value_type *b, typename V::value_type *c, size_t n) {
+        simd_binary<V>(a, b, c, n, [](auto x, auto y) { return V::sub(x, y); }, [](auto x, auto y) { return x - y; });
+    }
+
+    template<typename V>
+    void simd_mul(const typename V::value_type *a, const typename V::value_type *b, typename V::value_type *c, size_t n) {
+        simd_binary<V>(a, b, c, n, [](auto x, auto y) { return V::mul(x, y); }, [](auto x, auto y) { return x * y; });
+    }
+
+    template<typename V>
+    void simd_scale(const typename V::value_type *a, typename V::value_type alpha, typename V::value_type *c, size_t n) {
+        const auto alpha_v = V::set1(alpha);
+        size_t i = 0;
+        for (; i + V::width <= n; i += V::width)
+            V::store(c + i, V::mul(alpha_v, V::load(a + i)));
+        if constexpr (V::masked_tail) {
+            if (i < n) {
+                const auto m = V::mask(n - i);
+                V::store_masked(c + i, m, V::mul(alpha_v, V::load_masked(m, a + i)));
+            }
+        } else {
+            for (; i < n; i++)
+                c[i] = alpha * a[i];
+        }
+    }
+
+    template<typename V>
+    void simd_axpy(typename V::value_type alpha, const typename V::value_type *x, typename V::value_type *y, size_t n) {
+        const auto alpha_v = V::set1(alpha);
+        size_t i = 0;
+        for (; i + V::width <= n; i += V::width)
+            V::store(y + i, V::fmadd(alpha_v, V::load(x + i), V::load(y + i)));
+        if constexpr (V::masked_tail) {
+            if (i < n) {
+                const auto m = V::mask(n - i);
+                V::store_masked(y + i, m, V::fmadd(alpha_v, V::load_masked(m, x + i), V::load_masked(m, y + i)));
+            }
+        } else {
+            for (; i < n; i++)
+                y[i] += alpha * x[i];
+        }
+    }
+
+    /**
+     * Constants of the fast math kernels (polynomial coefficients and range limits)
+     * @tparam T Element type (float / double)
+     */
+    template<typename T>
+    struct fast_math_constants;
+
+    template<>
+    struct fast_math_constants<double> {
+        /** Adding it rounds a double to an integer (round to nearest), the integer ends up in the low mantissa bits */
+        static constexpr double ROUND_MAGIC = 6755399441055744.0; /* 1.5 * 2^52 */
+        /** Inputs of exp are clamped to [EXP_MIN, EXP_MAX] (2^n stays a normal number) */
+        static constexpr double EXP_MIN = -708.0;
+        static constexpr double EXP_MAX = 709.0;
+        /** Inputs of tanh are clamped to [-TANH_MAX, TANH_MAX] (tanh rounds to +-1 beyond) */
+        static constexpr double TANH_MAX = 19.1;
+        static constexpr double LOG2E = 1.4426950408889634;
+        static constexpr double SQRT2 = 1.4142135623730951;
+        /** ln(2) split into a part exact in few bits and the rest (n * LN2_HI is exact, Cody-Waite reduction) */
+        static constexpr double LN2_HI = 6.93145751953125e-1;
+        static constexpr double LN2_LO = 1.42860682030941723212e-6;
+        /** Taylor coefficients of exp(r) on |r| <= ln(2) / 2 (1 / k!, highest first) */
+        static constexpr double EXP_COEFFICIENTS[] = {
+                1.0 / 6227020800, 1.0 / 479001600, 1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880, 1.0 / 40320,
+                1.0 / 5040, 1.0 / 720, 1.0 / 120, 1.0 / 24, 1.0 / 6, 1.0 / 2, 1.0, 1.0
+        };
+        /** Coefficients of log(m) = s * P(s^2), s = (m - 1) / (m + 1) (atanh series 2 / (2k + 1), highest first) */
+        static constexpr double LOG_COEFFICIENTS[] = {
+                2.0 / 19, 2.0 / 17, 2.0 / 15, 2.0 / 13, 2.0 / 11, 2.0 / 9, 2.0 / 7, 2.0 / 5, 2.0 / 3, 2.0
+        };
+    };
+
+    template<>
+    struct fast_math_constants<float> {
+        /** Adding it rounds a float to an integer (round to nearest), the integer ends up in the low mantissa bits */
+        static constexpr float ROUND_MAGIC = 12582912.0f; /* 1.5 * 2^23 */
+        /** Inputs of exp are clamped to [EXP_MIN, EXP_MAX] (2^n stays a normal number) */
+        static constexpr float EXP_MIN = -87.0f;
+        static constexpr float EXP_MAX = 88.0f;
+        /** Inputs of tanh are clamped to [-TANH_MAX, TANH_MAX] (tanh rounds to +-1 beyond) */
+        static constexpr float TANH_MAX = 9.0f;
+        static constexpr float LOG2E = 1.44269504f;
+        static constexpr float SQRT2 = 1.41421356f;
+        /** ln(2) split into a part exact in few bits and the rest (n * LN2_HI is exact, Cody-Waite reduction) */
+        static constexpr float LN2_HI = 0.693359375f;
+        static constexpr float LN2_LO = -2.12194440e-4f;
+        /** Taylor coefficients of exp(r) on |r| <= ln(2) / 2 (1 / k!, highest first) */
+        static constexpr float EXP_COEFFICIENTS[] = {
+                1.0f / 5040, 1.0f / 720, 1.0f / 120, 1.0f / 24, 1.0f / 6, 1.0f / 2, 1.0f, 1.0f
+        };
+        /** Coefficients of log(m) = s * P(s^2), s = (m - 1) / (m + 1) (atanh series 2 / (2k + 1), highest first) */
+        static constexpr float LOG_COEFFICIENTS[] = {
+                2.0f / 9, 2.0f / 7, 2.0f / 5, 2.0f / 3, 2.0f
+        };
+    };
+
+    /**
+     * Evaluate a polynomial with the Horner scheme
+     * @tparam V Register traits
+     * @tparam N Number of coefficients
+     * @param x Argument
+     * @param coefficients Coefficients (highest power first)
+     * @return Value of the polynomial
+     */
+    template<typename V, size_t N>
+    inline typename V::reg fast_polynomial(typename V::reg x, const typename V::value_type (&coefficients)[N]) {
+        auto result = V::set1(coefficients[0]);
+        for (size_t i = 1; i < N; i++)
+            result = V::fmadd(result, x, V::set1(coefficients[i]));
+        return result;
+    }
+
+    /**
+     * Fast exp of a register, x = n * ln(2) + r, exp(x) = 2^n * exp(r) with a Taylor polynomial for exp(r)
+     * @tparam V Register traits
+     * @param x Argument
+     * @return exp(x)
+     */
+    template<typename V>
+    inline typename V::reg fast_exp(typename V::reg x) {
+        using constants = fast_math_constants<typename V::value_type>;
+        x = V::min(V::max(x, V::set1(constants::EXP_MIN)), V::set1(constants::EXP_MAX));
+        const auto rounded = V::fmadd(x, V::set1(constants::LOG2E), V::set1(constants::ROUND_MAGIC));
+        const auto n = V::sub(rounded, V::set1(constants::ROUND_MAGIC));
+        auto r = V::fmadd(n, V::set1(-constants::LN2_HI), x);
+        r = V::fmadd(n, V::set1(-constants::LN2_LO), r);
+        return V::mul(fast_polynomial<V>(r, constants::EXP_COEFFICIENTS), V::pow2_of_rounded(rounded));
+    }
+
+    /**
+     * Fast log of a register, x = 2^e * m with m in [sqrt(2) / 2, sqrt(2)), log(x) = e * ln(2) + log(m)
+     * @tparam V Register traits
+     * @param x Argument (positive normal number)
+     * @return log(x)
+     */
+    template<typename V>
+    inline typename V::reg fast_log(typename V::reg x) {
+        using constants = fast_math_constants<typename V::value_type>;
+        auto e = V::exponent(x);
+        auto m = V::mantissa(x);
+        const auto sqrt2 = V::set1(constants::SQRT2);
+        e = V::select_gt(m, sqrt2, V::add(e, V::set1(1)), e);
+        m = V::select_gt(m, sqrt2, V::mul(m, V::set1(0.5)), m);
+
+        const auto one = V::set1(1);
+        const auto s = V::div(V::sub(m, one), V::add(m, one));
+        const auto log_m = V::mul(s, fast_polynomial<V>(V::mul(s, s), constants::LOG_COEFFICIENTS));
+        return V::fmadd(e, V::set1(constants::LN2_HI), V::fmadd(e, V::set1(constants::LN2_LO), log_m));
+    }
+
+    /**
+     * Apply an operation on registers elementwise (c = op(a)), the tail goes through a padded buffer (or masks), so
+     * every element gets exactly the same computation wherever it is in the array
+     * @tparam V Register traits
+     * @param a Operand
+     * @param c Result
+     * @param n Number of elements
+     * @param vector_op Operation on registers
+     */
+    template<typename V, typename VectorOp>
+    inline void simd_unary(const typename V::value_type *a, typename V::value_type *c, size_t n, VectorOp vector_op) {
+        size_t i = 0;
+        for (; i + V::width <= n; i += V::width)
+            V::store(c + i, vector_op(V::load(a + i)));
+        if (i == n)
+            return;
+        if constexpr (V::masked_tail) {
+            const auto m = V::mask(n - i);
+            V::store_masked(c + i, m, vector_op(V::load_masked(m, a + i)));
+        } else {
+            typename V::value_type buffer[V::width] = {};
+            for (size_t j = i; j < n; j++)
+                buffer[j - i] = a[j];
+            V::store(buffer, vector_op(V::load(buffer)));
+            for (size_t j = i; j < n; j++)
+                c[j] = buffer[j - i];
+        }
+    }
+
+    template<typename V>
+    void simd_fast_exp(const typename V::value_type *a, typename V::value_type *c, size_t n) {
+        simd_unary<V>(a, c, n, [](auto x) { return fast_exp<V>(x); });
+    }
+
+    template<typename V>
+    void simd_fast_log(const typename V::value_type *a, typename V::value_type *c, size_t n) {
+        simd_unary<V>(a, c, n, [](auto x) { return fast_log<V>(x); });
+    }
+
+    template<typename V>
+    void simd_fast_tanh(const typename V::value_type *a, typename V::value_type *c, size_t n) {
+        /* tanh(x) = (exp(2x) - 1) / (exp(2x) + 1) */
+        using constants = fast_math_constants<typename V::value_type>;
+        simd_unary<V>(a, c, n, [](auto x) {
+            x = V::min(V::max(x, V::set1(-constants::TANH_MAX)), V::set1(constants::TANH_MAX));
+            const auto e = fast_exp<V>(V::add(x, x));
+            const auto one = V::set1(1);
+            return V::div(V::sub(e, one), V::add(e, one));
+        });
+    }
+
+    template<typename V>
+    void simd_fast_sigmoid(const typename V::value_type *a, typename V::value_type *c, size_t n) {
+        /* sigmoid(x) = 1 / (1 + exp(-x)) */
+        simd_unary<V>(a, c, n, [](auto x) {
+            const auto one = V::set1(1);
+            return V::div(one, V::add(one, fast_exp<V>(V::sub(V::set1(0), x))));
+        });
+    }
+
+    /**
+     * Build the exact math kernels for one element type (the same functions for every level, defined in Simd.cpp)
+     * @tparam T Element type (float / double)
+     * @return Exact math kernels
+     */
+    template<typename T>
+    constexpr simd_math_kernels<T> simd_make_exact_math_kernels() {
+        return {simd_exact_exp<T>, simd_exact_log<T>, simd_exact_tanh<T>, simd_exact_sigmoid<T>};
+    }
+
+    /**
+     * Build the fast math kernels for one register traits struct
+     * @tparam V Register traits
+     * @return Fast math kernels
+     */
+    template<typename V>
+    constexpr simd_math_kernels<typename V::value_type> simd_make_fast_math_kernels() {
+        return {simd_fast_exp<V>, simd_fast_log<V>, simd_fast_tanh<V>, simd_fast_sigmoid<V>};
+    }
+
+    /**
+     * Apply an in-place update to several arrays driven by one input array (optimizer kernels), full registers first,
+     * the tail goes through zero padded copies of one register
+     * @tparam V Register traits
+     * @tparam N Number of updated arrays
+     * @param input Input array (gradient)
+     * @param outputs Updated arrays (state and parameters)
+     * @param n Number of elements
+     * @param op Operation, called with register-sized pointers into the input and the updated arrays
+     */
+    template<typename V, size_t N, typename Op>
+    inline void simd_update(const typename V::value_type *input, typename V::value_type *const (&outputs)[N], size_t n, Op op) {
+        using T = typename V::value_type;
+        T *p[N];
+        size_t i = 0;
+        for (; i + V::width <= n; i += V::width) {
+            for (size_t a = 0; a < N; a++)
+                p[a] = outputs[a] + i;
+            op(input + i, p);
+        }
+        if (i < n) {
+            T input_tail[V::width] = {};
+            T tails[N][V::width] = {};
+            for (size_t j = i; j < n; j++)
+                input_tail[j - i] = input[j];
+            for (size_t a = 0; a < N; a++) {
+                for (size_t j = i; j < n; j++)
+                    tails[a][j - i] = outputs[a][j];
+                p[a] = tails[a];
+            }
+            op(input_tail, p);
+            for (size_t a = 0; a < N; a++)
+                for (size_t j = i; j < n; j++)
+                    outputs[a][j] = tails[a][j - i];
+        }
+    }
+
+    template<typename V>
+    void simd_momentum(typename V::value_type rate, typename V::value_type beta, typename V::value_type scale,
+                       const typename V::value_type *g, typename V::value_type *v, typename V::value_type *w, size_t n) {
+        const auto rate_v = V::set1(rate), beta_v = V::set1(beta), scale_v = V::set1(scale);
+        simd_update<V>(g, {v, w}, n, [&](const auto *gi, auto *const *p) {
+            const auto velocity = V::fmadd(beta_v, V::load(p[0]), V::mul(scale_v, V::load(gi)));
+            V::store(p[0], velocity);
+            V::store(p[1], V::fmadd(rate_v, velocity, V::load(p[1])));
+        });
+    }
+
+    template<typename V>
+    void simd_nesterov(typename V::value_type rate, typename V::value_type beta, typename V::value_type scale,
+                       const typename V::value_type *g, typename V::value_type *v, typename V::value_type *w, size_t n) {
+        const auto rate_v = V::set1(rate), beta_v = V::set1(beta), scale_v = V::set1(scale);
+        simd_update<V>(g, {v, w}, n, [&](const auto *gi, auto *const *p) {
+            const auto gradient = V::mul(scale_v, V::load(gi));
+            const auto velocity = V::fmadd(beta_v, V::load(p[0]), gradient);
+            V::store(p[0], velocity);
+            V::store(p[1], V::fmadd(rate_v, V::fmadd(beta_v, velocity, gradient), V::load(p[1])));
+        });
+    }
+
+    template<typename V>
+    void simd_rmsprop(typename V::value_type rate, typename V::value_type rho, typename V::value_type epsilon,
+                      typename V::value_type scale, const typename V::value_type *g, typename V::value_type *s,
+                      typename V::value_type *w, size_t n) {
+        const auto rate_v = V::set1(rate), rho_v = V::set1(rho), one_minus_rho_v = V::set1(1 - rho);
+        const auto epsilon_v = V::set1(epsilon), scale_v = V::set1(scale);
+        simd_update<V>(g, {s, w}, n, [&](const auto *gi, auto *const *p) {
+            const auto gradient = V::mul(scale_v, V::load(gi));
+            const auto square = V::fmadd(rho_v, V::load(p[0]), V::mul(one_minus_rho_v, V::mul(gradient, gradient)));
+            V::store(p[0], square);
+            V::store(p[1], V::fmadd(rate_v, V::div(gradient, V::add(V::sqrt(square), epsilon_v)), V::load(p[1])));
+        });
+    }
+
+    template<typename V>
+    void simd_adam(typename V::value_type rate, typename V::value_type beta1, typename V::value_type beta2,
+                   typename V::value_type epsilon, typename V::value_type scale, const typename V::value_type *g,
+                   typename V::value_type *m, typename V::value_type *v, typename V::value_type *w, size_t n) {
+        const auto rate_v = V::set1(rate), beta1_v = V::set1(beta1), beta2_v = V::set1(beta2);
+        const auto one_minus_beta1_v = V::set1(1 - beta1), one_minus_beta2_v = V::set1(1 - beta2);
+        const auto epsilon_v = V::set1(epsilon), scale_v = V::set1(scale);
+        simd_update<V>(g, {m, v, w}, n, [&](const auto *gi, auto *const *p) {
+            const auto gradient = V::mul(scale_v, V::load(gi));
+            const auto first = V::fmadd(beta1_v, V::load(p[0]), V::mul(one_minus_beta1_v, gradient));
+            const auto second = V::fmadd(beta2_v, V::load(p[1]), V::mul(one_minus_beta2_v, V::mul(gradient, gradient)));
+            V::store(p[0], first);
+            V::store(p[1], second);
+            V::store(p[2], V::fmadd(rate_v, V::div(first, V::add(V::sqrt(second), epsilon_v)), V::load(p[2])));
+        });
+    }
+
+    /**
+     * Build the optimizer kernels for one register traits struct
+     * @tparam V Register traits
+     * @return Optimizer kernels
+     */
+    template<typename V>
+    constexpr simd_optimizer_kernels<typename V::value_type> simd_make_optimizer_kernels() {
+        return {simd_momentum<V>, simd_nesterov<V>, simd_rmsprop<V>, simd_adam<V>};
+    }
+
+    /**
+     * Build the kernel table for one register traits struct
+     * @tparam V Register traits
+     * @return Kernel table
+     */
+    template<typename V>
+    constexpr simd_kernels<typename V::value_type> simd_make_kernels() {
+        return {simd_add<V>, simd_sub<V>, simd_mul<V>, simd_scale<V>, simd_axpy<V>,
+                simd_make_exact_math_kernels<typename V::value_type>(), simd_make_fast_math_kernels<V>(),
+                simd_make_optimizer_kernels<V>()};
+    }
+}
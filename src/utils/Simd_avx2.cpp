@@ -0,0 +1,95 @@
+#include "SimdImpl.h"
+
+#include <immintrin.h>
+
+/* Compiled with -mavx2 -mfma (/arch:AVX2), only ever called when CPUID reports AVX2 + FMA, 4 doubles / 8 floats per register */
+
+namespace {
+    /** AVX2 registers of doubles */
+    struct avx2_f64 {
+        using value_type = double;
+        using reg = __m256d;
+        static constexpr size_t width = 4;
+        static constexpr bool masked_tail = false;
+        static reg load(const double *p) { return _mm256_loadu_pd(p); }
+        static void store(double *p, reg v) { _mm256_storeu_pd(p, v); }
+        static reg set1(double v) { return _mm256_set1_pd(v); }
+        static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+        static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+        static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+        static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+        static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+        static reg select_gt(reg a, reg b, reg x, reg y) { return _mm256_blendv_pd(y, x, _mm256_cmp_pd(a, b, _CMP_GT_OQ)); }
+        static reg pow2_of_rounded(reg t) {
+            return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(t), _mm256_set1_epi64x(1023)), 52));
+        }
+        static reg exponent(reg x) { /* No int64 -> double conversion, exponent bits go into the mantissa of 2^52 */
+            const __m256i e = _mm256_or_si256(_mm256_srli_epi64(_mm256_castpd_si256(x), 52), _mm256_set1_epi64x(0x4330000000000000));
+            return _mm256_sub_pd(_mm256_castsi256_pd(e), _mm256_set1_pd(4503599627370496.0 + 1023));
+        }
+        static reg mantissa(reg x) {
+            const __m256i m = _mm256_and_si256(_mm256_castpd_si256(x), _mm256_set1_epi64x(0x000FFFFFFFFFFFFF));
+            return _mm256_castsi256_pd(_mm256_or_si256(m, _mm256_set1_epi64x(0x3FF0000000000000)));
+        }
+    };
+
+    /** AVX2 registers of floats */
+    struct avx2_f32 {
+        using value_type = float;
+        using reg = __m256;
+        static constexpr size_t width = 8;
+        static constexpr bool masked_tail = false;
+        static reg load(const float *p) { return _mm256_loadu_ps(p); }
+        static void store(float *p, reg v) { _mm256_storeu_ps(p, v); }
+        static reg set1(float v) { return _mm256_set1_ps(v); }
+        static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+        static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+        static reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+        static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+        static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+        static reg select_gt(reg a, reg b, reg x, reg y) { return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+        static reg pow2_of_rounded(reg t) {
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_castps_si256(t), _mm256_set1_epi32(127)), 23));
+        }
+        static reg exponent(reg x) {
+            const __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(x), 23), _mm256_set1_epi32(127));
+            return _mm256_cvtepi32_ps(e);
+        }
+        static reg mantissa(reg x) {
+            const __m256i m = _mm256_and_si256(_mm256_castps_si256(x), _mm256_set1_epi32(0x007FFFFF));
+            return _mm256_castsi256_ps(_mm256_or_si256(m, _mm256_set1_epi32(0x3F800000)));
+        }
+    };
+
+    int32_t avx2_dot_i8(const int8_t *a, const int8_t *b, size_t n) {
+        /* 16 int8 sign extended to 16 int16 (vpmovsxbw), vpmaddwd multiplies the int16 pairs and sums them into int32 */
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+            const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+        }
+
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        int32_t sum = 0;
+        for (int32_t lane : lanes)
+            sum += lane;
+        for (; i < n; i++)
+            sum += static_cast<int32_t>(a[i]) * b[i];
+        return sum;
+    }
+}
+
+const simd_kernel_set simd_kernels_avx2 = {
+        simd_make_kernels<avx2_f64>(),
+        simd_make_kernels<avx2_f32>(),
+        avx2_dot_i8,
+};
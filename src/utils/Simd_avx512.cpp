@@ -0,0 +1,104 @@
+#include "SimdImpl.h"
+
+#include <immintrin.h>
+
+/* Compiled with -mavx512f (/arch:AVX512), only ever called when CPUID reports AVX-512F, 8 doubles / 16 floats per register */
+/* Tails are handled with masked loads / stores instead of a scalar loop */
+/* Shifts, conversions, min, max and sqrt use the all-ones maskz forms, the unmasked ones trip -Wmaybe-uninitialized in GCC 12 headers */
+
+namespace {
+    /** AVX-512 registers of doubles */
+    struct avx512_f64 {
+        using value_type = double;
+        using reg = __m512d;
+        static constexpr size_t width = 8;
+        static constexpr bool masked_tail = true;
+        static reg load(const double *p) { return _mm512_loadu_pd(p); }
+        static void store(double *p, reg v) { _mm512_storeu_pd(p, v); }
+        static __mmask8 mask(size_t n) { return static_cast<__mmask8>((1u << n) - 1); }
+        static reg load_masked(__mmask8 m, const double *p) { return _mm512_maskz_loadu_pd(m, p); }
+        static void store_masked(double *p, __mmask8 m, reg v) { _mm512_mask_storeu_pd(p, m, v); }
+        static reg set1(double v) { return _mm512_set1_pd(v); }
+        static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+        static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+        static reg sqrt(reg a) { return _mm512_maskz_sqrt_pd(0xFF, a); }
+        static reg min(reg a, reg b) { return _mm512_maskz_min_pd(0xFF, a, b); }
+        static reg max(reg a, reg b) { return _mm512_maskz_max_pd(0xFF, a, b); }
+        static reg select_gt(reg a, reg b, reg x, reg y) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), y, x); }
+        static reg pow2_of_rounded(reg t) {
+            return _mm512_castsi512_pd(_mm512_maskz_slli_epi64(0xFF, _mm512_add_epi64(_mm512_castpd_si512(t), _mm512_set1_epi64(1023)), 52));
+        }
+        static reg exponent(reg x) { /* int64 -> double conversion needs AVX-512DQ, exponent bits go into the mantissa of 2^52 */
+            const __m512i e = _mm512_or_si512(_mm512_maskz_srli_epi64(0xFF, _mm512_castpd_si512(x), 52), _mm512_set1_epi64(0x4330000000000000));
+            return _mm512_sub_pd(_mm512_castsi512_pd(e), _mm512_set1_pd(4503599627370496.0 + 1023));
+        }
+        static reg mantissa(reg x) {
+            const __m512i m = _mm512_and_si512(_mm512_castpd_si512(x), _mm512_set1_epi64(0x000FFFFFFFFFFFFF));
+            return _mm512_castsi512_pd(_mm512_or_si512(m, _mm512_set1_epi64(0x3FF0000000000000)));
+        }
+    };
+
+    /** AVX-512 registers of floats */
+    struct avx512_f32 {
+        using value_type = float;
+        using reg = __m512;
+        static constexpr size_t width = 16;
+        static constexpr bool masked_tail = true;
+        static reg load(const float *p) { return _mm512_loadu_ps(p); }
+        static void store(float *p, reg v) { _mm512_storeu_ps(p, v); }
+        static __mmask16 mask(size_t n) { return static_cast<__mmask16>((1u << n) - 1); }
+        static reg load_masked(__mmask16 m, const float *p) { return _mm512_maskz_loadu_ps(m, p); }
+        static void store_masked(float *p, __mmask16 m, reg v) { _mm512_mask_storeu_ps(p, m, v); }
+        static reg set1(float v) { return _mm512_set1_ps(v); }
+        static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+        static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+        static reg sqrt(reg a) { return _mm512_maskz_sqrt_ps(0xFFFF, a); }
+        static reg min(reg a, reg b) { return _mm512_maskz_min_ps(0xFFFF, a, b); }
+        static reg max(reg a, reg b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+        static reg select_gt(reg a, reg b, reg x, reg y) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_GT_OQ), y, x); }
+        static reg pow2_of_rounded(reg t) {
+            return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(0xFFFF, _mm512_add_epi32(_mm512_castps_si512(t), _mm512_set1_epi32(127)), 23));
+        }
+        static reg exponent(reg x) {
+            const __m512i e = _mm512_sub_epi32(_mm512_maskz_srli_epi32(0xFFFF, _mm512_castps_si512(x), 23), _mm512_set1_epi32(127));
+            return _mm512_maskz_cvtepi32_ps(0xFFFF, e);
+        }
+        static reg mantissa(reg x) {
+            const __m512i m = _mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32(0x007FFFFF));
+            return _mm512_castsi512_ps(_mm512_or_si512(m, _mm512_set1_epi32(0x3F800000)));
+        }
+    };
+
+    int32_t avx512_dot_i8(const int8_t *a, const int8_t *b, size_t n) {
+        /* Same 256-bit code as AVX2 (AVX-512F alone has no 512-bit int16 multiply, that needs AVX-512BW), 16 int8 sign
+         * extended to 16 int16 (vpmovsxbw), vpmaddwd multiplies the int16 pairs and sums them into int32 */
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+            const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+        }
+
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        int32_t sum = 0;
+        for (int32_t lane : lanes)
+            sum += lane;
+        for (; i < n; i++)
+            sum += static_cast<int32_t>(a[i]) * b[i];
+        return sum;
+    }
+}
+
+const simd_kernel_set simd_kernels_avx512 = {
+        simd_make_kernels<avx512_f64>(),
+        simd_make_kernels<avx512_f32>(),
+        avx512_dot_i8,
+};
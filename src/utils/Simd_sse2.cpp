@@ -0,0 +1,104 @@
+#include "SimdImpl.h"
+
+#include <emmintrin.h>
+
+/* Compiled with the baseline x86-64 flags (SSE2 is part of the baseline), 2 doubles / 4 floats per register */
+
+namespace {
+    /** SSE2 registers of doubles */
+    struct sse2_f64 {
+        using value_type = double;
+        using reg = __m128d;
+        static constexpr size_t width = 2;
+        static constexpr bool masked_tail = false;
+        static reg load(const double *p) { return _mm_loadu_pd(p); }
+        static void store(double *p, reg v) { _mm_storeu_pd(p, v); }
+        static reg set1(double v) { return _mm_set1_pd(v); }
+        static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); } /* No FMA in SSE2 */
+        static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+        static reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+        static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+        static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+        static reg select_gt(reg a, reg b, reg x, reg y) {
+            const reg m = _mm_cmpgt_pd(a, b);
+            return _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, y));
+        }
+        static reg pow2_of_rounded(reg t) {
+            return _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(_mm_castpd_si128(t), _mm_set1_epi64x(1023)), 52));
+        }
+        static reg exponent(reg x) { /* No int64 -> double conversion, exponent bits go into the mantissa of 2^52 */
+            const __m128i e = _mm_or_si128(_mm_srli_epi64(_mm_castpd_si128(x), 52), _mm_set1_epi64x(0x4330000000000000));
+            return _mm_sub_pd(_mm_castsi128_pd(e), _mm_set1_pd(4503599627370496.0 + 1023));
+        }
+        static reg mantissa(reg x) {
+            const __m128i m = _mm_and_si128(_mm_castpd_si128(x), _mm_set1_epi64x(0x000FFFFFFFFFFFFF));
+            return _mm_castsi128_pd(_mm_or_si128(m, _mm_set1_epi64x(0x3FF0000000000000)));
+        }
+    };
+
+    /** SSE2 registers of floats */
+    struct sse2_f32 {
+        using value_type = float;
+        using reg = __m128;
+        static constexpr size_t width = 4;
+        static constexpr bool masked_tail = false;
+        static reg load(const float *p) { return _mm_loadu_ps(p); }
+        static void store(float *p, reg v) { _mm_storeu_ps(p, v); }
+        static reg set1(float v) { return _mm_set1_ps(v); }
+        static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); } /* No FMA in SSE2 */
+        static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+        static reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+        static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+        static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+        static reg select_gt(reg a, reg b, reg x, reg y) {
+            const reg m = _mm_cmpgt_ps(a, b);
+            return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y));
+        }
+        static reg pow2_of_rounded(reg t) {
+            return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_castps_si128(t), _mm_set1_epi32(127)), 23));
+        }
+        static reg exponent(reg x) {
+            const __m128i e = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(x), 23), _mm_set1_epi32(127));
+            return _mm_cvtepi32_ps(e);
+        }
+        static reg mantissa(reg x) {
+            const __m128i m = _mm_and_si128(_mm_castps_si128(x), _mm_set1_epi32(0x007FFFFF));
+            return _mm_castsi128_ps(_mm_or_si128(m, _mm_set1_epi32(0x3F800000)));
+        }
+    };
+
+    int32_t sse2_dot_i8(const int8_t *a, const int8_t *b, size_t n) {
+        /* 16 int8 per register, sign extended to two registers of int16 (SSE2 has no pmovsx), pmaddwd multiplies the
+         * int16 pairs and sums them into int32 (cannot overflow: 2 * 127 * 127 fits easily) */
+        __m128i acc = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            const __m128i a_lo = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+            const __m128i a_hi = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+            const __m128i b_lo = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+            const __m128i b_hi = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(a_lo, b_lo), _mm_madd_epi16(a_hi, b_hi)));
+        }
+
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        int32_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (; i < n; i++)
+            sum += static_cast<int32_t>(a[i]) * b[i];
+        return sum;
+    }
+}
+
+const simd_kernel_set simd_kernels_sse2 = {
+        simd_make_kernels<sse2_f64>(),
+        simd_make_kernels<sse2_f32>(),
+        sse2_dot_i8,
+};
@@ -0,0 +1,71 @@
+#include "SparseMatrix.h"
+
+template<typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix() : rows(0), cols(0), row_offsets(1, 0) {
+    /* empty */
+}
+
+template<typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix(BasicMatrixView<T> dense) : rows(dense.get_rows()), cols(dense.get_cols()) {
+    const size_t non_zeros = count_non_zeros(dense);
+    this->row_offsets.reserve(this->rows + 1);
+    this->col_indices.reserve(non_zeros);
+    this->values.reserve(non_zeros);
+
+    this->row_offsets.push_back(0);
+    for (uint32_t i = 0; i < this->rows; i++) {
+        for (uint32_t j = 0; j < this->cols; j++) {
+            const T value = dense.get_value(i, j);
+            if (value != 0) {
+                this->col_indices.push_back(j);
+                this->values.push_back(value);
+            }
+        }
+        this->row_offsets.push_back(static_cast<uint32_t>(this->values.size()));
+    }
+}
+
+template<typename T>
+void BasicSparseMatrix<T>::multiply_vector(T alpha, const T *x, T *y) const {
+    for (uint32_t i = 0; i < this->rows; i++) {
+        /* Non-zeros of a row are summed in column order (same order as the dense kernel) */
+        T sum = 0;
+        for (uint32_t p = this->row_offsets[i]; p < this->row_offsets[i + 1]; p++)
+            sum += this->values[p] * x[this->col_indices[p]];
+        y[i] += alpha * sum;
+    }
+}
+
+template<typename T>
+size_t BasicSparseMatrix<T>::count_non_zeros(BasicMatrixView<T> dense) {
+    size_t count = 0;
+    for (uint32_t i = 0; i < dense.get_rows(); i++)
+        for (uint32_t j = 0; j < dense.get_cols(); j++)
+            count += dense.get_value(i, j) != 0;
+    return count;
+}
+
+template<typename T>
+uint32_t BasicSparseMatrix<T>::get_rows() const {
+    return this->rows;
+}
+
+template<typename T>
+uint32_t BasicSparseMatrix<T>::get_cols() const {
+    return this->cols;
+}
+
+template<typename T>
+size_t BasicSparseMatrix<T>::get_non_zeros() const {
+    return this->values.size();
+}
+
+template<typename T>
+double BasicSparseMatrix<T>::get_density() const {
+    if (this->rows == 0 || this->cols == 0)
+        return 0;
+    return static_cast<double>(this->values.size()) / (static_cast<double>(this->rows) * this->cols);
+}
+
+template class BasicSparseMatrix<float>;
+template class BasicSparseMatrix<double>;
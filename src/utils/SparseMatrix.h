@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cmath>
+#include "MatrixView.h"
+
+/**
+ * Class representing a sparse matrix in the compressed sparse row (CSR) format
+ * Only the non-zero values are stored (row by row, together with their column indices), a matrix-vector product then
+ * costs one multiply-add per non-zero instead of one per element, which pays off for pruned weights
+ * The matrix is built from a dense matrix (or a view) and is immutable, it has to be rebuilt when the dense one changes
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+class BasicSparseMatrix {
+private:
+    /** Number of rows */
+    uint32_t rows;
+    /** Number of columns */
+    uint32_t cols;
+    /** Index of the first non-zero of each row in col_indices / values (rows + 1 elements, last one is the count) */
+    std::vector<uint32_t> row_offsets;
+    /** Column index of each non-zero */
+    std::vector<uint32_t> col_indices;
+    /** Value of each non-zero */
+    std::vector<T> values;
+
+public:
+    /**
+     * Default constructor (empty matrix)
+     */
+    BasicSparseMatrix();
+    /**
+     * Constructor compressing a dense matrix or a view (exact zeros are dropped)
+     * @param dense Matrix or view to compress
+     */
+    explicit BasicSparseMatrix(BasicMatrixView<T> dense);
+
+    /**
+     * Compute y += alpha * A * x (sparse matrix-vector multiplication)
+     * @param alpha Scalar multiplying the product
+     * @param x Dense vector (cols elements, contiguous)
+     * @param y Dense vector (rows elements, contiguous)
+     */
+    void multiply_vector(T alpha, const T *x, T *y) const;
+
+    /**
+     * Count the non-zero values of a dense matrix or a view
+     * @param dense Matrix or view
+     * @return Number of non-zero values
+     */
+    static size_t count_non_zeros(BasicMatrixView<T> dense);
+
+    /**
+     * Get the number of rows of the matrix
+     * @return Number of rows
+     */
+    [[nodiscard]] uint32_t get_rows() const;
+    /**
+     * Get the number of columns of the matrix
+     * @return Number of columns
+     */
+    [[nodiscard]] uint32_t get_cols() const;
+    /**
+     * Get the number of stored (non-zero) values
+     * @return Number of non-zero values
+     */
+    [[nodiscard]] size_t get_non_zeros() const;
+    /**
+     * Get the density of the matrix (fraction of non-zero values)
+     * @return Density from 0 to 1
+     */
+    [[nodiscard]] double get_density() const;
+};
+
+/* Instantiated in SparseMatrix.cpp */
+extern template class BasicSparseMatrix<float>;
+extern template class BasicSparseMatrix<double>;
+
+/** Sparse matrix of doubles */
+using SparseMatrix = BasicSparseMatrix<double>;
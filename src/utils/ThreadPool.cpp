@@ -0,0 +1,119 @@
+#include "ThreadPool.h"
+
+namespace {
+    /** Flag set on the threads currently running tasks (jobs started from a task run serially) */
+    thread_local bool inside_task = false;
+}
+
+ThreadPool::ThreadPool() : task(nullptr), task_count(0), next_task(0), busy_workers(0), generation(0), stop(false),
+                           num_threads(get_hardware_threads()) {
+    if (const char *env = std::getenv("NSES_NUM_THREADS")) {
+        /* Invalid values are ignored (same as NSES_SIMD) */
+        char *end = nullptr;
+        long count = std::strtol(env, &end, 10);
+        if (end != env && *end == '\0' && count > 0)
+            this->num_threads = static_cast<uint32_t>(count);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    std::lock_guard dispatch_lock(this->dispatch_mutex);
+    this->stop_workers();
+}
+
+ThreadPool &ThreadPool::get_instance() {
+    static ThreadPool instance;
+    return instance;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t last_generation = 0;
+    while (true) {
+        std::unique_lock lock(this->mutex);
+        this->job_posted.wait(lock, [&] { return this->stop || this->generation != last_generation; });
+        if (this->stop)
+            return;
+        last_generation = this->generation;
+        const auto *job = this->task;
+        const uint32_t count = this->task_count;
+        lock.unlock();
+
+        this->run_tasks(*job, count);
+
+        lock.lock();
+        if (--this->busy_workers == 0)
+            this->job_done.notify_one();
+    }
+}
+
+void ThreadPool::run_tasks(const std::function<void(uint32_t)> &job, uint32_t count) {
+    inside_task = true;
+    for (uint32_t i = this->next_task.fetch_add(1, std::memory_order_relaxed); i < count; i = this->next_task.fetch_add(1, std::memory_order_relaxed))
+        job(i);
+    inside_task = false;
+}
+
+void ThreadPool::start_workers() {
+    const uint32_t count = this->num_threads.load(std::memory_order_relaxed);
+    this->stop = false;
+    this->generation = 0;
+    for (uint32_t i = 1; i < count; i++)
+        this->workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+void ThreadPool::stop_workers() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stop = true;
+    }
+    this->job_posted.notify_all();
+    for (auto &worker : this->workers)
+        worker.join();
+    this->workers.clear();
+}
+
+uint32_t ThreadPool::get_num_threads() {
+    return get_instance().num_threads.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::set_num_threads(uint32_t count) {
+    auto &pool = get_instance();
+    std::lock_guard dispatch_lock(pool.dispatch_mutex);
+    pool.stop_workers(); /* Workers are started again (with the new count) by the next job */
+    pool.num_threads = count == 0 ? get_hardware_threads() : count;
+}
+
+uint32_t ThreadPool::get_hardware_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::parallel_for(uint32_t count, const std::function<void(uint32_t)> &task) {
+    auto &pool = get_instance();
+
+    /* Serial path: one task, one thread, nested job or another thread already running a job */
+    std::unique_lock dispatch_lock(pool.dispatch_mutex, std::defer_lock);
+    if (count <= 1 || inside_task || pool.num_threads.load(std::memory_order_relaxed) <= 1 || !dispatch_lock.try_lock()) {
+        for (uint32_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    if (pool.workers.empty())
+        pool.start_workers();
+
+    {
+        std::lock_guard lock(pool.mutex);
+        pool.task = &task;
+        pool.task_count = count;
+        pool.next_task.store(0, std::memory_order_relaxed);
+        pool.busy_workers = static_cast<uint32_t>(pool.workers.size());
+        pool.generation++;
+    }
+    pool.job_posted.notify_all();
+
+    pool.run_tasks(task, count);
+
+    std::unique_lock lock(pool.mutex);
+    pool.job_done.wait(lock, [&] { return pool.busy_workers == 0; });
+    pool.task = nullptr;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+/**
+ * Class owning the worker threads used by the parallel kernels
+ * Workers are started on first use and sleep between jobs, a job is a range of independent tasks, tasks are handed
+ * out dynamically (atomic counter), the calling thread works on the job too and returns once every task is done
+ * Number of threads (calling thread included) defaults to the number of hardware threads, environment variable
+ * NSES_NUM_THREADS overrides it at startup, set_num_threads() at any time
+ * Jobs do not nest: a job started from inside a task (or while another thread runs a job) runs on the calling thread
+ */
+class ThreadPool {
+private:
+    /** Worker threads (number of threads - 1, the calling thread is the last one) */
+    std::vector<std::thread> workers;
+    /** Mutex guarding the job state below */
+    std::mutex mutex;
+    /** Mutex held by the thread running a job (and while resizing) */
+    std::mutex dispatch_mutex;
+    /** Wakes the workers when a job is posted */
+    std::condition_variable job_posted;
+    /** Wakes the calling thread when all workers are done with the job */
+    std::condition_variable job_done;
+    /** Tasks of the current job */
+    const std::function<void(uint32_t)> *task;
+    /** Number of tasks of the current job */
+    uint32_t task_count;
+    /** Index of the next task to hand out */
+    std::atomic<uint32_t> next_task;
+    /** Number of workers still working on the current job */
+    uint32_t busy_workers;
+    /** Job counter (workers compare it with the last job they worked on) */
+    uint64_t generation;
+    /** Flag telling the workers to quit */
+    bool stop;
+    /** Number of threads (calling thread included) */
+    std::atomic<uint32_t> num_threads;
+
+    /**
+     * Constructor (reads NSES_NUM_THREADS, workers are started lazily)
+     */
+    ThreadPool();
+    /**
+     * Get the single instance of the pool
+     * @return Thread pool
+     */
+    static ThreadPool &get_instance();
+    /**
+     * Main loop of a worker thread
+     */
+    void worker_loop();
+    /**
+     * Work on the tasks of the current job until there is none left
+     * @param job Tasks
+     * @param count Number of tasks
+     */
+    void run_tasks(const std::function<void(uint32_t)> &job, uint32_t count);
+    /**
+     * Start the workers for the configured number of threads (dispatch_mutex has to be held)
+     */
+    void start_workers();
+    /**
+     * Stop and join all workers (dispatch_mutex has to be held)
+     */
+    void stop_workers();
+
+public:
+    /**
+     * Destructor, joins the workers
+     */
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Get the number of threads the parallel kernels use (calling thread included)
+     * @return Number of threads
+     */
+    static uint32_t get_num_threads();
+    /**
+     * Set the number of threads the parallel kernels use (calling thread included), must not be called from a task
+     * @param count Number of threads, 0 means the number of hardware threads, 1 disables the workers
+     */
+    static void set_num_threads(uint32_t count);
+    /**
+     * Get the number of hardware threads (at least 1)
+     * @return Number of hardware threads
+     */
+    static uint32_t get_hardware_threads();
+    /**
+     * Run count independent tasks in parallel, returns once all of them are done
+     * Tasks must not throw (there is nobody to catch the exception on a worker)
+     * @param count Number of tasks
+     * @param task Task, called with the index of the task (0 ... count - 1)
+     */
+    static void parallel_for(uint32_t count, const std::function<void(uint32_t)> &task);
+};
@@ -0,0 +1,66 @@
+#include "Workspace.h"
+
+template<typename T>
+BasicWorkspace<T>::BasicWorkspace(size_t capacity) : chunk_used(0), used(0), high_water_mark(0) {
+    this->add_chunk(capacity);
+}
+
+template<typename T>
+void BasicWorkspace<T>::add_chunk(size_t min_size) {
+    /* Chunks at least double, so a step that outgrows the arena adds only a few of them */
+    size_t size = std::max(min_size, this->chunks.empty() ? min_size : 2 * this->chunks.back().size());
+    size = (size + LANES - 1) / LANES * LANES;
+    this->chunks.emplace_back(size);
+    this->chunk_used = 0;
+}
+
+template<typename T>
+T *BasicWorkspace<T>::allocate(size_t size) {
+    const size_t padded = (size + LANES - 1) / LANES * LANES; /* Keep the next buffer on a cache line too */
+    if (this->chunk_used + padded > this->chunks.back().size())
+        this->add_chunk(padded);
+
+    T *buffer = this->chunks.back().data() + this->chunk_used;
+    this->chunk_used += padded;
+    this->used += padded;
+    this->high_water_mark = std::max(this->high_water_mark, this->used);
+    return buffer;
+}
+
+template<typename T>
+T *BasicWorkspace<T>::allocate_zeroed(size_t size) {
+    T *buffer = this->allocate(size);
+    std::fill(buffer, buffer + size, T(0));
+    return buffer;
+}
+
+template<typename T>
+void BasicWorkspace<T>::reset() {
+    if (this->chunks.size() > 1) { /* Arena had to grow, replace the chunks with one chunk of the high-water mark size */
+        this->chunks.clear();
+        this->add_chunk(this->high_water_mark);
+    }
+    this->chunk_used = 0;
+    this->used = 0;
+}
+
+template<typename T>
+size_t BasicWorkspace<T>::get_used_bytes() const {
+    return this->used * sizeof(T);
+}
+
+template<typename T>
+size_t BasicWorkspace<T>::get_high_water_mark_bytes() const {
+    return this->high_water_mark * sizeof(T);
+}
+
+template<typename T>
+size_t BasicWorkspace<T>::get_capacity_bytes() const {
+    size_t capacity = 0;
+    for (auto &chunk : this->chunks)
+        capacity += chunk.size();
+    return capacity * sizeof(T);
+}
+
+template class BasicWorkspace<float>;
+template class BasicWorkspace<double>;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "AlignedAllocator.h"
+
+/**
+ * Bump (arena) allocator for the short-lived buffers of one training step
+ * Buffers are carved from large aligned chunks by moving a pointer, nothing is freed individually, the whole arena is
+ * released at once by reset() (once per batch), so the temporaries of the forward and backward pass never touch the
+ * global allocator
+ * When a step needs more than the current capacity, another chunk is added, the next reset() merges all chunks into
+ * one chunk of the high-water mark size, so after the first batch the arena does not allocate at all
+ * @tparam T Element type (float / double)
+ */
+template<typename T>
+class BasicWorkspace {
+private:
+    /** Every buffer starts on its own cache line (elements per cache line) */
+    static constexpr size_t LANES = MATRIX_ALIGNMENT / sizeof(T);
+    /** Capacity (in elements) of the first chunk */
+    static constexpr size_t INITIAL_CAPACITY = 4096;
+
+    /** Chunks of memory (the last one is the one being carved from) */
+    std::vector<std::vector<T, AlignedAllocator<T>>> chunks;
+    /** Number of elements carved from the last chunk */
+    size_t chunk_used;
+    /** Number of elements carved since the last reset (all chunks) */
+    size_t used;
+    /** Maximum number of elements carved between two resets */
+    size_t high_water_mark;
+
+    /**
+     * Add a new chunk big enough for the given number of elements
+     * @param min_size Minimum size of the chunk (in elements)
+     */
+    void add_chunk(size_t min_size);
+
+public:
+    /**
+     * Default constructor
+     * @param capacity Initial capacity (in elements)
+     */
+    explicit BasicWorkspace(size_t capacity = INITIAL_CAPACITY);
+
+    /**
+     * Carve a buffer from the arena (the content is undefined)
+     * The buffer stays valid until the next reset()
+     * @param size Number of elements
+     * @return Pointer to the buffer (aligned to a cache line)
+     */
+    [[nodiscard]] T *allocate(size_t size);
+    /**
+     * Carve a buffer from the arena and fill it with zeros
+     * The buffer stays valid until the next reset()
+     * @param size Number of elements
+     * @return Pointer to the buffer (aligned to a cache line)
+     */
+    [[nodiscard]] T *allocate_zeroed(size_t size);
+    /**
+     * Release all buffers at once (merges the chunks into one, if the arena had to grow)
+     */
+    void reset();
+
+    /**
+     * Get the number of bytes carved since the last reset
+     * @return Number of bytes in use
+     */
+    [[nodiscard]] size_t get_used_bytes() const;
+    /**
+     * Get the maximum number of bytes carved between two resets (use it to size the arena)
+     * @return High-water mark in bytes
+     */
+    [[nodiscard]] size_t get_high_water_mark_bytes() const;
+    /**
+     * Get the number of bytes reserved by the arena (all chunks)
+     * @return Capacity in bytes
+     */
+    [[nodiscard]] size_t get_capacity_bytes() const;
+};
+
+/* Instantiated in Workspace.cpp */
+extern template class BasicWorkspace<float>;
+extern template class BasicWorkspace<double>;
+
+/** Workspace of doubles */
+using Workspace = BasicWorkspace<double>;